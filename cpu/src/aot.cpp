@@ -0,0 +1,636 @@
+/** @file */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "../../lib/logs/log.h"
+
+#include "terminal_colors.h"
+#include "aot.h"
+#include "binary.h"
+
+#define rt_offset(field) (int) offsetof(jit_runtime, field)
+#define align(num, to)   (((num) + (to) - 1) / (to) * (to))
+
+/*===========================================================================================================================*/
+// MAIN
+/*===========================================================================================================================*/
+
+int main(const int argc, const char *argv[])
+{
+    int         data_stack_capacity = DATA_STACK_CAPACITY;
+    int         call_stack_capacity = CALL_STACK_CAPACITY;
+    int         ram_size            = 0;            // 0 - размер из заголовка исполняемого файла
+    const char *execute_file        = nullptr;
+    const char *out_file            = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if      (!strcmp(argv[i], "--data-stack") && i + 1 < argc) data_stack_capacity = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--call-stack") && i + 1 < argc) call_stack_capacity = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ram")        && i + 1 < argc) ram_size            = atoi(argv[++i]);
+        else if (execute_file == nullptr)                          execute_file        = argv[i];
+        else                                                       out_file            = argv[i];
+    }
+    if (execute_file == nullptr || out_file == nullptr || data_stack_capacity <= 0 || call_stack_capacity <= 0 || ram_size < 0)
+    {
+        fprintf(stderr, "you should give execute file and output file: aot [--data-stack N] [--call-stack N] [--ram N] execute_file out_file\n");
+        return 0;
+    }
+
+    binary_file file = {};
+    program     prog = {};
+    jit_code    jit  = {};
+    aot_image   img  = {};
+
+    bool no_err = binary_load(&file, execute_file);
+    if  (no_err && file.header.encoding == ENCODING_REG)
+    {
+        fprintf(stderr, TERMINAL_RED "AOT ERROR: " TERMINAL_CANCEL "register code is not supported, assemble the program without --reg\n");
+        no_err = false;
+    }
+    if  (no_err)  no_err = binary_decode(&prog, &file);
+
+    if (ram_size <= 0) ram_size = file.header.ram_size;
+    if (ram_size <= 0) ram_size = RAM_SIZE;
+    binary_unload(&file);
+
+    if (no_err) no_err = jit_ctor (&jit, &prog);
+    if (no_err) no_err = aot_ctor (&img, &jit, data_stack_capacity, call_stack_capacity, ram_size) && aot_write(&img, out_file);
+
+    aot_dtor    (&img);
+    jit_dtor    (&jit);
+    program_dtor(&prog);
+
+    if (no_err) fprintf(stderr, TERMINAL_GREEN "aot success\n" TERMINAL_CANCEL);
+    else        fprintf(stderr, TERMINAL_RED   "aot failed\n"  TERMINAL_CANCEL);
+}
+
+/*===========================================================================================================================*/
+// AOT
+/*===========================================================================================================================*/
+
+/**
+*   @brief Строит образ исполняемого файла вокруг скомпилированной программы.
+*
+*   @note Программа компилируется тем же jit_compile(), что и для --jit: её код не зависит от адреса,
+*         а все внешние данные получает через jit_runtime (r15). В AOT jit_runtime лежит в сегменте данных
+*         файла и заполнен заранее, а его функции времени исполнения - машинный код в .runtime,
+*         вызывающий scanf/fprintf/sin/cos/log/pow из libc и libm через GOT.
+*/
+
+bool aot_build(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    img->fmt_in      = aot_emit_string(&img->rodata, "%lg");
+    img->fmt_out     = aot_emit_string(&img->rodata, "%lg\n");
+    img->fmt_err     = aot_emit_string(&img->rodata, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "%s\n");
+    img->msg_success = aot_emit_string(&img->rodata, TERMINAL_GREEN "execute success\n" TERMINAL_CANCEL);
+    img->msg_failed  = aot_emit_string(&img->rodata, TERMINAL_RED   "execute failed\n"  TERMINAL_CANCEL);
+
+    for (int err = 0; err < JIT_ERROR_NUMBER; ++err)
+    {
+        img->err_str[err][0] = aot_emit_string(&img->rodata, JIT_ERROR_MESSAGES[err][0]);
+        img->err_str[err][1] = aot_emit_string(&img->rodata, JIT_ERROR_MESSAGES[err][1]);
+    }
+
+    jit_emit_byte(&img->dynstr, 0);
+    for (size_t i = 0; i < sizeof(AOT_LIBRARIES) / sizeof(char *); ++i) img->lib_name[i] = aot_emit_string(&img->dynstr, AOT_LIBRARIES   [i]);
+    for (int    i = 0; i < AOT_SYMBOL_NUMBER                      ; ++i) img->sym_name[i] = aot_emit_string(&img->dynstr, AOT_SYMBOL_NAMES[i]);
+
+    aot_emit_runtime(img);  // размер .runtime не зависит от адресов
+    aot_layout      (img);
+    aot_emit_runtime(img);  // с настоящими адресами
+
+    if ((unsigned long long) img->stack_addr + (unsigned long long) img->data_stack_capacity * sizeof(cpu_type)
+                                             + (unsigned long long) img->ram_size            * sizeof(cpu_type) >= 0x80000000ull)
+    {
+        fprintf(stderr, "data stack and RAM are too big for executable file\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+*   @brief Вычисляет смещения частей файла и их адреса в памяти процесса.
+*/
+
+void aot_layout(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    const int interp_off = (int) (sizeof(Elf64_Ehdr) + AOT_PHDR_NUM * sizeof(Elf64_Phdr));
+    const int hash_size  = (int) sizeof(Elf64_Word) * (2 + 1 + AOT_SYMBOL_NUMBER + 1);
+
+    img->dynstr_off = interp_off + (int) sizeof(AOT_INTERP);
+    img->dynsym_off = align(img->dynstr_off + img->dynstr.size, 8);
+    img->hash_off   = img->dynsym_off + (AOT_SYMBOL_NUMBER + 1) * (int) sizeof(Elf64_Sym);
+    img->rela_off   = align(img->hash_off + hash_size, 8);
+    img->text_off   = align(img->rela_off + AOT_SYMBOL_NUMBER * (int) sizeof(Elf64_Rela), 16);
+    img->rodata_off = img->text_off + img->runtime.size + img->program->size;
+    img->data_off   = align(img->rodata_off + img->rodata.size, (int) AOT_PAGE);
+
+    img->text_addr      = AOT_BASE + (unsigned) img->text_off;
+    img->rodata_addr    = AOT_BASE + (unsigned) img->rodata_off;
+    img->data_addr      = AOT_BASE + (unsigned) img->data_off;
+    img->got_addr       = img->data_addr      + align((unsigned) sizeof(jit_runtime), 16u);
+    img->err_table_addr = img->got_addr       + AOT_SYMBOL_NUMBER * (unsigned) sizeof(Elf64_Addr);
+    img->dynamic_addr   = img->err_table_addr + JIT_ERROR_NUMBER  * (unsigned) sizeof(Elf64_Addr) * 2;
+    img->data_file_size = (int) (img->dynamic_addr + AOT_DYN_NUM * (unsigned) sizeof(Elf64_Dyn) - img->data_addr);
+
+    img->machine_addr   = align(img->data_addr    + (unsigned) img->data_file_size, 16u);
+    img->stack_addr     = align(img->machine_addr + (unsigned) sizeof(machine)    , 16u);
+    img->ram_addr       = img->stack_addr + (unsigned) img->data_stack_capacity * (unsigned) sizeof(cpu_type);
+    img->data_mem_size  = (int) (img->ram_addr + (unsigned) img->ram_size * (unsigned) sizeof(cpu_type) - img->data_addr);
+}
+
+void aot_emit_runtime(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    img->runtime.size = 0;
+
+    img->start_pos = img->runtime.size; aot_emit_start  (img);
+    img->main_pos  = img->runtime.size; aot_emit_main   (img);
+                                        aot_emit_helpers(img);
+}
+
+/**
+*   @brief _start: передает main() в __libc_start_main(), как crt1.o.
+*/
+
+void aot_emit_start(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    jit_code *const jit = &img->runtime;
+
+    jit_emit_byte(jit, 0x31); jit_emit_byte(jit, 0xED);                                 // xor  ebp, ebp
+    jit_emit_reg (jit, 0, true, 0x89, 1, X86_RDX, 9);                                   // mov  r9, rdx   (rtld_fini)
+    jit_emit_byte(jit, 0x5E);                                                           // pop  rsi       (argc)
+    jit_emit_reg (jit, 0, true, 0x89, 1, X86_RSP, X86_RDX);                             // mov  rdx, rsp  (argv)
+    jit_emit_reg (jit, 0, true, 0x83, 1, 4, X86_RSP); jit_emit_byte(jit, 0xF0);         // and  rsp, -16
+    jit_emit_byte(jit, 0x50);                                                           // push rax
+    jit_emit_byte(jit, 0x54);                                                           // push rsp       (stack_end)
+    jit_emit_byte(jit, 0x45); jit_emit_byte(jit, 0x31); jit_emit_byte(jit, 0xC0);       // xor  r8d, r8d  (fini)
+    jit_emit_byte(jit, 0x31); jit_emit_byte(jit, 0xC9);                                 // xor  ecx, ecx  (init)
+    jit_emit_byte(jit, 0xBF); jit_emit_int (jit, (int) (img->text_addr + (unsigned) img->main_pos));  // mov edi, main
+    aot_emit_abs (jit, false, 0xFF, 2, img->got_addr + AOT_LIBC_START_MAIN * 8);        // call [__libc_start_main]
+    jit_emit_byte(jit, 0xF4);                                                           // hlt
+}
+
+/**
+*   @brief main: исполняет программу и сообщает результат так же, как machine.
+*
+*   @note Программа исполняется на отдельном стеке на call_stack_capacity вызовов с защитной страницей
+*         (см. jit_stack_ctor()), он отображается системными вызовами mmap и mprotect.
+*/
+
+void aot_emit_main(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    jit_code *const jit = &img->runtime;
+
+    const size_t stack_size  = jit_stack_size(img->call_stack_capacity, AOT_PAGE);
+    const int    stack_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK;
+
+    jit_emit_byte(jit, 0x53);                                                           // push rbx
+    jit_emit_byte(jit, 0xB8); jit_emit_int (jit, 9);                                    // mov  eax, SYS_mmap
+    jit_emit_byte(jit, 0x31); jit_emit_byte(jit, 0xFF);                                 // xor  edi, edi
+    jit_emit_byte(jit, 0x48); jit_emit_byte(jit, 0xBE); jit_emit_long(jit, (long long) stack_size);  // mov rsi, stack_size
+    jit_emit_byte(jit, 0xBA); jit_emit_int (jit, PROT_READ | PROT_WRITE);               // mov  edx, prot
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0xBA); jit_emit_int(jit, stack_flags); // mov  r10d, flags
+    jit_emit_byte(jit, 0x49); jit_emit_byte(jit, 0xC7); jit_emit_byte(jit, 0xC0); jit_emit_int(jit, -1);  // mov r8, -1
+    jit_emit_byte(jit, 0x45); jit_emit_byte(jit, 0x31); jit_emit_byte(jit, 0xC9);       // xor  r9d, r9d
+    jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, 0x05);                                 // syscall
+    jit_emit_byte(jit, 0x48); jit_emit_byte(jit, 0x3D); jit_emit_int(jit, -4096);       // cmp  rax, -4096
+    const int map_failed = aot_emit_jump8(jit, 0x77);                                   // ja   no_stack
+
+    jit_emit_reg (jit, 0, true, 0x89, 1, X86_RAX, X86_RBX);                             // mov  rbx, rax
+    jit_emit_reg (jit, 0, true, 0x89, 1, X86_RAX, X86_RDI);                             // mov  rdi, rax
+    jit_emit_byte(jit, 0xB8); jit_emit_int (jit, 10);                                   // mov  eax, SYS_mprotect
+    jit_emit_byte(jit, 0xBE); jit_emit_int (jit, (int) AOT_PAGE);                       // mov  esi, page
+    jit_emit_byte(jit, 0x31); jit_emit_byte(jit, 0xD2);                                 // xor  edx, edx (PROT_NONE)
+    jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, 0x05);                                 // syscall
+    jit_emit_byte(jit, 0x85); jit_emit_byte(jit, 0xC0);                                 // test eax, eax
+    const int guard_failed = aot_emit_jump8(jit, 0x75);                                 // jne  no_stack
+
+    jit_emit_byte(jit, 0x48); jit_emit_byte(jit, 0xB8); jit_emit_long(jit, (long long) stack_size);  // mov rax, stack_size
+    jit_emit_reg (jit, 0, true, 0x01, 1, X86_RBX, X86_RAX);                             // add  rax, rbx
+    aot_emit_abs (jit, true, 0x89, X86_RAX, img->data_addr + (unsigned) rt_offset(stack_top));  // mov [rt + stack_top], rax
+    jit_emit_byte(jit, 0xBF); jit_emit_int(jit, (int) img->data_addr);                  // mov  edi, rt
+    jit_emit_byte(jit, 0xB8); jit_emit_int(jit, (int) (img->rodata_addr - (unsigned) img->program->size));  // mov eax, program (после .runtime)
+    jit_emit_byte(jit, 0xFF); jit_emit_byte(jit, 0xD0);                                 // call rax
+    const int executed = aot_emit_jump8(jit, 0xEB);                                     // jmp  check
+
+    aot_patch_jump8(jit, map_failed);
+    aot_patch_jump8(jit, guard_failed);
+    aot_emit_abs   (jit, false, 0xC7, 0, img->data_addr + (unsigned) rt_offset(error)); // mov  dword [rt + error], err
+    jit_emit_int   (jit, JIT_CALL_STACK_MAP);
+
+    aot_patch_jump8(jit, executed);
+    aot_emit_abs (jit, false, 0x8B, X86_RAX, img->data_addr + (unsigned) rt_offset(error));  // mov eax, [rt + error]
+    jit_emit_byte(jit, 0x85); jit_emit_byte(jit, 0xC0);                                 // test eax, eax
+
+    const int failed = aot_emit_jump8(jit, 0x75);                                       // jne  failed
+    aot_emit_stderr(img);
+    jit_emit_byte  (jit, 0xBE); jit_emit_int(jit, (int) (img->rodata_addr + (unsigned) img->msg_success));
+    jit_emit_byte  (jit, 0x31); jit_emit_byte(jit, 0xC0);                               // xor  eax, eax
+    aot_emit_abs   (jit, false, 0xFF, 2, img->got_addr + AOT_FPRINTF * 8);              // call [fprintf]
+    jit_emit_byte  (jit, 0x31); jit_emit_byte(jit, 0xC0);                               // xor  eax, eax
+    jit_emit_byte  (jit, 0x5B);                                                         // pop  rbx
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+
+    aot_patch_jump8(jit, failed);
+    jit_emit_byte  (jit, 0xC1); jit_emit_byte(jit, 0xE0); jit_emit_byte(jit, 0x04);     // shl  eax, 4
+    jit_emit_mem   (jit, 0, true, 0x8B, 1, X86_RDX, X86_RAX, -1, (int)  img->err_table_addr);      // mov rdx, [err_table + rax]
+    jit_emit_mem   (jit, 0, true, 0x8B, 1, X86_RCX, X86_RAX, -1, (int) (img->err_table_addr + 8)); // mov rcx, [err_table + rax + 8]
+    aot_emit_stderr(img);
+    jit_emit_byte  (jit, 0xBE); jit_emit_int(jit, (int) (img->rodata_addr + (unsigned) img->fmt_err));
+    jit_emit_byte  (jit, 0x31); jit_emit_byte(jit, 0xC0);                               // xor  eax, eax
+    aot_emit_abs   (jit, false, 0xFF, 2, img->got_addr + AOT_FPRINTF * 8);              // call [fprintf]
+    aot_emit_stderr(img);
+    jit_emit_byte  (jit, 0xBE); jit_emit_int(jit, (int) (img->rodata_addr + (unsigned) img->msg_failed));
+    jit_emit_byte  (jit, 0x31); jit_emit_byte(jit, 0xC0);                               // xor  eax, eax
+    aot_emit_abs   (jit, false, 0xFF, 2, img->got_addr + AOT_FPRINTF * 8);              // call [fprintf]
+    jit_emit_byte  (jit, 0x31); jit_emit_byte(jit, 0xC0);                               // xor  eax, eax
+    jit_emit_byte  (jit, 0x5B);                                                         // pop  rbx
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+}
+
+/**
+*   @brief Функции времени исполнения с интерфейсом jit_helper_*(): rdi = rt, xmm0, xmm1 - операнды, xmm0 - результат.
+*/
+
+void aot_emit_helpers(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    jit_code *const jit = &img->runtime;
+
+    img->helper_pos[AOT_HELPER_IN] = jit->size;
+    jit_emit_reg   (jit, 0, true, 0x83, 1, 5, X86_RSP); jit_emit_byte(jit, 24);         // sub  rsp, 24
+    jit_emit_mem   (jit, 0, true, 0x89, 1, X86_RDI, X86_RSP, -1, 8);                    // mov  [rsp + 8], rdi
+    jit_emit_mem   (jit, 0, true, 0xC7, 1, 0, X86_RSP, -1, 0); jit_emit_int(jit, 0);    // mov  qword [rsp], 0
+    jit_emit_reg   (jit, 0, true, 0x89, 1, X86_RSP, X86_RSI);                           // mov  rsi, rsp
+    jit_emit_byte  (jit, 0xBF); jit_emit_int(jit, (int) (img->rodata_addr + (unsigned) img->fmt_in));
+    jit_emit_byte  (jit, 0x31); jit_emit_byte(jit, 0xC0);                               // xor  eax, eax
+    aot_emit_abs   (jit, false, 0xFF, 2, img->got_addr + AOT_SCANF * 8);                // call [scanf]
+    jit_emit_mem   (jit, 0, true, 0x8B, 1, X86_RDI, X86_RSP, -1, 8);                    // mov  rdi, [rsp + 8]
+    jit_emit_byte  (jit, 0x83); jit_emit_byte(jit, 0xF8); jit_emit_byte(jit, 0x01);     // cmp  eax, 1
+    const int in_ok = aot_emit_jump8(jit, 0x74);                                        // je   ok
+    aot_emit_error (jit, JIT_IN_VALUE);
+    aot_patch_jump8(jit, in_ok);
+    jit_emit_mem   (jit, 0xF2, false, 0x0F10, 2, 0, X86_RSP, -1, 0);                    // movsd xmm0, [rsp]
+    jit_emit_reg   (jit, 0, true, 0x83, 1, 0, X86_RSP); jit_emit_byte(jit, 24);         // add  rsp, 24
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+
+    img->helper_pos[AOT_HELPER_OUT] = jit->size;
+    jit_emit_reg   (jit, 0, true, 0x83, 1, 5, X86_RSP); jit_emit_byte(jit, 8);          // sub  rsp, 8
+    aot_emit_stderr(img);
+    jit_emit_byte  (jit, 0xBE); jit_emit_int(jit, (int) (img->rodata_addr + (unsigned) img->fmt_out));
+    jit_emit_byte  (jit, 0xB8); jit_emit_int(jit, 1);                                   // mov  eax, 1
+    aot_emit_abs   (jit, false, 0xFF, 2, img->got_addr + AOT_FPRINTF * 8);              // call [fprintf]
+    jit_emit_reg   (jit, 0, true, 0x83, 1, 0, X86_RSP); jit_emit_byte(jit, 8);          // add  rsp, 8
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+
+    img->helper_pos[AOT_HELPER_POW] = jit->size;
+    jit_emit_reg   (jit, 0x66, false, 0x0F28, 2, 2, 0);                                 // movapd  xmm2, xmm0
+    jit_emit_mem   (jit, 0x66, false, 0x0F54, 2, 2, X86_RDI, -1, rt_offset(abs_mask));  // andpd   xmm2, [abs_mask]
+    jit_emit_mem   (jit, 0xF2, false, 0x0F10, 2, 3, X86_RDI, -1, rt_offset(delta));     // movsd   xmm3, [delta]
+    jit_emit_reg   (jit, 0x66, false, 0x0F2E, 2, 3, 2);                                 // ucomisd xmm3, xmm2
+    const int pow_base = aot_emit_jump8(jit, 0x72);                                     // jb      base (!approx_equal(num1, 0))
+    jit_emit_reg   (jit, 0x66, false, 0x0F57, 2, 2, 2);                                 // xorpd   xmm2, xmm2
+    jit_emit_reg   (jit, 0x66, false, 0x0F2E, 2, 2, 1);                                 // ucomisd xmm2, xmm1
+    const int pow_zero = aot_emit_jump8(jit, 0x77);                                     // ja      zero (num2 < 0)
+    aot_patch_jump8(jit, pow_base);
+    jit_emit_reg   (jit, 0x66, false, 0x0F57, 2, 2, 2);                                 // xorpd   xmm2, xmm2
+    jit_emit_reg   (jit, 0x66, false, 0x0F2E, 2, 2, 0);                                 // ucomisd xmm2, xmm0
+    const int pow_less = aot_emit_jump8(jit, 0x77);                                     // ja      less (num1 < 0)
+    aot_emit_abs   (jit, false, 0xFF, 4, img->got_addr + AOT_POW * 8);                  // jmp     [pow]
+    aot_patch_jump8(jit, pow_zero);
+    aot_emit_error (jit, JIT_POW_ZERO);
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+    aot_patch_jump8(jit, pow_less);
+    aot_emit_error (jit, JIT_POW_BASE);
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+
+    img->helper_pos[AOT_HELPER_SQRT] = jit->size;
+    jit_emit_reg   (jit, 0x66, false, 0x0F57, 2, 1, 1);                                 // xorpd   xmm1, xmm1
+    jit_emit_reg   (jit, 0x66, false, 0x0F2E, 2, 1, 0);                                 // ucomisd xmm1, xmm0
+    const int sqrt_less = aot_emit_jump8(jit, 0x77);                                    // ja      less (num < 0)
+    jit_emit_reg   (jit, 0xF2, false, 0x0F51, 2, 0, 0);                                 // sqrtsd  xmm0, xmm0
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+    aot_patch_jump8(jit, sqrt_less);
+    aot_emit_error (jit, JIT_SQRT_DOMAIN);
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+
+    img->helper_pos[AOT_HELPER_SIN] = jit->size;
+    aot_emit_abs   (jit, false, 0xFF, 4, img->got_addr + AOT_SIN * 8);                  // jmp [sin]
+
+    img->helper_pos[AOT_HELPER_COS] = jit->size;
+    aot_emit_abs   (jit, false, 0xFF, 4, img->got_addr + AOT_COS * 8);                  // jmp [cos]
+
+    img->helper_pos[AOT_HELPER_LOG] = jit->size;
+    jit_emit_mem   (jit, 0xF2, false, 0x0F10, 2, 1, X86_RDI, -1, rt_offset(delta));     // movsd   xmm1, [delta]
+    jit_emit_reg   (jit, 0x66, false, 0x0F2E, 2, 1, 0);                                 // ucomisd xmm1, xmm0
+    const int log_less = aot_emit_jump8(jit, 0x73);                                     // jae     less (num < 0 || approx_equal(num, 0))
+    aot_emit_abs   (jit, false, 0xFF, 4, img->got_addr + AOT_LOG * 8);                  // jmp     [log]
+    aot_patch_jump8(jit, log_less);
+    aot_emit_error (jit, JIT_LOG_DOMAIN);
+    jit_emit_byte  (jit, 0xC3);                                                         // ret
+}
+
+/**
+*   @brief Записывает образ в исполняемый файл ELF.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool aot_write(const aot_image *const img, const char *const out_file)
+{
+    assert(img      != nullptr);
+    assert(out_file != nullptr);
+
+    const size_t file_size = (size_t) img->data_off + (size_t) img->data_file_size;
+
+    unsigned char *file = (unsigned char *) log_calloc(file_size, sizeof(unsigned char));
+    if (file == nullptr)
+    {
+        log_error("can't allocate memory for executable file(%d)\n", __LINE__);
+        return false;
+    }
+
+    Elf64_Ehdr ehdr = {};
+
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS]   = ELFCLASS64;
+    ehdr.e_ident[EI_DATA]    = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI]   = ELFOSABI_SYSV;
+    ehdr.e_type              = ET_EXEC;
+    ehdr.e_machine           = EM_X86_64;
+    ehdr.e_version           = EV_CURRENT;
+    ehdr.e_entry             = img->text_addr + (unsigned) img->start_pos;
+    ehdr.e_phoff             = sizeof(Elf64_Ehdr);
+    ehdr.e_ehsize            = sizeof(Elf64_Ehdr);
+    ehdr.e_phentsize         = sizeof(Elf64_Phdr);
+    ehdr.e_phnum             = AOT_PHDR_NUM;
+    memcpy(file, &ehdr, sizeof(Elf64_Ehdr));
+
+    const Elf64_Off interp_off  = sizeof(Elf64_Ehdr) + AOT_PHDR_NUM * sizeof(Elf64_Phdr);
+    const Elf64_Off dynamic_off = (Elf64_Off) img->data_off + (img->dynamic_addr - img->data_addr);
+    const Elf64_Off text_end    = (Elf64_Off) img->rodata_off + (Elf64_Off) img->rodata.size;
+
+    const Elf64_Phdr phdr[AOT_PHDR_NUM] =
+    {
+        {PT_PHDR     , PF_R       , sizeof(Elf64_Ehdr), AOT_BASE + sizeof(Elf64_Ehdr), AOT_BASE + sizeof(Elf64_Ehdr),
+                                    AOT_PHDR_NUM * sizeof(Elf64_Phdr), AOT_PHDR_NUM * sizeof(Elf64_Phdr), 8},
+        {PT_INTERP   , PF_R       , interp_off        , AOT_BASE + interp_off        , AOT_BASE + interp_off        ,
+                                    sizeof(AOT_INTERP), sizeof(AOT_INTERP), 1},
+        {PT_LOAD     , PF_R | PF_X, 0                 , AOT_BASE                     , AOT_BASE                     ,
+                                    text_end, text_end, AOT_PAGE},
+        {PT_LOAD     , PF_R | PF_W, (Elf64_Off) img->data_off, img->data_addr, img->data_addr,
+                                    (Elf64_Xword) img->data_file_size, (Elf64_Xword) img->data_mem_size, AOT_PAGE},
+        {PT_DYNAMIC  , PF_R | PF_W, dynamic_off       , img->dynamic_addr            , img->dynamic_addr            ,
+                                    AOT_DYN_NUM * sizeof(Elf64_Dyn), AOT_DYN_NUM * sizeof(Elf64_Dyn), 8},
+        {PT_GNU_STACK, PF_R | PF_W, 0, 0, 0, 0, 0, 16},
+    };
+    memcpy(file + sizeof(Elf64_Ehdr), phdr, sizeof(phdr));
+
+    memcpy(file + interp_off     , AOT_INTERP       , sizeof(AOT_INTERP));
+    memcpy(file + img->dynstr_off, img->dynstr.code , (size_t) img->dynstr.size);
+
+    for (int i = 0; i < AOT_SYMBOL_NUMBER; ++i)
+    {
+        Elf64_Sym sym = {};
+        sym.st_name   = (Elf64_Word) img->sym_name[i];
+        sym.st_info   = ELF64_ST_INFO(STB_GLOBAL, (i == AOT_STDERR) ? STT_OBJECT : STT_FUNC);
+        memcpy(file + img->dynsym_off + (i + 1) * (int) sizeof(Elf64_Sym), &sym, sizeof(Elf64_Sym));
+
+        Elf64_Rela rela = {};
+        rela.r_offset   = img->got_addr + (unsigned) i * (unsigned) sizeof(Elf64_Addr);
+        rela.r_info     = ELF64_R_INFO((unsigned) i + 1, R_X86_64_GLOB_DAT);
+        memcpy(file + img->rela_off + i * (int) sizeof(Elf64_Rela), &rela, sizeof(Elf64_Rela));
+    }
+
+    // DT_HASH из одной пустой корзины: исполняемый файл сам не экспортирует символов
+    const Elf64_Word hash_header[2] = {1, AOT_SYMBOL_NUMBER + 1};
+    memcpy(file + img->hash_off, hash_header, sizeof(hash_header));
+
+    memcpy(file + img->text_off                     , img->runtime.code , (size_t) img->runtime.size);
+    memcpy(file + img->text_off + img->runtime.size , img->program->code, (size_t) img->program->size);
+    memcpy(file + img->rodata_off                   , img->rodata.code  , (size_t) img->rodata.size);
+
+    aot_write_data(img, file + img->data_off);
+
+    FILE *stream = fopen(out_file, "wb");
+    if  (stream == nullptr)
+    {
+        fprintf (stderr, "can't open output file \"%s\"\n", out_file);
+        log_free(file);
+        return false;
+    }
+    bool no_err = fwrite(file, sizeof(unsigned char), file_size, stream) == file_size;
+
+    fclose  (stream);
+    log_free(file);
+
+    if (no_err) no_err = chmod(out_file, 0755) == 0;
+    return no_err;
+}
+
+/**
+*   @brief Заполняет сегмент данных: jit_runtime, GOT (заполняет загрузчик), таблицу сообщений об ошибках и .dynamic.
+*/
+
+void aot_write_data(const aot_image *const img, unsigned char *const data)
+{
+    assert(img  != nullptr);
+    assert(data != nullptr);
+
+    const unsigned long long abs_mask = 0x7FFFFFFFFFFFFFFFull;
+    const double             delta    = 0.0001; // как в approx_equal()
+
+    aot_put_long(data + rt_offset(abs_mask)     , abs_mask);
+    aot_put_long(data + rt_offset(abs_mask) + 8 , abs_mask);
+    memcpy      (data + rt_offset(delta)        , &delta, sizeof(double));
+    aot_put_long(data + rt_offset(computer)     , img->machine_addr);
+    aot_put_long(data + rt_offset(data)         , img->stack_addr);
+    aot_put_long(data + rt_offset(data_end)     , img->stack_addr + (unsigned) img->data_stack_capacity * (unsigned) sizeof(cpu_type));
+    aot_put_long(data + rt_offset(ram)          , img->ram_addr);
+    memcpy      (data + rt_offset(ram_size)     , &img->ram_size, sizeof(int));
+    aot_put_long(data + rt_offset(call_capacity), (unsigned long long) img->call_stack_capacity);
+
+    const int helper_offset[AOT_HELPER_NUMBER] =
+    {
+        rt_offset(in), rt_offset(out), rt_offset(pow), rt_offset(sqrt), rt_offset(sin), rt_offset(cos), rt_offset(log),
+    };
+    for (int i = 0; i < AOT_HELPER_NUMBER; ++i)
+    {
+        aot_put_long(data + helper_offset[i], img->text_addr + (unsigned) img->helper_pos[i]);
+    }
+
+    unsigned char *err_table = data + (img->err_table_addr - img->data_addr);
+    for (int err = 0; err < JIT_ERROR_NUMBER; ++err)
+    {
+        aot_put_long(err_table + 16 * err    , img->rodata_addr + (unsigned) img->err_str[err][0]);
+        aot_put_long(err_table + 16 * err + 8, img->rodata_addr + (unsigned) img->err_str[err][1]);
+    }
+
+    const Elf64_Dyn dynamic[AOT_DYN_NUM] =
+    {
+        {DT_NEEDED , {(Elf64_Xword) img->lib_name[0]}},
+        {DT_NEEDED , {(Elf64_Xword) img->lib_name[1]}},
+        {DT_HASH   , {AOT_BASE + (Elf64_Xword) img->hash_off  }},
+        {DT_STRTAB , {AOT_BASE + (Elf64_Xword) img->dynstr_off}},
+        {DT_SYMTAB , {AOT_BASE + (Elf64_Xword) img->dynsym_off}},
+        {DT_STRSZ  , {(Elf64_Xword) img->dynstr.size}},
+        {DT_SYMENT , {sizeof(Elf64_Sym)}},
+        {DT_RELA   , {AOT_BASE + (Elf64_Xword) img->rela_off  }},
+        {DT_RELASZ , {AOT_SYMBOL_NUMBER * sizeof(Elf64_Rela)}},
+        {DT_RELAENT, {sizeof(Elf64_Rela)}},
+        {DT_NULL   , {0}},
+    };
+    memcpy(data + (img->dynamic_addr - img->data_addr), dynamic, sizeof(dynamic));
+}
+
+/*===========================================================================================================================*/
+// EMIT
+/*===========================================================================================================================*/
+
+/**
+*   @brief Инструкция с операндом в памяти по абсолютному адресу [disp32].
+*/
+
+void aot_emit_abs(jit_code *const jit, const bool rex_w, const unsigned opcode, const int reg, const unsigned addr)
+{
+    assert(jit != nullptr);
+
+    jit_emit_opcode(jit, 0, rex_w, opcode, 1, reg, 0, -1);
+    jit_emit_byte  (jit, (unsigned char) (((reg & 7) << 3) | 4));   // mod = 00, rm = SIB
+    jit_emit_byte  (jit, 0x25);                                     // без базы и индекса
+    jit_emit_int   (jit, (int) addr);
+}
+
+/**
+*   @brief Короткий переход вперед, смещение заполняется в aot_patch_jump8().
+*
+*   @return позиция смещения в jit->code
+*/
+
+int aot_emit_jump8(jit_code *const jit, const unsigned char opcode)
+{
+    assert(jit != nullptr);
+
+    jit_emit_byte(jit, opcode);
+    jit_emit_byte(jit, 0);
+
+    return jit->size - 1;
+}
+
+void aot_patch_jump8(jit_code *const jit, const int pos)
+{
+    assert(jit != nullptr);
+    assert(jit->size - (pos + 1) < 128);
+
+    jit->code[pos] = (unsigned char) (jit->size - (pos + 1));
+}
+
+/**
+*   @brief mov dword [rdi + error], err
+*/
+
+void aot_emit_error(jit_code *const jit, const JIT_ERROR err)
+{
+    assert(jit != nullptr);
+
+    jit_emit_mem(jit, 0, false, 0xC7, 1, 0, X86_RDI, -1, rt_offset(error));
+    jit_emit_int(jit, err);
+}
+
+/**
+*   @brief mov rdi, stderr
+*/
+
+void aot_emit_stderr(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    aot_emit_abs (&img->runtime, true, 0x8B, X86_RDI, img->got_addr + AOT_STDERR * 8);         // mov rdi, [GOT stderr]
+    jit_emit_byte(&img->runtime, 0x48); jit_emit_byte(&img->runtime, 0x8B); jit_emit_byte(&img->runtime, 0x3F); // mov rdi, [rdi]
+}
+
+/**
+*   @return смещение строки в buf
+*/
+
+int aot_emit_string(jit_code *const buf, const char *const str)
+{
+    assert(buf != nullptr);
+    assert(str != nullptr);
+
+    const int pos = buf->size;
+    for (const char *cur = str; *cur != '\0'; ++cur) jit_emit_byte(buf, (unsigned char) *cur);
+    jit_emit_byte(buf, 0);
+
+    return pos;
+}
+
+void aot_put_long(unsigned char *const dest, const unsigned long long num)
+{
+    assert(dest != nullptr);
+
+    memcpy(dest, &num, sizeof(unsigned long long));
+}
+
+/*===========================================================================================================================*/
+// AOT_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool aot_ctor(aot_image *const img, jit_code *const program, const int data_stack_capacity,
+                                                             const int call_stack_capacity,
+                                                             const int ram_size)
+{
+    assert(img     != nullptr);
+    assert(program != nullptr);
+
+    img->program             = program;
+    img->data_stack_capacity = data_stack_capacity;
+    img->call_stack_capacity = call_stack_capacity;
+    img->ram_size            = ram_size;
+
+    jit_code *const buffers[] = {&img->runtime, &img->rodata, &img->dynstr};
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(jit_code *); ++i)
+    {
+        buffers[i]->capacity = 1024;
+        buffers[i]->code     = (unsigned char *) log_calloc((size_t) buffers[i]->capacity, sizeof(unsigned char));
+
+        if (buffers[i]->code == nullptr)
+        {
+            log_error("can't allocate memory for executable file(%d)\n", __LINE__);
+            return false;
+        }
+    }
+    return aot_build(img);
+}
+
+void aot_dtor(aot_image *const img)
+{
+    assert(img != nullptr);
+
+    jit_dtor(&img->runtime);
+    jit_dtor(&img->rodata);
+    jit_dtor(&img->dynstr);
+
+    *img = {};
+}
+
+#undef rt_offset
+#undef align
@@ -0,0 +1,149 @@
+#ifndef AOT
+#define AOT
+
+#include <elf.h>
+
+#include "jit.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+const unsigned AOT_BASE      = 0x400000;    // адрес загрузки исполняемого файла (ET_EXEC)
+const unsigned AOT_PAGE      = 0x1000;
+const int      AOT_PHDR_NUM  = 6;           // PHDR, INTERP, LOAD (код), LOAD (данные), DYNAMIC, GNU_STACK
+const int      AOT_DYN_NUM   = 11;          // элементов в .dynamic, включая DT_NULL
+
+static const char AOT_INTERP[] = "/lib64/ld-linux-x86-64.so.2";
+
+enum AOT_SYMBOL             // импортируемые символы, порядок совпадает с GOT
+{
+    AOT_LIBC_START_MAIN ,
+    AOT_SCANF           ,
+    AOT_FPRINTF         ,
+    AOT_STDERR          ,
+    AOT_SIN             ,
+    AOT_COS             ,
+    AOT_LOG             ,
+    AOT_POW             ,
+
+    AOT_SYMBOL_NUMBER   ,
+};
+
+static const char *const AOT_SYMBOL_NAMES[] =
+{
+    "__libc_start_main" ,
+    "scanf"             ,
+    "fprintf"           ,
+    "stderr"            ,
+    "sin"               ,
+    "cos"               ,
+    "log"               ,
+    "pow"               ,
+};
+
+static const char *const AOT_LIBRARIES[] =
+{
+    "libc.so.6",
+    "libm.so.6",
+};
+
+enum AOT_HELPER             // функции времени исполнения, на которые указывает jit_runtime
+{
+    AOT_HELPER_IN       ,
+    AOT_HELPER_OUT      ,
+    AOT_HELPER_POW      ,
+    AOT_HELPER_SQRT     ,
+    AOT_HELPER_SIN      ,
+    AOT_HELPER_COS      ,
+    AOT_HELPER_LOG      ,
+
+    AOT_HELPER_NUMBER   ,
+};
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct aot_image                                    // исполняемый файл:
+{                                                   // [заголовки][interp][dynstr][dynsym][hash][rela][runtime][program][rodata]
+    jit_code  runtime;                              // _start, main и функции времени исполнения
+    jit_code  rodata;                               // строки
+    jit_code  dynstr;                               // имена библиотек и символов
+    jit_code *program;                              // скомпилированная программа (см. jit_compile())
+
+    int       data_stack_capacity;
+    int       call_stack_capacity;
+    int       ram_size;                             // количество ячеек RAM (RAM в исполняемом файле не растет)
+
+    int       lib_name[sizeof(AOT_LIBRARIES) / sizeof(char *)];   // смещения в .dynstr
+    int       sym_name[AOT_SYMBOL_NUMBER];                          //
+
+    int       fmt_in;                               // смещения строк в .rodata
+    int       fmt_out;                              //
+    int       fmt_err;                              //
+    int       msg_success;                          //
+    int       msg_failed;                           //
+    int       err_str[JIT_ERROR_NUMBER][2];         //
+
+    int       start_pos;                            // смещения в .runtime
+    int       main_pos;                             //
+    int       helper_pos[AOT_HELPER_NUMBER];        //
+
+    int       dynstr_off;                           // смещения в файле
+    int       dynsym_off;                           //
+    int       hash_off;                             //
+    int       rela_off;                             //
+    int       text_off;                             //
+    int       rodata_off;                           //
+    int       data_off;                             //
+
+    unsigned  text_addr;                            // адреса в памяти процесса
+    unsigned  rodata_addr;                          //
+    unsigned  data_addr;                            // [jit_runtime][GOT][таблица ошибок][dynamic]
+    unsigned  got_addr;                             //
+    unsigned  err_table_addr;                       //
+    unsigned  dynamic_addr;                         //
+    unsigned  machine_addr;                         // .bss: [machine][стек данных][RAM]
+    unsigned  stack_addr;                           //
+    unsigned  ram_addr;                             //
+
+    int       data_file_size;                       // размер сегмента данных в файле
+    int       data_mem_size;                        // размер сегмента данных в памяти
+};
+
+/*===========================================================================================================================*/
+// AOT
+/*===========================================================================================================================*/
+
+bool aot_build          (aot_image *const img);
+void aot_layout         (aot_image *const img);
+void aot_emit_runtime   (aot_image *const img);
+void aot_emit_start     (aot_image *const img);
+void aot_emit_main      (aot_image *const img);
+void aot_emit_helpers   (aot_image *const img);
+bool aot_write          (const aot_image *const img, const char *const out_file);
+void aot_write_data     (const aot_image *const img, unsigned char *const file);
+
+/*===========================================================================================================================*/
+// EMIT
+/*===========================================================================================================================*/
+
+void aot_emit_abs       (jit_code *const jit, const bool rex_w, const unsigned opcode, const int reg, const unsigned addr);
+int  aot_emit_jump8     (jit_code *const jit, const unsigned char opcode);
+void aot_patch_jump8    (jit_code *const jit, const int pos);
+void aot_emit_error     (jit_code *const jit, const JIT_ERROR err);
+void aot_emit_stderr    (aot_image *const img);
+int  aot_emit_string    (jit_code *const buf, const char *const str);
+void aot_put_long       (unsigned char *const dest, const unsigned long long num);
+
+/*===========================================================================================================================*/
+// AOT_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool aot_ctor           (aot_image *const img, jit_code *const program, const int data_stack_capacity,
+                                                                        const int call_stack_capacity,
+                                                                        const int ram_size = RAM_SIZE);
+void aot_dtor           (aot_image *const img);
+
+#endif //AOT
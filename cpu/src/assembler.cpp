@@ -6,6 +6,7 @@
 #include <ctype.h>
 #include <math.h>
 #include <string.h>
+#include <limits.h>
 
 #include "../../lib/logs/log.h"
 #include "../../lib/read_write/read_write.h"
@@ -21,13 +22,33 @@
 
 int main(const int argc, const char *argv[])
 {
-    if (argc != 3)
+    bool        fuse      = true;       // заменять частые последовательности инструкций суперинструкциями
+    bool        reg_code  = false;      // переводить программу в регистровый код (см. reg_lower())
+    bool        aligned   = false;      // записывать код в выровненной кодировке (см. binary_align_code())
+    bool        compact   = false;      // записывать код в компактной кодировке (см. binary_compact_code())
+    bool        strip     = false;      // не записывать таблицы символов и строк
+    int         ram_size  = 0;          // размер RAM в заголовке исполняемого файла (0 - размер по умолчанию)
+    const char *files[2]  = {};         // файл с исходным кодом и исполняемый файл
+    int         files_num = 0;
+
+    for (int i = 1; i < argc; ++i)
     {
-        fprintf(stderr, "You should give two parameters: file to compile and execute file.\n");
+        if      (!strcmp(argv[i], "--no-fuse"))            fuse     = false;
+        else if (!strcmp(argv[i], "--reg"))                reg_code = true;
+        else if (!strcmp(argv[i], "--aligned"))            aligned  = true;
+        else if (!strcmp(argv[i], "--compact"))            compact  = true;
+        else if (!strcmp(argv[i], "--strip"))              strip    = true;
+        else if (!strcmp(argv[i], "--ram") && i + 1 < argc) ram_size = atoi(argv[++i]);
+        else if (files_num < 2)                            files[files_num++] = argv[i];
+        else                                               files_num++;
+    }
+    if (files_num != 2 || ram_size < 0 || (int) reg_code + (int) aligned + (int) compact > 1)
+    {
+        fprintf(stderr, "You should give two parameters: file to compile and execute file: asm [--no-fuse] [--reg | --aligned | --compact] [--strip] [--ram N] source_file execute_file\n");
         return 0;
     }
-    source *code = new_source(argv[1]);
-    FILE *stream = fopen     (argv[2], "w");
+    source *code = new_source(files[0]);
+    FILE *stream = fopen     (files[1], "w");
 
     if (code   == nullptr) { fclose(stream); return 0; }
     if (stream == nullptr)
@@ -44,10 +65,16 @@ int main(const int argc, const char *argv[])
 
     translator my_asm = {};
 
-    if (assembler(code, &my_asm))
+    if (assembler(code, &my_asm, fuse))
     {
-        fwrite (my_asm.cpu.cmd, sizeof(char), (size_t) my_asm.cpu.pc + 1ul, stream);
-        fprintf(stderr, TERMINAL_GREEN "compile success\n" TERMINAL_CANCEL);
+        bool no_err = true;
+
+        if (reg_code) no_err = write_reg_code  (&my_asm, stream, ram_size);
+        else          no_err = write_stack_code(&my_asm, stream, aligned ? ENCODING_ALIGNED :
+                                                                 compact ? ENCODING_COMPACT : ENCODING_STACK, ram_size, strip);
+
+        if (no_err) fprintf(stderr, TERMINAL_GREEN "compile success\n"  TERMINAL_CANCEL);
+        else        fprintf(stderr, TERMINAL_RED "\ncompile faliled\n" TERMINAL_CANCEL);
 
         translator_dtor(&my_asm);
     }
@@ -60,27 +87,29 @@ int main(const int argc, const char *argv[])
 // ASSEMBLER
 /*===========================================================================================================================*/
 
-bool assembler(source *const code, translator *const my_asm)
+bool assembler(source *const code, translator *const my_asm, const bool fuse)
 {
     assert(code   != nullptr);
     assert(my_asm != nullptr);
 
     translator_ctor(my_asm, code);
+    my_asm->fuse = fuse;
 
-    if (!do_assembler(code, my_asm, 1)) return false;
-    
-    my_asm->cpu.pc = 0;
-    label_text_dump(&my_asm->link);
+    if (!do_assembler(code, my_asm)) return false;
 
-    if (!do_assembler(code, my_asm, 2)) return false;
+    label_text_dump(&my_asm->link);
 
-    return true;
+    return backpatch_labels(my_asm);
 }
 
-bool do_assembler(source *const code, translator *const my_asm, const int asm_num) //asm_num for name of labels after their calling
+/**
+*   @brief Транслирует код за один проход. Переходы на метки, определенные ниже, запоминаются в my_asm->link.fixup
+*          и заполняются backpatch_labels().
+*/
+
+bool do_assembler(source *const code, translator *const my_asm)
 {
     log_header(__PRETTY_FUNCTION__);
-    log_message("asm_num=%d\n", asm_num);
 
     assert(code   != nullptr);
     assert(my_asm != nullptr);
@@ -93,7 +122,8 @@ bool do_assembler(source *const code, translator *const my_asm, const int asm_nu
 
         switch(lexis_data[token_cnt].type)
         {
-            case INSTRUCTION: cur_no_err = translate_instruction(my_asm, &token_cnt, asm_num);
+            case INSTRUCTION: add_source_line    (my_asm, lexis_data[token_cnt].token_line);
+                              cur_no_err = translate_instruction(my_asm, &token_cnt);
                               break;
             case DBL_NUM    :
             case INT_NUM    : fprintf(stderr, "line %-5d" TERMINAL_RED " ERROR: " TERMINAL_CANCEL "number can't be the instruction or label\n", lexis_data[token_cnt++].token_line);
@@ -122,6 +152,34 @@ bool do_assembler(source *const code, translator *const my_asm, const int asm_nu
     return false;
 }
 
+/**
+*   @brief Записывает адреса меток в переходы, оттранслированные раньше определения своей метки.
+*/
+
+bool backpatch_labels(translator *const my_asm)
+{
+    assert(my_asm != nullptr);
+
+    bool no_err = true;
+
+    for (int i = 0; i < my_asm->link.fixup_size; ++i)
+    {
+        int       token_num = my_asm->link.fixup[i].token_num;
+        const int link_pc   = get_label_pc(my_asm, &token_num);
+
+        if (link_pc == -1)
+        {
+            fprintf(stderr, "line %-5d" TERMINAL_RED " ERROR: " TERMINAL_CANCEL "undefined label\n", my_asm->lexis_data[token_num].token_line);
+            no_err = false;
+            continue;
+        }
+        memcpy((char *) my_asm->cpu.cmd + my_asm->link.fixup[i].cmd_pos, &link_pc, sizeof(int));
+    }
+
+    if (!no_err) translator_dtor(my_asm);
+    return no_err;
+}
+
 #define cur_token    my_asm->lexis_data[*token_cnt]
 #define still_inside still_inside_lexis_data(my_asm, token_cnt)
 #define check_inside                                                                                \
@@ -142,11 +200,17 @@ bool do_assembler(source *const code, translator *const my_asm, const int asm_nu
 *   @note Значение по адресу token_cnt увеличивается после обработки очередного токена.
 */
 
-bool translate_instruction(translator *const my_asm, int *const token_cnt, const int asm_num)
+bool translate_instruction(translator *const my_asm, int *const token_cnt)
 {
     assert(my_asm    != nullptr);
     assert(token_cnt != nullptr);
 
+    if (my_asm->fuse)
+    {
+        ASM_CMD super_cmd = get_superinstruction(my_asm, *token_cnt);
+        if (super_cmd != UNDEF_ASM_CMD) return translate_superinstruction(my_asm, token_cnt, super_cmd);
+    }
+
     switch(cur_token.value.instruction)
     {
         case HLT :
@@ -171,8 +235,14 @@ bool translate_instruction(translator *const my_asm, int *const token_cnt, const
         case JB  :
         case JBE :
         case JE  :
-        case JNE : return translate_jump_call    (my_asm, token_cnt, asm_num);
-
+        case JNE : return translate_jump_call    (my_asm, token_cnt, cur_token.value.instruction);
+        case ADDI:
+        case SUBI: return translate_int_alu      (my_asm, token_cnt);
+
+        case ADD_REG:       // суперинструкции не имеют мнемоник и создаются только translate_superinstruction()
+        case JZ     :
+        case ADD_MEM:
+        case MEM_OP :
         case UNDEF_ASM_CMD:
         default           : log_error(         "default case in translate_instruction(): cur_token.value.instruction=%d(%d)\n", cur_token.token_line);
                             assert   (false && "default case in translate_instruction()");
@@ -264,12 +334,61 @@ bool translate_pop(translator *const my_asm, int *const token_cnt)
     return false;
 }
 
-bool translate_jump_call(translator *const my_asm, int *const token_cnt, const int asm_num)
+/**
+*   @brief Переводит целочисленные инструкции вида "addi reg, int".
+*
+*   @note Регистр должен быть целочисленным (REX..RHX), число - целым: операция выполняется в int, без перевода в cpu_type.
+*/
+
+bool translate_int_alu(translator *const my_asm, int *const token_cnt)
+{
+    assert(my_asm    != nullptr);
+    assert(token_cnt != nullptr);
+
+    const unsigned char cmd = cur_token.value.instruction;
+    *token_cnt += 1;
+    check_inside
+
+    if (cur_token.type != REG_NAME || !is_int_reg(cur_token.value.reg_num))
+    {
+        fprintf(stderr, "line %-5d" TERMINAL_RED " ERROR: " TERMINAL_CANCEL "invalid int-reg-arg\n", cur_token.token_line);
+        *token_cnt += 1;
+        return false;
+    }
+    const REGISTER reg_arg = cur_token.value.reg_num;
+    *token_cnt += 1;
+    check_inside
+
+    if (cur_token.type != KEY_CHAR || cur_token.value.key != ',')
+    {
+        fprintf(stderr, "line %-5d" TERMINAL_RED " ERROR: " TERMINAL_CANCEL "skipped \',\' after register\n", cur_token.token_line);
+        *token_cnt += 1;
+        return false;
+    }
+    *token_cnt += 1;
+    check_inside
+
+    if (cur_token.type != INT_NUM)
+    {
+        fprintf(stderr, "line %-5d" TERMINAL_RED " ERROR: " TERMINAL_CANCEL "invalid int-arg\n", cur_token.token_line);
+        *token_cnt += 1;
+        return false;
+    }
+    const int int_arg = cur_token.value.int_num;
+    *token_cnt += 1;
+
+    executer_add_cmd(&my_asm->cpu, &cmd    , sizeof(unsigned char));
+    executer_add_cmd(&my_asm->cpu, &reg_arg, sizeof(REGISTER));
+    executer_add_cmd(&my_asm->cpu, &int_arg, sizeof(int));
+
+    return true;
+}
+
+bool translate_jump_call(translator *const my_asm, int *const token_cnt, const unsigned char cmd)
 {
     assert(my_asm    != nullptr);
     assert(token_cnt != nullptr);
 
-    unsigned char cmd = cur_token.value.instruction;
     *token_cnt += 1;
     check_inside
     
@@ -292,14 +411,10 @@ bool translate_jump_call(translator *const my_asm, int *const token_cnt, const i
         case UNDEF_TOKEN: {
                             int link_pc = get_label_pc(my_asm, token_cnt);
                             executer_add_cmd(&my_asm->cpu, &cmd    , sizeof(unsigned char));
+
+                            if (link_pc == -1) label_store_add_fixup(&my_asm->link, *token_cnt, my_asm->cpu.pc);
                             executer_add_cmd(&my_asm->cpu, &link_pc, sizeof(int));
 
-                            if (link_pc == -1 && asm_num == 2)
-                            {
-                                fprintf(stderr, "line %-5d" TERMINAL_RED " ERROR: " TERMINAL_CANCEL "undefined label\n", cur_token.token_line);
-                                *token_cnt += 1;
-                                return false;
-                            }
                             *token_cnt += 1;
                             return true;
                           }
@@ -591,7 +706,8 @@ bool translate_undef_token(translator *const my_asm, int *const token_cnt)
     }
     if (cur_label_pc == -1)
     {
-        label_store_push(&my_asm->link, *token_cnt, my_asm->cpu.pc);
+        label_store_push(&my_asm->link, *token_cnt, my_asm->buff_data + cur_token.token_beg, cur_token.value.token_len - 1,
+                                                    my_asm->cpu.pc);
     }
     *token_cnt += 1;
     check_inside
@@ -658,6 +774,257 @@ void executer_add_reg_dbl(translator *const my_asm, const unsigned char cmd, con
 #undef still_inside
 #undef check_inside
 
+/*===========================================================================================================================*/
+// SUPERINSTRUCTION
+/*===========================================================================================================================*/
+
+#define token_at(pos) my_asm->lexis_data[pos]
+
+/**
+*   @brief Определяет, начинается ли с токена token_cnt последовательность инструкций, заменяемая суперинструкцией.
+*
+*   @return ADD_REG для "push reg; push num; add | sub; pop reg",
+*           JZ      для "push 0; je label",
+*           ADD_MEM для "push [reg+n]; push [reg+m]; add",
+*           MEM_OP  для "push [reg+n]; push num; add | sub | mul | div",
+*           UNDEF_ASM_CMD, если последовательность не найдена
+*
+*   @note Решение зависит только от токенов, поэтому pc, записанный для метки или заплатки перехода, уже окончателен.
+*         Метка внутри последовательности - отдельный токен, так что через метку инструкции не сливаются.
+*/
+
+ASM_CMD get_superinstruction(const translator *const my_asm, const int token_cnt)
+{
+    assert(my_asm != nullptr);
+
+    if (!is_instruction_token(my_asm, token_cnt, PUSH)) return UNDEF_ASM_CMD;
+
+    double num = 0;
+
+    if (token_cnt + 6 < my_asm->lexis_pos        &&
+        token_at(token_cnt + 1).type == REG_NAME &&
+        is_instruction_token(my_asm, token_cnt + 2, PUSH) && get_num_token(my_asm, token_cnt + 3, &num) &&
+       (is_instruction_token(my_asm, token_cnt + 4, ADD ) || is_instruction_token(my_asm, token_cnt + 4, SUB)) &&
+        is_instruction_token(my_asm, token_cnt + 5, POP ) &&
+        token_at(token_cnt + 6).type == REG_NAME &&
+        token_at(token_cnt + 6).value.reg_num == token_at(token_cnt + 1).value.reg_num)
+    {
+        return ADD_REG;
+    }
+
+    if (get_num_token(my_asm, token_cnt + 1, &num) && !(num < 0) && !(num > 0) &&
+        is_instruction_token(my_asm, token_cnt + 2, JE))
+    {
+        return JZ;
+    }
+
+    REGISTER reg_arg = ERR_REG;
+    int      int_arg = 0;
+
+    if (get_ram_token (my_asm, token_cnt + 1, &reg_arg, &int_arg) && is_instruction_token(my_asm, token_cnt + 6, PUSH) &&
+        get_ram_token (my_asm, token_cnt + 7, &reg_arg, &int_arg) && is_instruction_token(my_asm, token_cnt + 12, ADD) &&
+        token_at(token_cnt + 2).value.reg_num == token_at(token_cnt + 8).value.reg_num)
+    {
+        return ADD_MEM;
+    }
+
+    if (get_ram_token (my_asm, token_cnt + 1, &reg_arg, &int_arg) && is_instruction_token(my_asm, token_cnt + 6, PUSH) &&
+        get_num_token (my_asm, token_cnt + 7, &num)               && SHRT_MIN <= int_arg && int_arg <= SHRT_MAX)
+    {
+        if (is_instruction_token(my_asm, token_cnt + 8, ADD) || is_instruction_token(my_asm, token_cnt + 8, SUB) ||
+            is_instruction_token(my_asm, token_cnt + 8, MUL)) return MEM_OP;
+
+        if (is_instruction_token(my_asm, token_cnt + 8, DIV) && !approx_equal(num, 0)) return MEM_OP; // деление на ноль остается ошибкой DIV
+    }
+    return UNDEF_ASM_CMD;
+}
+
+/**
+*   @brief Переводит последовательность инструкций, найденную get_superinstruction(), в суперинструкцию super_cmd.
+*/
+
+bool translate_superinstruction(translator *const my_asm, int *const token_cnt, const ASM_CMD super_cmd)
+{
+    assert(my_asm    != nullptr);
+    assert(token_cnt != nullptr);
+
+    const unsigned char cmd = super_cmd;
+
+    switch (cmd)
+    {
+        case ADD_REG: {
+                        double   num     = 0;
+                        REGISTER reg_arg = token_at(*token_cnt + 1).value.reg_num;
+
+                        get_num_token(my_asm, *token_cnt + 3, &num);
+                        if (token_at(*token_cnt + 4).value.instruction == SUB) num = -num;
+
+                        executer_add_cmd(&my_asm->cpu, &cmd    , sizeof(unsigned char));
+                        executer_add_cmd(&my_asm->cpu, &reg_arg, sizeof(REGISTER));
+                        executer_add_cmd(&my_asm->cpu, &num    , sizeof(double));
+
+                        *token_cnt += 7;
+                        return true;
+                      }
+        case JZ     : *token_cnt += 2;
+                      return translate_jump_call(my_asm, token_cnt, cmd);
+
+        case ADD_MEM: {
+                        REGISTER reg_arg = ERR_REG;
+                        int      int_arg = 0;
+
+                        get_ram_token(my_asm, *token_cnt + 1, &reg_arg, &int_arg);
+                        executer_add_cmd(&my_asm->cpu, &cmd    , sizeof(unsigned char));
+                        executer_add_cmd(&my_asm->cpu, &reg_arg, sizeof(REGISTER));
+                        executer_add_cmd(&my_asm->cpu, &int_arg, sizeof(int));
+
+                        get_ram_token(my_asm, *token_cnt + 7, &reg_arg, &int_arg);
+                        executer_add_cmd(&my_asm->cpu, &int_arg, sizeof(int));
+
+                        *token_cnt += 13;
+                        return true;
+                      }
+        case MEM_OP : {
+                        REGISTER      reg_arg = ERR_REG;
+                        int           int_arg = 0;
+                        double        num     = 0;
+                        unsigned char op      = token_at(*token_cnt + 8).value.instruction;
+
+                        get_ram_token(my_asm, *token_cnt + 1, &reg_arg, &int_arg);
+                        get_num_token(my_asm, *token_cnt + 7, &num);
+
+                        executer_add_cmd(&my_asm->cpu, &cmd    , sizeof(unsigned char));
+                        executer_add_cmd(&my_asm->cpu, &op     , sizeof(unsigned char));
+                        executer_add_cmd(&my_asm->cpu, &reg_arg, sizeof(REGISTER));
+                        executer_add_cmd(&my_asm->cpu, &int_arg, sizeof(int));
+                        executer_add_cmd(&my_asm->cpu, &num    , sizeof(double));
+
+                        *token_cnt += 9;
+                        return true;
+                      }
+
+        default     : log_error(         "default case in translate_superinstruction(): super_cmd=%d(%d)\n", super_cmd, __LINE__);
+                      assert   (false && "default case in translate_superinstruction()");
+                      break;
+    }
+    return false;
+}
+
+bool is_instruction_token(const translator *const my_asm, const int pos, const ASM_CMD instruction)
+{
+    assert(my_asm != nullptr);
+
+    return pos < my_asm->lexis_pos && token_at(pos).type == INSTRUCTION && token_at(pos).value.instruction == instruction;
+}
+
+bool is_key_char_token(const translator *const my_asm, const int pos, const char key)
+{
+    assert(my_asm != nullptr);
+
+    return pos < my_asm->lexis_pos && token_at(pos).type == KEY_CHAR && token_at(pos).value.key == key;
+}
+
+/**
+*   @brief Проверяет, что токен pos - число, и кладет его значение по адресу num.
+*/
+
+bool get_num_token(const translator *const my_asm, const int pos, double *const num)
+{
+    assert(my_asm != nullptr);
+    assert(num    != nullptr);
+
+    if (pos >= my_asm->lexis_pos) return false;
+
+    if (token_at(pos).type == INT_NUM) { *num = token_at(pos).value.int_num; return true; }
+    if (token_at(pos).type == DBL_NUM) { *num = token_at(pos).value.dbl_num; return true; }
+
+    return false;
+}
+
+/**
+*   @brief Проверяет, что токены начиная с pos образуют "[reg+int]" с целочисленным регистром.
+*/
+
+bool get_ram_token(const translator *const my_asm, const int pos, REGISTER *const reg_arg, int *const int_arg)
+{
+    assert(my_asm  != nullptr);
+    assert(reg_arg != nullptr);
+    assert(int_arg != nullptr);
+
+    if (!is_key_char_token(my_asm, pos, '[') || !is_key_char_token(my_asm, pos + 2, '+') ||
+        !is_key_char_token(my_asm, pos + 4, ']'))                                          return false;
+
+    if (token_at(pos + 1).type != REG_NAME || !is_int_reg(token_at(pos + 1).value.reg_num)) return false;
+    if (token_at(pos + 3).type != INT_NUM)                                                  return false;
+
+    *reg_arg = token_at(pos + 1).value.reg_num;
+    *int_arg = token_at(pos + 3).value.int_num;
+    return true;
+}
+
+#undef token_at
+
+/*===========================================================================================================================*/
+// WRITE
+/*===========================================================================================================================*/
+
+/**
+*   @brief Записывает собранный стековый код в исполняемый файл (см. binary_write()).
+*
+*   @param encoding [in] - ENCODING_STACK, ENCODING_ALIGNED или ENCODING_COMPACT
+*   @param strip    [in] - не записывать таблицы символов и строк
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool write_stack_code(translator *const my_asm, FILE *const stream, const BINARY_ENCODING encoding, const int ram_size,
+                                                                                                     const bool strip)
+{
+    assert(my_asm != nullptr);
+    assert(stream != nullptr);
+
+    executer     binary = {my_asm->cpu.cmd, my_asm->cpu.pc + 1, 0};  // +1 for HLT in the end
+    binary_image image  = {&binary, encoding, ram_size, &my_asm->link, my_asm->line, my_asm->line_num};
+
+    if (strip) { image.link = nullptr; image.line = nullptr; image.line_num = 0; }
+
+    return binary_write(stream, &image);
+}
+
+/**
+*   @brief Переводит собранный стековый код в регистровый и записывает его в stream.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Смещения регистрового кода не совпадают со стековым, поэтому таблицы символов и строк не записываются.
+*/
+
+bool write_reg_code(translator *const my_asm, FILE *const stream, const int ram_size)
+{
+    assert(my_asm != nullptr);
+    assert(stream != nullptr);
+
+    executer    binary = {my_asm->cpu.cmd, my_asm->cpu.pc + 1, 0};  // +1 for HLT in the end
+    program     prog   = {};
+    reg_program regs   = {};
+    executer    out    = {};
+
+    bool no_err = program_ctor(&prog, &binary) && reg_lower(&regs, &prog) && reg_encode(&regs, &out);
+    if  (no_err)
+    {
+        executer     reg   = {out.cmd, out.pc, 0};
+        binary_image image = {&reg, ENCODING_REG, ram_size, nullptr, nullptr, 0};
+
+        no_err = binary_write(stream, &image);
+    }
+
+    executer_dtor   (&out);
+    reg_program_dtor(&regs);
+    program_dtor    (&prog);
+
+    return no_err;
+}
+
 /*===========================================================================================================================*/
 // TRANSLATOR_CTOR_DTOR
 /*===========================================================================================================================*/
@@ -671,6 +1038,9 @@ void translator_ctor(translator *const my_asm, source *const code)
     
     label_store_ctor(&my_asm->link, get_undef_token_num(code));
     executer_ctor   (&my_asm->cpu , lexis_pos);
+
+    my_asm->line     = (binary_line *) log_calloc((size_t) lexis_pos + 1, sizeof(binary_line));
+    my_asm->line_num = 0;
 }
 
 void translator_dtor(translator *const my_asm)
@@ -680,12 +1050,29 @@ void translator_dtor(translator *const my_asm)
     source_dtor     ( my_asm->code);
     label_store_dtor(&my_asm->link);
     executer_dtor   (&my_asm->cpu );
+    log_free        ( my_asm->line);
 }
 
 /*===========================================================================================================================*/
 // EXTRA FUNCTION
 /*===========================================================================================================================*/
 
+/**
+*   @brief Запоминает строку исходного кода инструкции, которая начнется с текущего pc.
+*
+*   @note Для суперинструкции остается строка ее первой инструкции.
+*/
+
+void add_source_line(translator *const my_asm, const int line)
+{
+    assert(my_asm != nullptr);
+
+    if (my_asm->line == nullptr) return;
+    if (my_asm->line_num > 0 && my_asm->line[my_asm->line_num - 1].pc == my_asm->cpu.pc) return;
+
+    my_asm->line[my_asm->line_num++] = {my_asm->cpu.pc, line};
+}
+
 bool still_inside_lexis_data(const translator *const my_asm, int *const token_cnt)
 {
     assert(my_asm    != nullptr);
@@ -709,9 +1096,9 @@ int get_undef_token_num(const source *const code)   //для подсчета к
 
 #define cur_token my_asm->lexis_data[*token_cnt]
 
-#define cur_label_pc        my_asm->link.store[label_cnt].pc
-#define cur_label_token_num my_asm->link.store[label_cnt].token_num
-#define cur_label_token     my_asm->lexis_data[cur_label_token_num]
+/**
+*   @return адрес метки, имя которой записано в токене *token_cnt, и -1, если метка еще не определена
+*/
 
 int get_label_pc(const translator *const my_asm, int *const token_cnt)
 {
@@ -719,26 +1106,13 @@ int get_label_pc(const translator *const my_asm, int *const token_cnt)
     assert(token_cnt != nullptr);
     assert(cur_token.type == UNDEF_TOKEN);
 
-    for (int label_cnt = 0; label_cnt < my_asm->link.size; ++label_cnt)
-    {
-        if (cur_label_token.value.token_len == cur_token.value.token_len)
-        {
-            if (!strncasecmp(my_asm->buff_data+      cur_token.token_beg,
-                             my_asm->buff_data+cur_label_token.token_beg, (size_t) cur_token.value.token_len-1))
-            {
-                return cur_label_pc;
-            }
-        }
-    }
-    return -1;
+    const int label_num = label_store_find(&my_asm->link, my_asm->buff_data + cur_token.token_beg, cur_token.value.token_len - 1);
+
+    return (label_num == -1) ? -1 : my_asm->link.store[label_num].pc;
 }
 
 #undef cur_token
 
-#undef cur_label_pc
-#undef cur_label_token_num
-#undef cur_label_token
-
 /*===========================================================================================================================*/
 // SOURCE_CTOR_DTOR
 /*===========================================================================================================================*/
@@ -828,7 +1202,7 @@ void lexical_analyzer(source *const code)
             else if (get_dbl_num (lexis_cur_token           ))            create_dbl_token(code, token_beg);
             else
             {
-                ASM_CMD cur_instruction = get_asm_cmd(lexis_cur_token);
+                ASM_CMD cur_instruction = get_asm_cmd(lexis_cur_token, token_len);
 
                 if (cur_instruction == UNDEF_ASM_CMD) create_undef_token      (code, token_beg, token_len);
                 else                                  create_instruction_token(code, token_beg, cur_instruction);
@@ -853,17 +1227,17 @@ int get_another_token(source *const code)
     return token_len;
 }
 
- REGISTER get_reg_name(const char *cur_token, const int token_len)
+/**
+*   @param token_len - длина токена вместе с '\0' (см. get_another_token())
+*/
+
+REGISTER get_reg_name(const char *cur_token, const int token_len)
 {
     assert(cur_token != nullptr);
 
-    if (token_len != REG_NAME_LEN) return ERR_REG;
+    const int reg = perfect_hash_find(REGISTER_HASH, REGISTER_NAMES, cur_token, token_len - 1, true);
 
-    REGISTER reg = ERR_REG;
-    if (tolower(cur_token[0]) == 'r' && tolower(cur_token[2]) == 'x') reg = (REGISTER) (tolower(cur_token[1]) - 'a' + 1);
-
-    if (0 <= reg && reg <= REG_NUMBER) return reg;
-    return reg = ERR_REG;
+    return (reg == -1) ? ERR_REG : (REGISTER) reg;
 }
 
                                         // default ret = nullptr
@@ -895,40 +1269,17 @@ bool get_dbl_num(const char *cur_token, double *const ret)
     return true;
 }
 
-ASM_CMD get_asm_cmd(const char *cur_token)
+/**
+*   @param token_len - длина токена вместе с '\0' (см. get_another_token())
+*/
+
+ASM_CMD get_asm_cmd(const char *cur_token, const int token_len)
 {
     assert(cur_token != nullptr);
 
-    if (!strcasecmp("hlt" , cur_token)) return HLT ;
-    
-    if (!strcasecmp("in"  , cur_token)) return IN  ;
-    if (!strcasecmp("out" , cur_token)) return OUT ;
-
-    if (!strcasecmp("push", cur_token)) return PUSH;
-    if (!strcasecmp("pop" , cur_token)) return POP ;
-
-    if (!strcasecmp("jmp" , cur_token)) return JMP ;
-    if (!strcasecmp("ja"  , cur_token)) return JA  ;
-    if (!strcasecmp("jae" , cur_token)) return JAE ;
-    if (!strcasecmp("jb"  , cur_token)) return JB  ;
-    if (!strcasecmp("jbe" , cur_token)) return JBE ;
-    if (!strcasecmp("je"  , cur_token)) return JE  ;
-    if (!strcasecmp("jne" , cur_token)) return JNE ;
-
-    if (!strcasecmp("call", cur_token)) return CALL;
-    if (!strcasecmp("ret" , cur_token)) return RET ;
-
-    if (!strcasecmp("add" , cur_token)) return ADD ;
-    if (!strcasecmp("sub" , cur_token)) return SUB ;
-    if (!strcasecmp("mul" , cur_token)) return MUL ;
-    if (!strcasecmp("div" , cur_token)) return DIV ;
-    if (!strcasecmp("pow" , cur_token)) return POW ;
-    if (!strcasecmp("sqrt", cur_token)) return SQRT;
-    if (!strcasecmp("sin" , cur_token)) return SIN ;
-    if (!strcasecmp("cos" , cur_token)) return COS ;
-    if (!strcasecmp("log" , cur_token)) return LOG ;
+    const int cmd = perfect_hash_find(ASM_CMD_HASH, ASM_CMD_NAMES, cur_token, token_len - 1, true);
 
-    return UNDEF_ASM_CMD;
+    return (cmd == -1) ? UNDEF_ASM_CMD : (ASM_CMD) cmd;
 }
 
 bool is_key_char(const char char_to_check)
@@ -3,6 +3,9 @@
 
 #include "cpu.h"
 #include "label.h"
+#include "regcode.h"
+#include "binary.h"
+#include "../../lib/perfect_hash/perfect_hash.h"
 
 /*===========================================================================================================================*/
 // DSL
@@ -24,8 +27,7 @@
 const char *LEXIS_GRAPHVIZ_HEADER = "digraph {\n"
                                     "splines=ortho\n"
                                     "node[shape=record, style=\"rounded, filled\", fontsize=8]\n";
-const char *KEY_CHARS             = "[]#:+";
-const int   REG_NAME_LEN          = 4; //including null-character in the end
+const char *KEY_CHARS             = "[]#:+,";
 
 enum TOKEN_TYPE
 {
@@ -47,7 +49,7 @@ const char *TOKEN_TYPE_NAMES[] =
     "UNDEF_TOKEN"   ,
 };
 
-static const char *REGISTER_NAMES[] =
+static constexpr const char *REGISTER_NAMES[] =
 {
     "ERR_REG"   ,
 
@@ -61,39 +63,13 @@ static const char *REGISTER_NAMES[] =
     "RHX"       ,
 };
 
-static const char *ASM_CMD_NAMES[] =
-{
-    "HLT"           ,
-
-    "IN"            ,
-    "OUT"           ,
-
-    "PUSH"          ,
-    "POP"           ,
-
-    "JMP"           ,
-    "JA"            ,
-    "JAE"           ,
-    "JB"            ,
-    "JBE"           ,
-    "JE"            ,
-    "JNE"           ,
-
-    "CALL"          ,
-    "RET"           ,
-
-    "ADD"           ,
-    "SUB"           ,
-    "MUL"           ,
-    "DIV"           ,
-    "POW"           ,
-    "SQRT"          ,
-    "SIN"           ,
-    "COS"           ,
-    "LOG"           ,
-
-    "UNDEF_ASM_CMD" ,
-};
+// таблицы для get_asm_cmd() и get_reg_name(), имена не чувствительны к регистру;
+// суперинструкции выбирает ассемблер (см. translate_superinstruction()), в исходном коде их нет
+static constexpr perfect_hash<64> ASM_CMD_HASH  = perfect_hash_build<64>(ASM_CMD_NAMES , UNDEF_ASM_CMD , ADD_REG, ADDI, true);
+static constexpr perfect_hash<16> REGISTER_HASH = perfect_hash_build<16>(REGISTER_NAMES, REG_NUMBER + 1, ERR_REG, RAX , true);
+
+static_assert(ASM_CMD_HASH .seed != PERFECT_HASH_NO_SEED, "can't build perfect hash for ASM_CMD_NAMES");
+static_assert(REGISTER_HASH.seed != PERFECT_HASH_NO_SEED, "can't build perfect hash for REGISTER_NAMES");
 
 /*===========================================================================================================================*/
 // STRUCT
@@ -142,20 +118,26 @@ struct translator
     source     *code;           // структура с исходным кодом
     label_store link;           // структура с метками
     executer     cpu;           // структура для хранения переведённых инструкций и параметров
+    bool        fuse;           // заменять частые последовательности инструкций суперинструкциями
+
+    binary_line *line;          // строки исходного кода инструкций для таблицы строк исполняемого файла
+    int          line_num;      // размер .line
 };
 
 /*===========================================================================================================================*/
 // ASSEMBLER
 /*===========================================================================================================================*/
 
-bool             assembler(source *const code, translator *const my_asm);
-bool          do_assembler(source *const code, translator *const my_asm, const int asm_num);
+bool             assembler(source *const code, translator *const my_asm, const bool fuse = true);
+bool          do_assembler(source *const code, translator *const my_asm);
+bool      backpatch_labels(translator *const my_asm);
 
-bool          translate_instruction       (translator *const my_asm, int *const token_cnt, const int asm_num);
+bool          translate_instruction       (translator *const my_asm, int *const token_cnt);
 bool          translate_no_parametres     (translator *const my_asm, int *const token_cnt);
 bool          translate_push              (translator *const my_asm, int *const token_cnt);
 bool          translate_pop               (translator *const my_asm, int *const token_cnt);
-bool          translate_jump_call         (translator *const my_asm, int *const token_cnt, const int asm_num);
+bool          translate_int_alu           (translator *const my_asm, int *const token_cnt);
+bool          translate_jump_call         (translator *const my_asm, int *const token_cnt, const unsigned char cmd);
 
 bool          translate_ram               (translator *const my_asm, int *const token_cnt, unsigned char cmd);
 unsigned char translate_reg_int_expretion (translator *const my_asm, int *const token_cnt, REGISTER      *const reg_arg,
@@ -183,6 +165,26 @@ void          executer_add_reg_int        (translator *const my_asm, const unsig
 void          executer_add_reg_dbl        (translator *const my_asm, const unsigned char cmd, const REGISTER reg_arg,
                                                                                               const double   dbl_arg);
 
+/*===========================================================================================================================*/
+// SUPERINSTRUCTION
+/*===========================================================================================================================*/
+
+ASM_CMD get_superinstruction       (const translator *const my_asm, const int token_cnt);
+bool    translate_superinstruction (      translator *const my_asm, int *const token_cnt, const ASM_CMD super_cmd);
+bool    is_instruction_token       (const translator *const my_asm, const int pos, const ASM_CMD instruction);
+bool    is_key_char_token          (const translator *const my_asm, const int pos, const char    key);
+bool    get_num_token              (const translator *const my_asm, const int pos, double   *const num);
+bool    get_ram_token              (const translator *const my_asm, const int pos, REGISTER *const reg_arg,
+                                                                                   int      *const int_arg);
+
+/*===========================================================================================================================*/
+// WRITE
+/*===========================================================================================================================*/
+
+bool write_stack_code (translator *const my_asm, FILE *const stream, const BINARY_ENCODING encoding, const int ram_size,
+                                                                                                     const bool strip);
+bool write_reg_code   (translator *const my_asm, FILE *const stream, const int ram_size);
+
 /*===========================================================================================================================*/
 // TRANSLATOR_CTOR_DTOR
 /*===========================================================================================================================*/
@@ -195,6 +197,7 @@ void translator_dtor (translator *const my_asm);
 /*===========================================================================================================================*/
 
 int  get_undef_token_num     (const source     *const code);
+void add_source_line         (      translator *const my_asm, const int line);
 bool still_inside_lexis_data (const translator *const my_asm, int *const token_cnt);
 int  get_label_pc            (const translator *const my_asm, int *const token_cnt);
 
@@ -215,7 +218,7 @@ void     lexical_analyzer  (source *const code);
 int      get_another_token (source *const code);
 bool     get_int_num       (const char *cur_token, int    *const ret = nullptr);
 bool     get_dbl_num       (const char *cur_token, double *const ret = nullptr);
-ASM_CMD  get_asm_cmd       (const char *cur_token);
+ASM_CMD  get_asm_cmd       (const char *cur_token, const int token_len);
 REGISTER get_reg_name      (const char *cur_token, const int token_len);
 bool     is_key_char       (const char char_to_check);
 bool     is_comment        (source *const code);
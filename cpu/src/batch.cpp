@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../lib/logs/log.h"
+
+#include "terminal_colors.h"
+#include "batch.h"
+
+/*===========================================================================================================================*/
+// BATCH
+/*===========================================================================================================================*/
+
+/**
+*   @brief Исполняет загруженную программу для каждой записи stdin на пуле из thread_number потоков.
+*
+*   @param thread_number - количество потоков (0 - по числу процессоров)
+*
+*   @note Записи и формат вывода - как у execute_server(). У каждого потока своя машина (machine_share_ctor()),
+*         декодированная и скомпилированная программа общая. Вывод каждой записи собирается в памяти
+*         и печатается после исполнения всех записей в порядке ввода, поэтому не зависит от расписания потоков.
+*   @note Как и execute(), освобождает машину.
+*
+*   @return true, если все записи прочитаны и исполнены (возможно, с ошибками времени исполнения)
+*/
+
+bool execute_batch(machine *const computer, const bool jit, const bool threaded, const int thread_number)
+{
+    assert(computer != nullptr);
+
+    const int workers = (thread_number > 0) ? thread_number : (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    vm_server origin = {};
+    batch     bat    = {};
+
+    bool no_err = server_ctor(&origin, computer, jit, threaded) &&
+                  batch_ctor (&bat, computer, (workers > 0) ? workers : 1) &&
+                  batch_read (&bat, stdin) &&
+                  batch_run  (&bat, &origin);
+
+    if (no_err)
+    {
+        batch_write(&bat, computer->io.out);
+
+        long long failed = 0;
+        for (int i = 0; i < bat.worker_number; ++i) failed += bat.worker[i].server.failed;
+
+        log_message("batch: %d records on %d threads, %lld failed\n", bat.record_size, bat.worker_number, failed);
+    }
+
+    batch_dtor  (&bat);
+    server_dtor (&origin);
+    machine_dtor(computer);
+    return no_err;
+}
+
+/**
+*   @brief Читает записи из in до конца ввода или записи SERVER_STOP.
+*/
+
+bool batch_read(batch *const bat, FILE *const in)
+{
+    assert(bat != nullptr);
+    assert(in  != nullptr);
+
+    char   *line     = nullptr;
+    size_t  capacity = 0;
+    ssize_t len      = 0;
+    bool    no_err   = true;
+
+    while (no_err && (len = getline(&line, &capacity, in)) >= 0)
+    {
+        if (len > 0 && line[len - 1] == '\n') line[--len] = '\0';
+        if (!strcmp(line, SERVER_STOP)) break;
+
+        if (bat->record_size == bat->record_capacity)
+        {
+            const int     new_capacity = 2 * bat->record_capacity + 1;
+            batch_record *new_record   = (batch_record *) log_realloc(bat->record, (size_t) new_capacity * sizeof(batch_record));
+            if (new_record == nullptr) { no_err = false; break; }
+
+            bat->record          = new_record;
+            bat->record_capacity = new_capacity;
+        }
+
+        batch_record *rec = bat->record + bat->record_size;
+        *rec = {};
+
+        rec->input = (char *) log_calloc((size_t) len + 1, sizeof(char));
+        if (rec->input == nullptr) { no_err = false; break; }
+
+        memcpy(rec->input, line, (size_t) len + 1);
+        rec->len = (size_t) len;
+        bat->record_size++;
+    }
+    free(line); // выделена getline()
+
+    if (!no_err)
+    {
+        log_error(        "can't allocate memory for batch records(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for batch records\n");
+    }
+    return no_err;
+}
+
+/**
+*   @brief Запускает потоки пула и ждет, пока они исполнят все записи.
+*
+*   @param origin - сервер, загрузивший программу: от него потоки берут скомпилированный код и способ исполнения
+*/
+
+bool batch_run(batch *const bat, const vm_server *const origin)
+{
+    assert(bat    != nullptr);
+    assert(origin != nullptr);
+
+    int started = 0;
+    for (int i = 0; i < bat->worker_number && i < bat->record_size; ++i)
+    {
+        batch_worker *worker = bat->worker + i;
+
+        worker->server.computer = &worker->computer;
+        worker->server.code     = origin->code;
+        worker->server.threaded = origin->threaded;
+
+        worker->started = pthread_create(&worker->thread, nullptr, batch_work, worker) == 0;
+        if (worker->started) started++;
+    }
+
+    if (started == 0 && bat->record_size > 0)
+    {
+        log_message("batch: can't start threads, records are executed by the main thread\n");
+        batch_work(bat->worker);
+    }
+
+    for (int i = 0; i < bat->worker_number; ++i)
+    {
+        if (bat->worker[i].started) pthread_join(bat->worker[i].thread, nullptr);
+    }
+    return true;
+}
+
+/**
+*   @brief Тело потока пула: берет записи по одной, пока они не закончатся.
+*
+*   @param arg - batch_worker потока
+*/
+
+void *batch_work(void *const arg)
+{
+    assert(arg != nullptr);
+
+    batch_worker *const worker = (batch_worker *) arg;
+    batch        *const bat    = worker->owner;
+
+    while (true)
+    {
+        const int index = __atomic_fetch_add(&bat->next, 1, __ATOMIC_RELAXED);
+        if (index >= bat->record_size) break;
+
+        batch_record *rec = bat->record + index;
+
+        FILE *out = open_memstream(&rec->out, &rec->out_size);
+        FILE *err = open_memstream(&rec->err, &rec->err_size);
+
+        if (out != nullptr && err != nullptr)
+        {
+            worker->computer.io.err = err;
+            server_run(&worker->server, rec->input, rec->len, out);
+            worker->computer.io.err = stderr;
+        }
+
+        if (out != nullptr) fclose(out);
+        if (err != nullptr) fclose(err);
+    }
+    return nullptr;
+}
+
+/**
+*   @brief Печатает вывод записей в порядке ввода: результаты в out, сообщения об ошибках в stderr.
+*/
+
+void batch_write(const batch *const bat, FILE *const out)
+{
+    assert(bat != nullptr);
+    assert(out != nullptr);
+
+    for (int i = 0; i < bat->record_size; ++i)
+    {
+        const batch_record *rec = bat->record + i;
+
+        if (rec->err_size != 0) fwrite(rec->err, sizeof(char), rec->err_size, stderr);
+
+        if (rec->out_size != 0) fwrite(rec->out, sizeof(char), rec->out_size, out);
+        else                    fputs (SERVER_FAILED, out);   // запись не удалось исполнить
+    }
+    fflush(out);
+}
+
+/*===========================================================================================================================*/
+// BATCH_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Создает машины потоков пула.
+*
+*   @note Машины создаются в вызывающем потоке: log_calloc() ведет общий счетчик выделенной памяти.
+*/
+
+bool batch_ctor(batch *const bat, const machine *const origin, const int thread_number)
+{
+    assert(bat           != nullptr);
+    assert(origin        != nullptr);
+    assert(thread_number >        0);
+
+    bat->record          = nullptr;
+    bat->record_size     = 0;
+    bat->record_capacity = 0;
+    bat->next            = 0;
+    bat->worker          = (batch_worker *) log_calloc((size_t) thread_number, sizeof(batch_worker));
+    bat->worker_number   = 0;
+
+    if (bat->worker == nullptr)
+    {
+        log_error(        "can't allocate memory for batch workers(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for batch workers\n");
+        return false;
+    }
+
+    for (; bat->worker_number < thread_number; ++bat->worker_number)
+    {
+        batch_worker *worker = bat->worker + bat->worker_number;
+
+        worker->owner = bat;
+        if (!machine_share_ctor(&worker->computer, origin))
+        {
+            machine_dtor(&worker->computer);
+            return false;
+        }
+    }
+    return true;
+}
+
+void batch_dtor(batch *const bat)
+{
+    assert(bat != nullptr);
+
+    for (int i = 0; i < bat->worker_number; ++i)
+    {
+        server_dtor (&bat->worker[i].server);
+        machine_dtor(&bat->worker[i].computer);
+    }
+    log_free(bat->worker);
+
+    for (int i = 0; i < bat->record_size; ++i)
+    {
+        log_free(bat->record[i].input);
+        free    (bat->record[i].out);   // выделены open_memstream()
+        free    (bat->record[i].err);   //
+    }
+    log_free(bat->record);
+
+    *bat = {};
+}
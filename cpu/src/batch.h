@@ -0,0 +1,63 @@
+#ifndef BATCH
+#define BATCH
+
+#include <pthread.h>
+
+#include "server.h"
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct batch_record                     // запись ввода и результат ее исполнения
+{
+    char   *input;                      // строка ввода без '\n'
+    size_t  len;                        // длина .input
+
+    char   *out;                        // вывод исполнения (open_memstream())
+    size_t  out_size;
+    char   *err;                        // сообщения об ошибках исполнения (open_memstream())
+    size_t  err_size;
+};
+
+struct batch;
+
+struct batch_worker                     // поток пула со своей машиной
+{
+    batch     *owner;
+    machine    computer;                // стеки, регистры, RAM и ввод-вывод потока, программа общая
+    vm_server  server;                  // исполняет записи на .computer (см. server_run())
+    pthread_t  thread;
+    bool       started;                 // поток запущен, его нужно дождаться
+};
+
+struct batch                            // пакетное исполнение одной программы на пуле потоков
+{
+    batch_record *record;
+    int           record_size;
+    int           record_capacity;
+    int           next;                 // индекс следующей записи, которую возьмет поток (атомарный)
+
+    batch_worker *worker;
+    int           worker_number;
+};
+
+/*===========================================================================================================================*/
+// BATCH
+/*===========================================================================================================================*/
+
+bool  execute_batch     (machine *const computer, const bool jit, const bool threaded, const int thread_number);
+
+bool  batch_read        (batch *const bat, FILE *const in);
+bool  batch_run         (batch *const bat, const vm_server *const origin);
+void *batch_work        (void *const arg);
+void  batch_write       (const batch *const bat, FILE *const out);
+
+/*===========================================================================================================================*/
+// BATCH_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool  batch_ctor        (batch *const bat, const machine *const origin, const int thread_number);
+void  batch_dtor        (batch *const bat);
+
+#endif //BATCH
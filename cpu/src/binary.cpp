@@ -0,0 +1,767 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../../lib/logs/log.h"
+
+#include "binary.h"
+#include "terminal_colors.h"
+
+/*===========================================================================================================================*/
+// WRITE
+/*===========================================================================================================================*/
+
+/**
+*   @brief Записывает исполняемый файл: заголовок и секции, выровненные по BINARY_ALIGN.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Для ENCODING_STACK действительные операнды выносятся в пул констант без повторов (см. binary_pack_code()),
+*         для ENCODING_ALIGNED код переводится в массив instruction (см. binary_align_code()),
+*         для ENCODING_COMPACT - в плотный байт-код (см. binary_compact_code()).
+*   @note Таблица символов содержит все метки image->link, их имена лежат в секции строк через '\0'.
+*/
+
+bool binary_write(FILE *const stream, const binary_image *const image)
+{
+    assert(stream      != nullptr);
+    assert(image       != nullptr);
+    assert(image->code != nullptr);
+
+    executer packed   = *image->code;
+    double  *pool     = nullptr;
+    int      pool_num = 0;
+    int     *pc_map   = nullptr;        // nullptr - смещения инструкций не меняются
+
+    if (image->encoding == ENCODING_STACK   && !binary_pack_code (image->code, &packed, &pool, &pool_num, &pc_map)) return false;
+    if (image->encoding == ENCODING_ALIGNED && !binary_align_code(image->code, &packed, &pc_map))                  return false;
+    if (image->encoding == ENCODING_COMPACT && !binary_compact_code(image->code, &packed, &pool, &pool_num, &pc_map)) return false;
+
+    const int symbol_num  = (image->link == nullptr) ? 0 : image->link->size;
+    int       string_size = 0;
+
+    for (int i = 0; i < symbol_num; ++i) string_size += image->link->store[i].name_len + 1;
+
+    binary_header header = {};
+    memcpy(header.signature, BINARY_SIGNATURE, sizeof(BINARY_SIGNATURE));
+
+    header.code_offset   = binary_align((int) sizeof(header));
+    header.const_offset  = binary_align(header.code_offset   + packed.capacity);
+    header.symbol_offset = binary_align(header.const_offset  + pool_num   * (int) sizeof(double));
+    header.string_offset = binary_align(header.symbol_offset + symbol_num * (int) sizeof(binary_symbol));
+    header.line_offset   = binary_align(header.string_offset + string_size);
+
+    header.version     = BINARY_VERSION;
+    header.encoding    = image->encoding;
+    header.entry       = 0;
+    header.ram_size    = image->ram_size;
+    header.code_size   = packed.capacity;
+    header.const_num   = pool_num;
+    header.symbol_num  = symbol_num;
+    header.string_size = string_size;
+    header.line_num    = (image->line == nullptr) ? 0 : image->line_num;
+
+    long pos    = 0;
+    bool no_err = fwrite(&header, sizeof(header), 1, stream) == 1;
+    pos += (long) sizeof(header);
+
+    binary_write_pad(stream, &pos);
+    no_err = no_err && fwrite(packed.cmd, sizeof(char), (size_t) packed.capacity, stream) == (size_t) packed.capacity;
+    pos   += packed.capacity;
+
+    binary_write_pad(stream, &pos);
+    no_err = no_err && fwrite(pool, sizeof(double), (size_t) pool_num, stream) == (size_t) pool_num;
+    pos   += (long) ((size_t) pool_num * sizeof(double));
+
+    binary_write_pad(stream, &pos);
+    for (int i = 0, name = 0; i < symbol_num; ++i)
+    {
+        const binary_symbol symbol = {binary_map_pc(pc_map, image->code->capacity, image->link->store[i].pc), name};
+
+        no_err = no_err && fwrite(&symbol, sizeof(symbol), 1, stream) == 1;
+        pos   += (long) sizeof(symbol);
+        name  += image->link->store[i].name_len + 1;
+    }
+
+    binary_write_pad(stream, &pos);
+    for (int i = 0; i < symbol_num; ++i)
+    {
+        no_err = no_err && fwrite(image->link->store[i].name, sizeof(char), (size_t) image->link->store[i].name_len, stream) ==
+                                                                            (size_t) image->link->store[i].name_len;
+        no_err = no_err && fputc('\0', stream) != EOF;
+    }
+    pos += string_size;
+
+    binary_write_pad(stream, &pos);
+    for (int i = 0; i < header.line_num; ++i)
+    {
+        const binary_line line = {binary_map_pc(pc_map, image->code->capacity, image->line[i].pc), image->line[i].line};
+
+        no_err = no_err && fwrite(&line, sizeof(line), 1, stream) == 1;
+    }
+
+    if (image->encoding != ENCODING_REG) executer_dtor(&packed);
+    log_free(pool);
+    log_free(pc_map);
+
+    if (!no_err) fprintf(stderr, TERMINAL_RED "ERROR: " TERMINAL_CANCEL "can't write execute file\n");
+    return no_err;
+}
+
+/**
+*   @brief Заменяет действительные операнды кода индексами в пуле констант, одинаковые числа (побитово) хранятся один раз.
+*
+*   @param packed   [out] - код с индексами вместо чисел (освобождается executer_dtor())
+*   @param pool     [out] - пул констант (освобождается log_free())
+*   @param pc_map   [out] - pc_map[pc] - смещение в packed инструкции со смещением pc в code или -1 (освобождается log_free())
+*
+*   @note Инструкции становятся короче, поэтому метки переходов пересчитываются через pc_map.
+*/
+
+bool binary_pack_code(const executer *const code, executer *const packed, double **const pool, int *const pool_num,
+                                                                                               int  **const pc_map)
+{
+    assert(code     != nullptr);
+    assert(packed   != nullptr);
+    assert(pool     != nullptr);
+    assert(pool_num != nullptr);
+    assert(pc_map   != nullptr);
+
+    int table_size = 1;
+    while (table_size < 2 * code->capacity / (int) sizeof(double) + 2) table_size *= 2;
+
+    *pool_num  = 0;
+    *pool      = (double *) log_calloc((size_t) code->capacity / sizeof(double) + 1, sizeof(double));
+    *pc_map    = (int    *) log_calloc((size_t) code->capacity + 1, sizeof(int));
+    int *table = (int    *) log_calloc((size_t) table_size, sizeof(int));
+
+    executer_ctor(packed, code->capacity / (int) sizeof(cpu_type) + 1);
+
+    if (*pool == nullptr || *pc_map == nullptr || table == nullptr || packed->cmd == nullptr)
+    {
+        log_error("can't allocate memory for constant pool(%d)\n", __LINE__);
+        log_free     (*pool);
+        log_free     (*pc_map);
+        log_free     (table);
+        executer_dtor(packed);
+        *pool   = nullptr;
+        *pc_map = nullptr;
+        return false;
+    }
+    for (int i = 0; i < table_size;      ++i) table  [i] = -1;
+    for (int i = 0; i <= code->capacity; ++i) (*pc_map)[i] = -1;
+
+    const unsigned char *cmd = (const unsigned char *) code->cmd;
+
+    for (int pc = 0, new_pc = 0; pc < code->capacity;)
+    {
+        const int cmd_size = binary_cmd_size(code, pc);
+
+        (*pc_map)[pc] = new_pc;
+        new_pc       += (cmd_size == get_instruction_size(cmd[pc])) ? get_instruction_size(cmd[pc], true) : cmd_size;
+        pc           += cmd_size;
+
+        if (pc == code->capacity) (*pc_map)[pc] = new_pc;
+    }
+
+    for (int pc = 0; pc < code->capacity;)
+    {
+        const int cmd_size = binary_cmd_size(code, pc);
+
+        if (cmd_size != get_instruction_size(cmd[pc]))              // хвост кода копируется как есть
+        {
+            executer_add_cmd(packed, cmd + pc, (size_t) cmd_size);
+        }
+        else if (has_label_operand(cmd[pc]))
+        {
+            int label_pc = 0;
+            memcpy(&label_pc, cmd + pc + 1, sizeof(int));
+
+            if (0 <= label_pc && label_pc <= code->capacity && (*pc_map)[label_pc] != -1) label_pc = (*pc_map)[label_pc];
+            else                                                                          label_pc = -1;
+
+            executer_add_cmd(packed, cmd + pc  , sizeof(unsigned char));
+            executer_add_cmd(packed, &label_pc , sizeof(int));
+        }
+        else if (has_dbl_operand(cmd[pc]))
+        {
+            const int operand = cmd_size - (int) sizeof(double);
+            double    num     = 0;
+            memcpy(&num, cmd + pc + operand, sizeof(double));
+
+            const int index = binary_pool_index(*pool, pool_num, table, table_size, num);
+
+            executer_add_cmd(packed, cmd + pc, (size_t) operand);
+            executer_add_cmd(packed, &index  , sizeof(int));
+        }
+        else executer_add_cmd(packed, cmd + pc, (size_t) cmd_size);
+
+        pc += cmd_size;
+    }
+    packed->capacity = packed->pc;
+
+    log_free(table);
+    return true;
+}
+
+/**
+*   @return размер инструкции со смещением pc или размер оставшегося кода, если инструкция неизвестна или не помещается
+*/
+
+int binary_cmd_size(const executer *const code, const int pc)
+{
+    assert(code != nullptr);
+
+    const int cmd_size = get_instruction_size(((const unsigned char *) code->cmd)[pc]);
+
+    return (cmd_size == -1 || pc + cmd_size > code->capacity) ? code->capacity - pc : cmd_size;
+}
+
+/**
+*   @brief Переводит байт-код в выровненную кодировку: каждая инструкция записывается как instruction (см. decoder.h).
+*
+*   @param aligned  [out] - массив instruction без завершающего HLT-стража (освобождается executer_dtor())
+*   @param pc_map   [out] - pc_map[pc] - смещение в aligned инструкции со смещением pc в code или -1 (освобождается log_free())
+*
+*   @note Операнды лежат по смещениям, кратным своему размеру, а метки уже переведены в индексы инструкций,
+*         поэтому машина загружает код без побайтового разбора (см. program_aligned_ctor()).
+*/
+
+bool binary_align_code(const executer *const code, executer *const aligned, int **const pc_map)
+{
+    assert(code    != nullptr);
+    assert(aligned != nullptr);
+    assert(pc_map  != nullptr);
+
+    executer stack = *code;
+    program  prog  = {};
+
+    if (!program_ctor(&prog, &stack)) return false;
+
+    const int size = prog.size * (int) sizeof(instruction);
+
+    *pc_map = (int *) log_calloc((size_t) code->capacity + 1, sizeof(int));
+    executer_ctor(aligned, size / (int) sizeof(cpu_type) + 1);
+
+    if (*pc_map == nullptr || aligned->cmd == nullptr)
+    {
+        log_error("can't allocate memory for aligned code(%d)\n", __LINE__);
+        log_free     (*pc_map);
+        executer_dtor(aligned);
+        program_dtor (&prog);
+        *pc_map = nullptr;
+        return false;
+    }
+
+    for (int pc = 0; pc <= code->capacity; ++pc) (*pc_map)[pc] = -1;
+    for (int pc = 0, i = 0; pc < code->capacity; ++i)
+    {
+        (*pc_map)[pc] = i * (int) sizeof(instruction);
+        pc           += binary_cmd_size(code, pc);
+    }
+
+    executer_add_cmd(aligned, prog.cmd, (size_t) size);
+    aligned->capacity = aligned->pc;
+
+    program_dtor(&prog);
+    return true;
+}
+
+/**
+*   @brief Переводит байт-код в компактную кодировку (см. decode_compact()).
+*
+*   @param compact  [out] - компактный код (освобождается executer_dtor())
+*   @param pool     [out] - пул констант (освобождается log_free())
+*   @param pc_map   [out] - pc_map[pc] - смещение в compact инструкции со смещением pc в code или -1 (освобождается log_free())
+*
+*   @note push 0..COMPACT_SMALL_MAX и push/pop [reg + off] занимают 1 и 1 + varint байт.
+*   @note Переходы сначала короткие (short); если смещение метки не помещается в short, переход становится длинным,
+*         и раскладка пересчитывается. Переходы только удлиняются, поэтому пересчет заканчивается.
+*/
+
+bool binary_compact_code(const executer *const code, executer *const compact, double **const pool, int *const pool_num,
+                                                                                                   int  **const pc_map)
+{
+    assert(code     != nullptr);
+    assert(compact  != nullptr);
+    assert(pool     != nullptr);
+    assert(pool_num != nullptr);
+    assert(pc_map   != nullptr);
+
+    executer stack = *code;
+    program  prog  = {};
+
+    if (!program_ctor(&prog, &stack)) return false;
+
+    int table_size = 1;
+    while (table_size < 2 * prog.size + 2) table_size *= 2;
+
+    *pool_num     = 0;
+    *pool         = (double *) log_calloc((size_t) prog.size + 1     , sizeof(double));
+    *pc_map       = (int    *) log_calloc((size_t) code->capacity + 1, sizeof(int));
+    int  *table   = (int    *) log_calloc((size_t) table_size        , sizeof(int));
+    int  *offset  = (int    *) log_calloc((size_t) prog.size + 1     , sizeof(int));     // offset[i] - смещение инструкции i
+    int  *constant= (int    *) log_calloc((size_t) prog.size + 1     , sizeof(int));     // индекс в пуле или -1
+    bool *is_long = (bool   *) log_calloc((size_t) prog.size + 1     , sizeof(bool));
+
+    if (*pool == nullptr || *pc_map == nullptr || table == nullptr || offset == nullptr || constant == nullptr || is_long == nullptr)
+    {
+        log_error("can't allocate memory for compact code(%d)\n", __LINE__);
+        log_free(*pool); log_free(*pc_map); log_free(table); log_free(offset); log_free(constant); log_free(is_long);
+        program_dtor(&prog);
+        *pool   = nullptr;
+        *pc_map = nullptr;
+        return false;
+    }
+    for (int i = 0; i < table_size; ++i) table[i] = -1;
+
+    for (int i = 0; i < prog.size; ++i)
+    {
+        const instruction *cur_cmd = prog.cmd + i;
+        const bool         dbl_arg = (cur_cmd->cmd == PUSH && (cur_cmd->param & (1 << PARAM_NUM)) && !(cur_cmd->param & (1 << PARAM_MEM))) ||
+                                      cur_cmd->cmd == ADD_REG || cur_cmd->cmd == MEM_OP;
+
+        constant[i] = dbl_arg ? binary_pool_index(*pool, pool_num, table, table_size, cur_cmd->arg.dbl_num) : -1;
+    }
+
+    unsigned char buff[4 * VARINT_MAX_SIZE] = {};
+
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+
+        for (int i = 0; i < prog.size; ++i) offset[i + 1] = offset[i] + binary_compact_cmd(prog.cmd + i, constant[i], is_long[i], 0, buff);
+        for (int i = 0; i < prog.size; ++i)
+        {
+            if (!has_label_operand(prog.cmd[i].cmd) || is_long[i]) continue;
+
+            const int shift = offset[prog.cmd[i].arg.label] - offset[i];
+            if (shift < SHRT_MIN || shift > SHRT_MAX) is_long[i] = changed = true;
+        }
+    }
+
+    executer_ctor(compact, offset[prog.size] / (int) sizeof(cpu_type) + 1);
+    bool no_err = compact->cmd != nullptr;
+
+    for (int i = 0; no_err && i < prog.size; ++i)
+    {
+        const int shift = has_label_operand(prog.cmd[i].cmd) ? offset[prog.cmd[i].arg.label] - offset[i] : 0;
+        const int size  = binary_compact_cmd(prog.cmd + i, constant[i], is_long[i], shift, buff);
+
+        executer_add_cmd(compact, buff, (size_t) size);
+    }
+    compact->capacity = compact->pc;
+
+    for (int pc = 0; pc <= code->capacity; ++pc) (*pc_map)[pc] = -1;
+    for (int pc = 0, i = 0; pc < code->capacity; ++i)
+    {
+        (*pc_map)[pc] = offset[i];
+        pc           += binary_cmd_size(code, pc);
+    }
+
+    log_free(table);
+    log_free(offset);
+    log_free(constant);
+    log_free(is_long);
+    program_dtor(&prog);
+
+    if (!no_err) log_error("can't allocate memory for compact code(%d)\n", __LINE__);
+    return no_err;
+}
+
+/**
+*   @brief Записывает инструкцию в компактной кодировке в buff.
+*
+*   @param constant  - индекс действительного операнда в пуле констант (-1, если его нет)
+*   @param long_jump - записать смещение метки int, а не short
+*   @param shift     - смещение метки относительно начала инструкции (для переходов)
+*
+*   @return размер записанной инструкции
+*/
+
+int binary_compact_cmd(const instruction *const cur_cmd, const int constant, const bool long_jump, const int shift,
+                                                                                                   unsigned char *const buff)
+{
+    assert(cur_cmd != nullptr);
+    assert(buff    != nullptr);
+
+    const unsigned char mem_arg = (1 << PARAM_MEM) | (1 << PARAM_REG) | (1 << PARAM_NUM);
+    const unsigned char reg     = (unsigned char) cur_cmd->reg;
+    int                 size    = 0;
+
+    if (cur_cmd->cmd == PUSH && cur_cmd->param == (1 << PARAM_NUM))
+    {
+        const double num   = cur_cmd->arg.dbl_num;
+        const int    small = (0 <= num && num <= COMPACT_SMALL_MAX) ? (int) num : -1;
+        const double same  = small;
+
+        if (small != -1 && !memcmp(&same, &num, sizeof(double)))        // -0.0 и дробные числа идут в пул
+        {
+            buff[0] = (unsigned char) (COMPACT_PUSH_SMALL | (small << 5));
+            return 1;
+        }
+    }
+
+    if ((cur_cmd->cmd == PUSH || cur_cmd->cmd == POP) && cur_cmd->param == mem_arg && RAX <= cur_cmd->reg && cur_cmd->reg <= RHX)
+    {
+        buff[size++] = (unsigned char) (((cur_cmd->cmd == PUSH) ? COMPACT_PUSH_MEM : COMPACT_POP_MEM) | ((reg - 1) << 5));
+        return size + binary_put_int(buff + size, cur_cmd->arg.int_num);
+    }
+
+    if (cur_cmd->cmd == PUSH || cur_cmd->cmd == POP)
+    {
+        buff[size++] = (unsigned char) (cur_cmd->cmd | cur_cmd->param);
+
+        if (cur_cmd->param & (1 << PARAM_REG)) buff[size++] = reg;
+        if (cur_cmd->param & (1 << PARAM_NUM))
+        {
+            if (constant == -1) size += binary_put_int   (buff + size, cur_cmd->arg.int_num);
+            else                size += binary_put_varint(buff + size, (unsigned) constant);
+        }
+        return size;
+    }
+
+    if (has_label_operand(cur_cmd->cmd))
+    {
+        buff[size++] = (unsigned char) (cur_cmd->cmd | (long_jump ? COMPACT_LONG_JUMP : 0));
+
+        const short short_shift = (short) shift;
+        if (long_jump) { memcpy(buff + size, &shift      , sizeof(int));   size += (int) sizeof(int);   }
+        else           { memcpy(buff + size, &short_shift, sizeof(short)); size += (int) sizeof(short); }
+        return size;
+    }
+
+    buff[size++] = cur_cmd->cmd;
+
+    switch (cur_cmd->cmd)
+    {
+        case ADD_REG: buff[size++] = reg;
+                      return size + binary_put_varint(buff + size, (unsigned) constant);
+        case ADDI   :
+        case SUBI   : buff[size++] = reg;
+                      return size + binary_put_int(buff + size, cur_cmd->arg.int_num);
+        case ADD_MEM: buff[size++] = reg;
+                      size += binary_put_int(buff + size, cur_cmd->arg.ram_index[0]);
+                      return size + binary_put_int(buff + size, cur_cmd->arg.ram_index[1]);
+        case MEM_OP : buff[size++] = cur_cmd->param;
+                      buff[size++] = reg;
+                      size += binary_put_int(buff + size, cur_cmd->offset);
+                      return size + binary_put_varint(buff + size, (unsigned) constant);
+        default     : return size;
+    }
+    return size;
+}
+
+/**
+*   @return размер записанного varint (см. compact_pull_varint())
+*/
+
+int binary_put_varint(unsigned char *const buff, unsigned num)
+{
+    assert(buff != nullptr);
+
+    int size = 0;
+    for (; num >= 128; num >>= 7) buff[size++] = (unsigned char) (num | 128);
+    buff[size++] = (unsigned char) num;
+
+    return size;
+}
+
+/**
+*   @return размер записанного zigzag varint (см. compact_pull_int())
+*/
+
+int binary_put_int(unsigned char *const buff, const int num)
+{
+    assert(buff != nullptr);
+
+    return binary_put_varint(buff, ((unsigned) num << 1) ^ (unsigned) (num >> 31));
+}
+
+/**
+*   @return индекс числа num в пуле констант, число добавляется в пул, если его там нет
+*/
+
+int binary_pool_index(double *const pool, int *const pool_num, int *const table, const int table_size, const double num)
+{
+    assert(pool     != nullptr);
+    assert(pool_num != nullptr);
+    assert(table    != nullptr);
+
+    unsigned long long bits = 0;
+    memcpy(&bits, &num, sizeof(double));
+
+    const unsigned mask = (unsigned) table_size - 1;
+    unsigned       pos  = (unsigned) ((bits * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+
+    for (; table[pos] != -1; pos = (pos + 1) & mask)
+    {
+        if (!memcmp(pool + table[pos], &num, sizeof(double))) return table[pos];
+    }
+
+    pool[*pool_num] = num;
+    table[pos]      = *pool_num;
+
+    return (*pool_num)++;
+}
+
+/**
+*   @return смещение в записанном коде инструкции со смещением pc в исходном коде размера capacity (-1, если ее нет)
+*/
+
+int binary_map_pc(const int *const pc_map, const int capacity, const int pc)
+{
+    if (pc_map == nullptr)      return pc;
+    if (pc < 0 || pc > capacity) return -1;
+
+    return pc_map[pc];
+}
+
+int binary_align(const int offset)
+{
+    return (offset + BINARY_ALIGN - 1) / BINARY_ALIGN * BINARY_ALIGN;
+}
+
+void binary_write_pad(FILE *const stream, long *const pos)
+{
+    assert(stream != nullptr);
+    assert(pos    != nullptr);
+
+    for (; *pos % BINARY_ALIGN != 0; ++*pos) fputc('\0', stream);
+}
+
+/*===========================================================================================================================*/
+// LOAD
+/*===========================================================================================================================*/
+
+/**
+*   @brief Отображает исполняемый файл в память и проверяет заголовок.
+*
+*   @note Код и пул констант не копируются: file->code указывает внутрь отображения, декодер читает их оттуда.
+*         Отображение живет до binary_unload().
+*/
+
+bool binary_load(binary_file *const file, const char *const execute_file)
+{
+    assert(file         != nullptr);
+    assert(execute_file != nullptr);
+
+    *file = {};
+
+    const int   fd = open(execute_file, O_RDONLY);
+    struct stat st = {};
+
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, TERMINAL_RED "ERROR: " TERMINAL_CANCEL "can't open execute file \"%s\"\n", execute_file);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    file->map_size = (size_t) st.st_size;
+    file->map      = (file->map_size < sizeof(binary_header)) ? MAP_FAILED :
+                     mmap(nullptr, file->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (file->map == MAP_FAILED)
+    {
+        fprintf(stderr, TERMINAL_RED "ERROR: " TERMINAL_CANCEL "\"%s\" is not an execute file\n", execute_file);
+        *file = {};
+        return false;
+    }
+    memcpy(&file->header, file->map, sizeof(binary_header));
+
+    if (!binary_check(file))
+    {
+        fprintf(stderr, TERMINAL_RED "ERROR: " TERMINAL_CANCEL "can't load \"%s\"\n", execute_file);
+        binary_unload(file);
+        return false;
+    }
+
+    char *const base = (char *) file->map;
+
+    file->code.cmd       = base + file->header.code_offset;
+    file->code.capacity  = file->header.code_size;
+    file->code.pc        = 0;
+    file->code.pool      = (file->header.encoding == ENCODING_STACK || file->header.encoding == ENCODING_COMPACT) ?
+                           (const double *) (base + file->header.const_offset) : nullptr;
+    file->code.pool_size = file->header.const_num;
+
+    file->symbol = (const binary_symbol *) (base + file->header.symbol_offset);
+    file->line   = (const binary_line   *) (base + file->header.line_offset);
+    file->string =                          base + file->header.string_offset;
+
+    return true;
+}
+
+/**
+*   @brief Проверяет сигнатуру, версию и границы секций.
+*/
+
+bool binary_check(const binary_file *const file)
+{
+    assert(file != nullptr);
+
+    const binary_header *header = &file->header;
+    const char          *err    = nullptr;
+
+    #define section_fits(offset, size)                                                                                      \
+        ((offset) >= (int) sizeof(binary_header) && (offset) % BINARY_ALIGN == 0 && (size) >= 0 &&                          \
+         (size_t) (offset) + (size_t) (size) <= file->map_size)
+
+    if      (memcmp(header->signature, BINARY_SIGNATURE, sizeof(BINARY_SIGNATURE)) != 0) err = "no signature, the file is made by an old assembler or isn't an execute file";
+    else if (header->version < 1 || header->version > BINARY_VERSION)                    err = "unsupported version of execute file, update the machine";
+    else if (header->encoding < 0 || header->encoding >= ENCODING_NUMBER)                 err = "unknown code encoding";
+    else if (header->const_num  < 0 || header->symbol_num < 0 || header->line_num < 0)    err = "execute file is damaged";
+    else if (!section_fits(header->code_offset  , header->code_size)                                      ||
+             !section_fits(header->const_offset , (long long) header->const_num  * (long long) sizeof(double))        ||
+             !section_fits(header->symbol_offset, (long long) header->symbol_num * (long long) sizeof(binary_symbol)) ||
+             !section_fits(header->string_offset, header->string_size)                                    ||
+             !section_fits(header->line_offset  , (long long) header->line_num   * (long long) sizeof(binary_line)))
+                                                                                          err = "section is out of execute file";
+    else if (header->entry != 0)                                                          err = "machine starts execution at the beginning of code only";
+    else if (header->ram_size < 0)                                                        err = "invalid RAM size";
+    else if (header->string_size > 0 && ((const char *) file->map)[header->string_offset + header->string_size - 1] != '\0')
+                                                                                          err = "string section is damaged";
+    #undef section_fits
+
+    if (err == nullptr) return true;
+
+    fprintf(stderr, TERMINAL_RED "ERROR: " TERMINAL_CANCEL "%s\n", err);
+    return false;
+}
+
+/**
+*   @brief Декодирует стековый код файла в выбранной при сборке кодировке и загружает символы.
+*
+*   @note Регистровый код декодируется reg_decode().
+*/
+
+bool binary_decode(program *const prog, binary_file *const file)
+{
+    assert(prog != nullptr);
+    assert(file != nullptr);
+    assert(file->header.encoding != ENCODING_REG);
+
+    bool no_err = false;
+
+    switch ((BINARY_ENCODING) file->header.encoding)
+    {
+        case ENCODING_ALIGNED: no_err = program_aligned_ctor(prog, &file->code); break;
+        case ENCODING_COMPACT: no_err = program_compact_ctor(prog, &file->code); break;
+        case ENCODING_STACK  : no_err = program_ctor        (prog, &file->code); break;
+
+        case ENCODING_REG    :
+        case ENCODING_NUMBER :
+        default              : log_error("invalid encoding in binary_decode(): %d(%d)\n", file->header.encoding, __LINE__);
+                               break;
+    }
+
+    return no_err && binary_load_symbols(prog, file);
+}
+
+/**
+*   @return смещение инструкции, следующей за инструкцией со смещением pc (код уже проверен декодером)
+*/
+
+int binary_next_pc(const binary_file *const file, const int pc)
+{
+    assert(file != nullptr);
+
+    switch ((BINARY_ENCODING) file->header.encoding)
+    {
+        case ENCODING_ALIGNED: return pc + (int) sizeof(instruction);
+        case ENCODING_COMPACT: {
+                                    executer    walk = file->code;
+                                    instruction skip = {};
+
+                                    walk.pc = pc;
+                                    decode_compact(&walk, &skip, nullptr);
+                                    return walk.pc;
+                               }
+        case ENCODING_STACK  : return pc + get_instruction_size(((const unsigned char *) file->code.cmd)[pc], true);
+
+        case ENCODING_REG    :
+        case ENCODING_NUMBER :
+        default              : return file->header.code_size;
+    }
+}
+
+/**
+*   @brief Заполняет prog->name и prog->line по таблице символов и строк файла (для отчетов и сообщений об ошибках).
+*
+*   @note Таблицы необязательны: при их отсутствии prog->name и prog->line остаются nullptr.
+*         Записи, не попадающие на начало инструкции, пропускаются.
+*/
+
+bool binary_load_symbols(program *const prog, const binary_file *const file)
+{
+    assert(prog != nullptr);
+    assert(file != nullptr);
+
+    const binary_header *header = &file->header;
+
+    if (header->encoding == ENCODING_REG || (header->symbol_num == 0 && header->line_num == 0)) return true;
+
+    int *pc_index = (int *) log_calloc((size_t) header->code_size + 1, sizeof(int));    // pc_index[pc] - индекс инструкции
+    if  (pc_index == nullptr) return false;
+
+    for (int pc = 0; pc <= header->code_size; ++pc) pc_index[pc] = -1;
+    for (int pc = 0, i = 0; pc < header->code_size && i < prog->size; ++i)
+    {
+        pc_index[pc] = i;
+        pc           = binary_next_pc(file, pc);
+    }
+
+    bool no_err = true;
+
+    if (header->symbol_num > 0)
+    {
+        prog->name  = (const char **) log_calloc((size_t) prog->size + 1  , sizeof(char *));
+        prog->names = (char        *) log_calloc((size_t) header->string_size, sizeof(char));
+        no_err      = prog->name != nullptr && prog->names != nullptr;
+
+        if (no_err) memcpy(prog->names, file->string, (size_t) header->string_size);
+
+        for (int i = 0; no_err && i < header->symbol_num; ++i)
+        {
+            const binary_symbol *cur = file->symbol + i;
+
+            if (cur->pc < 0 || cur->pc > header->code_size || cur->name < 0 || cur->name >= header->string_size) continue;
+
+            const int index = (cur->pc == header->code_size) ? prog->size : pc_index[cur->pc];
+            if (index != -1 && prog->name[index] == nullptr) prog->name[index] = prog->names + cur->name;
+        }
+    }
+    if (no_err && header->line_num > 0)
+    {
+        prog->line = (int *) log_calloc((size_t) prog->size + 1, sizeof(int));
+        no_err     = prog->line != nullptr;
+
+        for (int i = 0; no_err && i < header->line_num; ++i)
+        {
+            const binary_line *cur = file->line + i;
+
+            if (0 <= cur->pc && cur->pc < header->code_size && pc_index[cur->pc] != -1) prog->line[pc_index[cur->pc]] = cur->line;
+        }
+    }
+    log_free(pc_index);
+
+    if (!no_err) log_error("can't allocate memory for program symbols(%d)\n", __LINE__);
+    return no_err;
+}
+
+void binary_unload(binary_file *const file)
+{
+    assert(file != nullptr);
+
+    if (file->map != nullptr) munmap(file->map, file->map_size);
+
+    *file = {};
+}
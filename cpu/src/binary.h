@@ -0,0 +1,112 @@
+#ifndef BINARY
+#define BINARY
+
+#include <stdio.h>
+
+#include "cpu.h"
+#include "label.h"
+#include "decoder.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+static const char BINARY_SIGNATURE[8] = "CPUBIN";
+const int         BINARY_VERSION      = 1;      // версия формата, файлы более новых версий не загружаются
+const int         BINARY_ALIGN        = 16;     // выравнивание секций относительно начала файла
+
+enum BINARY_ENCODING                    // кодировка секции кода
+{
+    ENCODING_STACK  ,                   // байт-код стековой машины, действительные операнды - индексы в пуле констант
+    ENCODING_REG    ,                   // регистровый код (см. reg_encode())
+    ENCODING_ALIGNED,                   // массив instruction: операнды выровнены, метки - индексы инструкций (см. binary_align_code())
+    ENCODING_COMPACT,                   // плотный байт-код: varint, короткие формы push/pop, относительные переходы (см. binary_compact_code())
+
+    ENCODING_NUMBER ,
+};
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct binary_header                    // исполняемый файл: [заголовок][код][пул констант][символы][строки][строки кода]
+{
+    char signature[8];                  // BINARY_SIGNATURE
+    int  version;                       // BINARY_VERSION
+    int  encoding;                      // BINARY_ENCODING
+    int  entry;                         // смещение в коде первой исполняемой инструкции
+    int  ram_size;                      // сколько ячеек RAM нужно программе (0 - размер по умолчанию)
+
+    int  code_offset;                   // смещения секций от начала файла (кратны BINARY_ALIGN) и их размеры
+    int  code_size;                     // в байтах
+    int  const_offset;
+    int  const_num;                     // количество double в пуле констант
+    int  symbol_offset;
+    int  symbol_num;                    // количество binary_symbol (0 - таблицы нет)
+    int  string_offset;
+    int  string_size;                   // в байтах
+    int  line_offset;
+    int  line_num;                      // количество binary_line (0 - таблицы нет)
+};
+
+struct binary_symbol                    // метка кода
+{
+    int pc;                             // смещение инструкции в коде
+    int name;                           // смещение имени метки в секции строк
+};
+
+struct binary_line                      // строка исходного кода, из которой получена инструкция
+{
+    int pc;                             // смещение инструкции в коде
+    int line;                           // номер строки
+};
+
+struct binary_image                     // содержимое исполняемого файла перед записью (см. binary_write())
+{
+    const executer    *code;            // код, для ENCODING_STACK - с действительными операндами внутри инструкций
+    BINARY_ENCODING    encoding;
+    int                ram_size;
+    const label_store *link;            // метки для таблицы символов (nullptr - без таблицы)
+    const binary_line *line;            // строки кода по возрастанию pc (nullptr - без таблицы)
+    int                line_num;
+};
+
+struct binary_file                      // загруженный исполняемый файл (отображение в память)
+{
+    void                *map;           // отображение файла
+    size_t               map_size;
+    binary_header        header;
+    executer             code;          // секция кода внутри отображения (только для чтения, не освобождается)
+    const binary_symbol *symbol;
+    const binary_line   *line;
+    const char          *string;
+};
+
+/*===========================================================================================================================*/
+// BINARY
+/*===========================================================================================================================*/
+
+bool binary_write        (FILE *const stream, const binary_image *const image);
+bool binary_pack_code    (const executer *const code, executer *const packed, double **const pool, int *const pool_num,
+                                                                                               int  **const pc_map);
+int  binary_cmd_size     (const executer *const code, const int pc);
+bool binary_align_code   (const executer *const code, executer *const aligned, int **const pc_map);
+bool binary_compact_code (const executer *const code, executer *const compact, double **const pool, int *const pool_num,
+                                                                                                 int  **const pc_map);
+int  binary_compact_cmd  (const instruction *const cur_cmd, const int constant, const bool long_jump, const int shift,
+                                                                                                     unsigned char *const buff);
+int  binary_put_varint   (unsigned char *const buff, unsigned num);
+int  binary_put_int      (unsigned char *const buff, const int num);
+int  binary_pool_index   (double *const pool, int *const pool_num, int *const table, const int table_size, const double num);
+int  binary_map_pc       (const int *const pc_map, const int capacity, const int pc);
+int  binary_align        (const int offset);
+void binary_write_pad    (FILE *const stream, long *const pos);
+
+bool binary_load         (binary_file *const file, const char *const execute_file);
+bool binary_check        (const binary_file *const file);
+bool binary_decode       (program *const prog, binary_file *const file);
+int  binary_next_pc      (const binary_file *const file, const int pc);
+bool binary_load_symbols (program *const prog, const binary_file *const file);
+void binary_unload       (binary_file *const file);
+
+#endif //BINARY
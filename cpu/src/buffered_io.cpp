@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../lib/logs/log.h"
+
+#include "buffered_io.h"
+#include "terminal_colors.h"
+
+/*===========================================================================================================================*/
+// IO
+/*===========================================================================================================================*/
+
+/**
+*   @brief Читает действительное число так же, как scanf("%lg").
+*
+*   @return true, если число прочитано и false, если ввод закончился или следующее слово не является числом
+*
+*   @note Буфер ввода пополняется системным вызовом read() целыми блоками. Перед чтением число
+*         должно быть записано в буфер целиком (за ним идет пробельный символ или конец ввода),
+*         поэтому интерактивный ввод не ждет заполнения всего буфера.
+*/
+
+bool io_read_double(machine_io *const io, double *const num)
+{
+    assert(io  != nullptr);
+    assert(num != nullptr);
+
+    while (true)
+    {
+        while (io->in_pos < io->in_size && isspace((unsigned char) io->in_buf[io->in_pos])) io->in_pos++;
+
+        if (io->in_pos < io->in_size) break;
+        if (!io_fill(io))             return false;
+    }
+
+    int token_end = io->in_pos;
+    while (true)
+    {
+        while (token_end < io->in_size && !isspace((unsigned char) io->in_buf[token_end])) token_end++;
+
+        if (token_end < io->in_size || io->in_eof) break;
+
+        token_end -= io->in_pos;
+        if (!io_fill(io)) break;
+        token_end += io->in_pos;
+    }
+
+    const char *end = nullptr;
+    if (!io_parse_double(io->in_buf + io->in_pos, &end, num)) return false;
+
+    io->in_pos = (int) (end - io->in_buf);
+    return true;
+}
+
+/**
+*   @brief Сдвигает непрочитанные байты в начало буфера ввода и дочитывает ввод.
+*
+*   @return true, если прочитан хотя бы один байт
+*
+*   @note Перед чтением сбрасывается буфер вывода, чтобы вывод программы был виден до того, как она ждет ввода.
+*/
+
+bool io_fill(machine_io *const io)
+{
+    assert(io != nullptr);
+
+    if (io->in_eof) return false;
+
+    io_flush(io);
+
+    memmove(io->in_buf, io->in_buf + io->in_pos, (size_t) (io->in_size - io->in_pos));
+    io->in_size -= io->in_pos;
+    io->in_pos   = 0;
+
+    if (io->in_size == IO_BUFFER_SIZE) return false;   // слово длиннее буфера читается по частям
+
+    ssize_t read_size = 0;
+    do read_size = read(io->in_fd, io->in_buf + io->in_size, (size_t) (IO_BUFFER_SIZE - io->in_size));
+    while (read_size < 0 && errno == EINTR);
+
+    if (read_size <= 0)
+    {
+        io->in_eof = true;
+        return false;
+    }
+
+    io->in_size += (int) read_size;
+    io->in_buf[io->in_size] = '\0';
+    return true;
+}
+
+/**
+*   @brief Заменяет ввод строкой str длины len: IN читает числа из нее, после нее ввод закончен.
+*
+*   @return true, если строка помещается в буфер ввода
+*/
+
+bool io_set_input(machine_io *const io, const char *const str, const size_t len)
+{
+    assert(io  != nullptr);
+    assert(str != nullptr);
+
+    io->in_pos  = 0;
+    io->in_size = 0;
+    io->in_eof  = true;
+
+    if (len > (size_t) IO_BUFFER_SIZE) { io->in_buf[0] = '\0'; return false; }
+
+    memcpy(io->in_buf, str, len);
+    io->in_size = (int) len;
+    io->in_buf[io->in_size] = '\0';
+    return true;
+}
+
+/**
+*   @brief Разбирает действительное число в начале строки str.
+*
+*   @param end [out] - первый символ после числа
+*
+*   @return true, если в начале str записано число
+*
+*   @note Десятичная запись не длиннее 15 цифр с порядком не больше 22 по модулю переводится
+*         одним умножением или делением точных double, поэтому результат совпадает с strtod().
+*         Остальные записи (длинные, шестнадцатеричные, inf, nan) разбирает strtod().
+*/
+
+bool io_parse_double(const char *const str, const char **const end, double *const num)
+{
+    assert(str != nullptr);
+    assert(end != nullptr);
+    assert(num != nullptr);
+
+    static const double POW_10[] = {1e0 , 1e1 , 1e2 , 1e3 , 1e4 , 1e5 , 1e6 , 1e7 , 1e8 , 1e9 , 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const int MAX_DIGITS = 15;
+    const int MAX_POW    = 22;
+
+    const char *cur      = str;
+    bool        negative = false;
+
+    if (*cur == '-' || *cur == '+') negative = (*cur++ == '-');
+
+    long long mantissa = 0;
+    int       digits   = 0;     // цифры мантиссы без ведущих нулей
+    int       any      = 0;     // все цифры мантиссы
+    int       exponent = 0;
+
+    for (; isdigit((unsigned char) *cur); ++cur, ++any)
+    {
+        if (mantissa != 0 || *cur != '0') { mantissa = mantissa * 10 + (*cur - '0'); digits++; }
+        if (digits > MAX_DIGITS) break;
+    }
+    if (*cur == '.')
+    {
+        for (++cur; isdigit((unsigned char) *cur); ++cur, ++any)
+        {
+            if (mantissa != 0 || *cur != '0') { mantissa = mantissa * 10 + (*cur - '0'); digits++; }
+            exponent--;
+            if (digits > MAX_DIGITS) break;
+        }
+    }
+
+    bool fast = any > 0 && digits <= MAX_DIGITS && !(*cur == 'x' || *cur == 'X');
+
+    if (fast && (*cur == 'e' || *cur == 'E'))
+    {
+        const char *exp_cur  = cur + 1;
+        bool        exp_neg  = false;
+        int         exp_num  = 0;
+
+        if (*exp_cur == '-' || *exp_cur == '+') exp_neg = (*exp_cur++ == '-');
+
+        if (!isdigit((unsigned char) *exp_cur)) fast = false;
+        for (; fast && isdigit((unsigned char) *exp_cur) && exp_num <= MAX_POW; ++exp_cur) exp_num = exp_num * 10 + (*exp_cur - '0');
+        if (isdigit((unsigned char) *exp_cur)) fast = false;
+
+        exponent += exp_neg ? -exp_num : exp_num;
+        cur       = exp_cur;
+    }
+
+    if (fast && -MAX_POW <= exponent && exponent <= MAX_POW)
+    {
+        double result = (double) mantissa;
+
+        if (exponent >= 0) result *= POW_10[ exponent];
+        else               result /= POW_10[-exponent];
+
+        *num = negative ? -result : result;
+        *end = cur;
+        return true;
+    }
+
+    char *strtod_end = nullptr;
+    *num = strtod(str, &strtod_end);
+    *end = strtod_end;
+
+    return strtod_end != str;
+}
+
+/**
+*   @brief Выводит число так же, как fprintf("%lg\n"), в буфер вывода.
+*/
+
+void io_write_double(machine_io *const io, const double num)
+{
+    assert(io != nullptr);
+
+    if (io->out_pos + IO_NUM_LEN > IO_BUFFER_SIZE) io_flush(io);
+
+    io->out_pos += io_format_double(io->out_buf + io->out_pos, num);
+}
+
+/**
+*   @brief Записывает в str число num и '\n' в формате "%lg\n".
+*
+*   @return количество записанных символов
+*
+*   @note Целые числа, меньшие 10^6 по модулю, %lg выводит всеми цифрами, они записываются без snprintf().
+*/
+
+int io_format_double(char *const str, const double num)
+{
+    assert(str != nullptr);
+
+    const double MAX_INT = 999999;
+
+    if (-MAX_INT <= num && num <= MAX_INT)
+    {
+        int          int_num = (int) num;
+        const double frac    = num - (double) int_num;
+
+        if (!(frac < 0) && !(frac > 0) && !(int_num == 0 && signbit(num)))
+        {
+            char  digits[16] = {};
+            int   len        = 0;
+            int   pos        = 0;
+
+            if (int_num < 0) { str[pos++] = '-'; int_num = -int_num; }
+
+            do { digits[len++] = (char) ('0' + int_num % 10); int_num /= 10; } while (int_num != 0);
+            while (len > 0) str[pos++] = digits[--len];
+
+            str[pos++] = '\n';
+            return pos;
+        }
+    }
+    return snprintf(str, (size_t) IO_NUM_LEN, "%lg\n", num);
+}
+
+void io_flush(machine_io *const io)
+{
+    assert(io != nullptr);
+
+    if (io->out == nullptr || io->out_pos == 0) return;
+
+    fwrite(io->out_buf, sizeof(char), (size_t) io->out_pos, io->out);
+    fflush(io->out);
+
+    io->out_pos = 0;
+}
+
+/*===========================================================================================================================*/
+// IO_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Готовит буферы ввода и вывода.
+*
+*   @param out_file - куда выводить результаты OUT: nullptr или "stderr" - stderr, "stdout" - stdout, иначе имя файла
+*/
+
+bool io_ctor(machine_io *const io, const char *const out_file)
+{
+    assert(io != nullptr);
+
+    io->in_fd     = STDIN_FILENO;
+    io->in_buf    = (char *) log_calloc((size_t) IO_BUFFER_SIZE + 1, sizeof(char));   // +1 for '\0' in the end
+    io->in_size   = 0;
+    io->in_pos    = 0;
+    io->in_eof    = false;
+
+    io->out_buf   = (char *) log_calloc((size_t) IO_BUFFER_SIZE, sizeof(char));
+    io->out_pos   = 0;
+    io->out_owned = false;
+    io->err       = stderr;
+
+    if      (out_file == nullptr || !strcmp(out_file, "stderr")) io->out = stderr;
+    else if (                       !strcmp(out_file, "stdout")) io->out = stdout;
+    else
+    {
+        io->out       = fopen(out_file, "w");
+        io->out_owned = true;
+    }
+
+    if (io->in_buf == nullptr || io->out_buf == nullptr)
+    {
+        log_error(        "can't allocate memory for io buffers(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for io buffers\n");
+        io_dtor(io);
+        return false;
+    }
+    if (io->out == nullptr)
+    {
+        fprintf(stderr, TERMINAL_RED "ERROR: " TERMINAL_CANCEL "can't open output file \"%s\"\n", out_file);
+        io_dtor(io);
+        return false;
+    }
+    return true;
+}
+
+/**
+*   @brief Сбрасывает буфер вывода и освобождает буферы.
+*/
+
+void io_dtor(machine_io *const io)
+{
+    assert(io != nullptr);
+
+    io_flush(io);
+    if (io->out_owned && io->out != nullptr) fclose(io->out);
+
+    log_free(io->in_buf);
+    log_free(io->out_buf);
+
+    *io = {};
+}
@@ -0,0 +1,53 @@
+#ifndef BUFFERED_IO
+#define BUFFERED_IO
+
+#include <stdio.h>
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+const int IO_BUFFER_SIZE = 1 << 16;     // размер буферов ввода и вывода
+const int IO_NUM_LEN     = 64;          // наибольшая длина выведенного числа (вместе с '\n')
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct machine_io               // буферизованный ввод и вывод команд IN и OUT
+{
+    int   in_fd;                // дескриптор ввода
+    char *in_buf;               // буфер ввода, после .in_size байт всегда лежит '\0'
+    int   in_size;              // количество прочитанных байт в .in_buf
+    int   in_pos;               // позиция первого непрочитанного байта
+    bool  in_eof;               // ввод закончился
+
+    FILE *out;                  // поток вывода
+    bool  out_owned;            // поток открыт io_ctor() и закрывается io_dtor()
+    char *out_buf;              // буфер вывода
+    int   out_pos;              // количество байт в .out_buf
+
+    FILE *err;                  // поток сообщений об ошибках исполнения
+};
+
+/*===========================================================================================================================*/
+// IO
+/*===========================================================================================================================*/
+
+bool io_read_double   (machine_io *const io, double *const num);
+bool io_fill          (machine_io *const io);
+bool io_set_input     (machine_io *const io, const char *const str, const size_t len);
+bool io_parse_double  (const char *const str, const char **const end, double *const num);
+
+void io_write_double  (machine_io *const io, const double num);
+int  io_format_double (char *const str, const double num);
+void io_flush         (machine_io *const io);
+
+/*===========================================================================================================================*/
+// IO_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool io_ctor          (machine_io *const io, const char *const out_file = nullptr);
+void io_dtor          (machine_io *const io);
+
+#endif //BUFFERED_IO
@@ -20,18 +20,22 @@ void executer_ctor(executer *const cpu)
 {
     assert(cpu != nullptr);
 
-    cpu->cmd      = nullptr;
-    cpu->capacity = 0;
-    cpu->pc       = 0;
+    cpu->cmd       = nullptr;
+    cpu->capacity  = 0;
+    cpu->pc        = 0;
+    cpu->pool      = nullptr;
+    cpu->pool_size = 0;
 }
 
 void executer_ctor(executer *const cpu, const int size)
 {
     assert(cpu != nullptr);
 
-    cpu->cmd      = log_calloc((size_t) size, sizeof(cpu_type));
-    cpu->capacity = size;
-    cpu->pc       = 0;
+    cpu->cmd       = log_calloc((size_t) size, sizeof(cpu_type));
+    cpu->capacity  = size;
+    cpu->pc        = 0;
+    cpu->pool      = nullptr;
+    cpu->pool_size = 0;
 }
 
 bool executer_ctor(executer *const cpu, const char *execute_file)
@@ -39,8 +43,10 @@ bool executer_ctor(executer *const cpu, const char *execute_file)
     assert(cpu          != nullptr);
     assert(execute_file != nullptr);
 
-    cpu->cmd = read_file(execute_file, &cpu->capacity);
-    cpu->pc  = 0;
+    cpu->cmd       = read_file(execute_file, &cpu->capacity);
+    cpu->pc        = 0;
+    cpu->pool      = nullptr;
+    cpu->pool_size = 0;
 
     if (cpu->cmd == nullptr)
     {
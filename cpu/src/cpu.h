@@ -56,7 +56,57 @@ enum ASM_CMD
     COS             , // 21
     LOG             , // 22
 
-    UNDEF_ASM_CMD   , // 23
+    ADD_REG         , // 23     суперинструкции, их выбирает ассемблер (см. translate_superinstruction())
+    JZ              , // 24
+    ADD_MEM         , // 25
+    MEM_OP          , // 26
+
+    ADDI            , // 27     целочисленная арифметика: int-регистр op= целое число, без перевода в cpu_type
+    SUBI            , // 28
+
+    UNDEF_ASM_CMD   , // 29
+};
+
+static constexpr const char *ASM_CMD_NAMES[] =
+{
+    "HLT"           ,
+
+    "IN"            ,
+    "OUT"           ,
+
+    "PUSH"          ,
+    "POP"           ,
+
+    "JMP"           ,
+    "JA"            ,
+    "JAE"           ,
+    "JB"            ,
+    "JBE"           ,
+    "JE"            ,
+    "JNE"           ,
+
+    "CALL"          ,
+    "RET"           ,
+
+    "ADD"           ,
+    "SUB"           ,
+    "MUL"           ,
+    "DIV"           ,
+    "POW"           ,
+    "SQRT"          ,
+    "SIN"           ,
+    "COS"           ,
+    "LOG"           ,
+
+    "ADD_REG"       ,
+    "JZ"            ,
+    "ADD_MEM"       ,
+    "MEM_OP"        ,
+
+    "ADDI"          ,
+    "SUBI"          ,
+
+    "UNDEF_ASM_CMD" ,
 };
 
 enum ASM_CMD_PARAM      //    |   1 bit   |   1 bit   |   1 bit   |         5 bit         |
@@ -75,6 +125,9 @@ struct executer
     void *cmd;          // массив, содержащий инструкции и параметры исполнителя(бинарный код)
     int   capacity;     // емкость .cmd
     int   pc;           // program counter(он же размер .cmd)
+
+    const double *pool;     // пул констант: действительные операнды в .cmd - индексы в нем (nullptr - операнды внутри .cmd)
+    int      pool_size;     // количество констант в .pool
 };
 
 /*===========================================================================================================================*/
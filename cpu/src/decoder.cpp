@@ -0,0 +1,602 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+
+#include "../../lib/logs/log.h"
+
+#include "decoder.h"
+#include "terminal_colors.h"
+
+/*===========================================================================================================================*/
+// PROGRAM_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Декодирует упакованный бинарный код исполнителя в массив инструкций фиксированного размера.
+*
+*   @param prog [out] - декодированная программа
+*   @param cpu  [in]  - исполнитель с бинарным кодом
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Первым проходом определяются границы инструкций, вторым - декодируются параметры
+*         и метки переводятся из смещений в байтах в индексы инструкций.
+*   @note После последней инструкции кладется HLT, поэтому prog->cmd содержит prog->size + 1 элемент.
+*/
+
+bool program_ctor(program *const prog, executer *const cpu)
+{
+    assert(prog != nullptr);
+    assert(cpu  != nullptr);
+
+    *prog = {};
+
+    int *pc_index = (int *) log_calloc((size_t) cpu->capacity + 1, sizeof(int)); // pc_index[pc] - индекс инструкции, начинающейся с байта pc
+    if  (pc_index == nullptr) return false;
+
+    for (int pc = 0; pc <= cpu->capacity; ++pc) pc_index[pc] = -1;
+
+    for (int pc = 0; pc < cpu->capacity;)
+    {
+        int cmd_size = get_instruction_size(((const unsigned char *) cpu->cmd)[pc], cpu->pool != nullptr);
+        if (cmd_size == -1)
+        {
+            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "undefined command at byte %d\n", pc);
+            log_free(pc_index);
+            return false;
+        }
+        if (pc + cmd_size > cpu->capacity)
+        {
+            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "no parameter at the end of file\n");
+            log_free(pc_index);
+            return false;
+        }
+        pc_index[pc] = prog->size++;
+        pc          += cmd_size;
+    }
+
+    prog->cmd = (instruction *) log_calloc((size_t) prog->size + 1, sizeof(instruction)); // +1 for HLT sentinel
+    if (prog->cmd == nullptr)
+    {
+        log_error("can't allocate memory for decoded program(%d)\n", __LINE__);
+        log_free (pc_index);
+        return false;
+    }
+
+    cpu->pc = 0;
+    for (int i = 0; i < prog->size; ++i)
+    {
+        if (!decode_instruction(cpu, prog->cmd + i, pc_index))
+        {
+            log_free(pc_index);
+            program_dtor(prog);
+            return false;
+        }
+    }
+    prog->cmd[prog->size].cmd = HLT; // исполнение, дошедшее до конца кода, останавливается без проверки pc
+
+    log_free(pc_index);
+    return true;
+}
+
+/**
+*   @brief Загружает код в выровненной кодировке: он уже является массивом instruction (см. binary_align_code()).
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Инструкции копируются целиком и только проверяются (см. check_aligned()), разбора по байтам нет.
+*/
+
+bool program_aligned_ctor(program *const prog, const executer *const cpu)
+{
+    assert(prog != nullptr);
+    assert(cpu  != nullptr);
+
+    *prog = {};
+
+    if (cpu->capacity % (int) sizeof(instruction) != 0)
+    {
+        fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "aligned code size is not a multiple of instruction size\n");
+        return false;
+    }
+    prog->size = cpu->capacity / (int) sizeof(instruction);
+
+    prog->cmd = (instruction *) log_calloc((size_t) prog->size + 1, sizeof(instruction)); // +1 for HLT sentinel
+    if (prog->cmd == nullptr)
+    {
+        log_error("can't allocate memory for decoded program(%d)\n", __LINE__);
+        *prog = {};
+        return false;
+    }
+    memcpy(prog->cmd, cpu->cmd, (size_t) cpu->capacity);
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        if (!check_aligned(prog->cmd + i, prog->size, i)) { program_dtor(prog); return false; }
+    }
+    prog->cmd[prog->size].cmd = HLT;
+
+    return true;
+}
+
+/**
+*   @brief Декодирует код в компактной кодировке (см. binary_compact_code()).
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Как и program_ctor(), первым проходом находит границы инструкций, вторым - декодирует их
+*         и переводит относительные смещения меток в индексы инструкций.
+*/
+
+bool program_compact_ctor(program *const prog, executer *const cpu)
+{
+    assert(prog != nullptr);
+    assert(cpu  != nullptr);
+
+    *prog = {};
+
+    int *pc_index = (int *) log_calloc((size_t) cpu->capacity + 1, sizeof(int)); // pc_index[pc] - индекс инструкции, начинающейся с байта pc
+    if  (pc_index == nullptr) return false;
+
+    for (int pc = 0; pc <= cpu->capacity; ++pc) pc_index[pc] = -1;
+
+    instruction skip = {};
+    for (cpu->pc = 0; cpu->pc < cpu->capacity;)
+    {
+        pc_index[cpu->pc] = prog->size++;
+
+        if (!decode_compact(cpu, &skip, nullptr)) { log_free(pc_index); *prog = {}; return false; }
+    }
+
+    prog->cmd = (instruction *) log_calloc((size_t) prog->size + 1, sizeof(instruction)); // +1 for HLT sentinel
+    if (prog->cmd == nullptr)
+    {
+        log_error("can't allocate memory for decoded program(%d)\n", __LINE__);
+        log_free (pc_index);
+        *prog = {};
+        return false;
+    }
+
+    cpu->pc = 0;
+    for (int i = 0; i < prog->size; ++i)
+    {
+        if (!decode_compact(cpu, prog->cmd + i, pc_index))
+        {
+            log_free(pc_index);
+            program_dtor(prog);
+            return false;
+        }
+    }
+    prog->cmd[prog->size].cmd = HLT;
+
+    log_free(pc_index);
+    return true;
+}
+
+void program_dtor(program *const prog)
+{
+    assert(prog != nullptr);
+
+    log_free(prog->cmd);
+    log_free(prog->name);
+    log_free(prog->line);
+    log_free(prog->names);
+
+    *prog = {};
+}
+
+/*===========================================================================================================================*/
+// DECODE
+/*===========================================================================================================================*/
+
+/**
+*   @brief Определяет размер (в байтах) инструкции вместе с параметрами по её первому байту.
+*
+*   @param pool - действительный операнд записан индексом в пуле констант (int), а не самим числом (см. binary_pack_code())
+*
+*   @return размер инструкции и -1, если команда не определена
+*/
+
+int get_instruction_size(const unsigned char cmd, const bool pool)
+{
+    if (pool && has_dbl_operand(cmd)) return get_instruction_size(cmd) - (int) sizeof(double) + (int) sizeof(int);
+
+    switch (cmd & 31) // 5 bit for cmd_asm
+    {
+        case PUSH:
+        case POP : {
+                        int cmd_size = (int) sizeof(unsigned char);
+                        bool int_arg = (cmd & (1 << PARAM_MEM)) || (cmd & 31) == POP;
+
+                        if (cmd & (1 << PARAM_REG)) cmd_size += (int) sizeof(REGISTER);
+                        if (cmd & (1 << PARAM_NUM)) cmd_size += (int) (int_arg ? sizeof(int) : sizeof(double));
+
+                        return cmd_size;
+                   }
+        default  : break;
+    }
+    if (cmd >= UNDEF_ASM_CMD) return -1;
+
+    switch (cmd)
+    {
+        case JMP :
+        case JA  :
+        case JAE :
+        case JB  :
+        case JBE :
+        case JE  :
+        case JNE :
+        case JZ  :
+        case CALL: return (int) (sizeof(unsigned char) + sizeof(int));
+
+        case ADD_REG: return (int) (sizeof(unsigned char) + sizeof(REGISTER) + sizeof(double));
+        case ADD_MEM: return (int) (sizeof(unsigned char) + sizeof(REGISTER) + 2 * sizeof(int));
+        case MEM_OP : return (int) (sizeof(unsigned char) * 2 + sizeof(REGISTER) + sizeof(int) + sizeof(double));
+
+        case ADDI   :
+        case SUBI   : return (int) (sizeof(unsigned char) + sizeof(REGISTER) + sizeof(int));
+
+        default  : return (int)  sizeof(unsigned char);
+    }
+    return -1;
+}
+
+/**
+*   @brief Проверяет, есть ли у инструкции действительный операнд. Он всегда последний в инструкции.
+*/
+
+bool has_dbl_operand(const unsigned char cmd)
+{
+    if ((cmd & 31) == PUSH) return (cmd & (1 << PARAM_NUM)) && !(cmd & (1 << PARAM_MEM));
+
+    return cmd == ADD_REG || cmd == MEM_OP;
+}
+
+/**
+*   @brief Проверяет, является ли единственный операнд инструкции смещением метки в коде (переходы и CALL).
+*/
+
+bool has_label_operand(const unsigned char cmd)
+{
+    return (JMP <= cmd && cmd <= JNE) || cmd == JZ || cmd == CALL;
+}
+
+/**
+*   @brief Читает действительный операнд: само число или индекс в пуле констант cpu->pool.
+*/
+
+bool decode_dbl(executer *const cpu, double *const num, const int cmd_beg)
+{
+    assert(cpu != nullptr);
+    assert(num != nullptr);
+
+    if (cpu->pool == nullptr)
+    {
+        executer_pull_cmd(cpu, num, sizeof(double));
+        return true;
+    }
+
+    int index = 0;
+    executer_pull_cmd(cpu, &index, sizeof(int));
+
+    if (index < 0 || index >= cpu->pool_size)
+    {
+        fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "constant at byte %d is out of constant pool\n", cmd_beg);
+        return false;
+    }
+    *num = cpu->pool[index];
+    return true;
+}
+
+/**
+*   @brief Проверяет инструкцию выровненного кода так же, как decode_instruction() проверяет байт-код.
+*
+*   @param size  - количество инструкций в программе
+*   @param index - индекс инструкции (для сообщения об ошибке)
+*/
+
+bool check_aligned(const instruction *const cur_cmd, const int size, const int index)
+{
+    assert(cur_cmd != nullptr);
+
+    const char *err = nullptr;
+
+    if      (cur_cmd->cmd >= UNDEF_ASM_CMD)                                                     err = "undefined command";
+    else if ((cur_cmd->cmd == PUSH || cur_cmd->cmd == POP) && (cur_cmd->param & 31) != 0)        err = "invalid parameter bits";
+    else if (has_label_operand(cur_cmd->cmd) && (cur_cmd->arg.label < 0 || cur_cmd->arg.label >= size))
+                                                                                                err = "label pointed out of program";
+
+    if (err == nullptr) return true;
+
+    fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "%s at instruction %d\n", err, index);
+    return false;
+}
+
+/**
+*   @brief Декодирует очередную инструкцию бинарного кода.
+*
+*   @param cpu      [in][out] - исполнитель, cpu->pc указывает на начало инструкции
+*   @param cur_cmd      [out] - декодированная инструкция
+*   @param pc_index [in]      - таблица перевода смещений в байтах в индексы инструкций
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool decode_instruction(executer *const cpu, instruction *const cur_cmd, const int *const pc_index)
+{
+    assert(cpu      != nullptr);
+    assert(cur_cmd  != nullptr);
+    assert(pc_index != nullptr);
+
+    const int cmd_beg = cpu->pc;
+    unsigned char cmd = 0;
+
+    executer_pull_cmd(cpu, &cmd, sizeof(unsigned char));
+
+    cur_cmd->cmd    = cmd;
+    cur_cmd->param  = 0;
+    cur_cmd->offset = 0;
+    cur_cmd->reg    = ERR_REG;
+
+    switch (cmd & 31) // 5 bit for cmd_asm
+    {
+        case PUSH:
+        case POP : cur_cmd->cmd   = cmd &  31;
+                   cur_cmd->param = cmd & (unsigned char) ~31;
+
+                   if (cmd & (1 << PARAM_REG)) executer_pull_cmd(cpu, &cur_cmd->reg, sizeof(REGISTER));
+                   if (cmd & (1 << PARAM_NUM))
+                   {
+                       if ((cmd & (1 << PARAM_MEM)) || (cmd & 31) == POP) executer_pull_cmd(cpu, &cur_cmd->arg.int_num, sizeof(int));
+                       else                                               return decode_dbl(cpu, &cur_cmd->arg.dbl_num, cmd_beg);
+                   }
+                   return true;
+        default  : break;
+    }
+
+    switch (cmd)
+    {
+        case JMP :
+        case JA  :
+        case JAE :
+        case JB  :
+        case JBE :
+        case JE  :
+        case JNE :
+        case JZ  :
+        case CALL: {
+                        int label_pc = 0;
+                        executer_pull_cmd(cpu, &label_pc, sizeof(int));
+
+                        if (label_pc < 0 || label_pc >= cpu->capacity || pc_index[label_pc] == -1)
+                        {
+                            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "label at byte %d pointed out of instruction boundary\n", cmd_beg);
+                            return false;
+                        }
+                        cur_cmd->arg.label = pc_index[label_pc];
+                        return true;
+                   }
+        case ADD_REG: executer_pull_cmd(cpu, &cur_cmd->reg        , sizeof(REGISTER));
+                      return decode_dbl(cpu, &cur_cmd->arg.dbl_num, cmd_beg);
+        case ADDI   :
+        case SUBI   : executer_pull_cmd(cpu, &cur_cmd->reg        , sizeof(REGISTER));
+                      executer_pull_cmd(cpu, &cur_cmd->arg.int_num, sizeof(int));
+                      return true;
+        case ADD_MEM: executer_pull_cmd(cpu, &cur_cmd->reg             , sizeof(REGISTER));
+                      executer_pull_cmd(cpu,  cur_cmd->arg.ram_index   , sizeof(int));
+                      executer_pull_cmd(cpu,  cur_cmd->arg.ram_index + 1, sizeof(int));
+                      return true;
+        case MEM_OP : {
+                        int offset = 0;
+
+                        executer_pull_cmd(cpu, &cur_cmd->param      , sizeof(unsigned char));
+                        executer_pull_cmd(cpu, &cur_cmd->reg        , sizeof(REGISTER));
+                        executer_pull_cmd(cpu, &offset              , sizeof(int));
+                        if (!decode_dbl(cpu, &cur_cmd->arg.dbl_num, cmd_beg)) return false;
+
+                        if (offset < SHRT_MIN || offset > SHRT_MAX)
+                        {
+                            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "ram offset at byte %d is too big\n", cmd_beg);
+                            return false;
+                        }
+                        cur_cmd->offset = (short) offset;
+                        return true;
+                      }
+        default  : return true;
+    }
+    return true;
+}
+
+/*===========================================================================================================================*/
+// COMPACT
+/*===========================================================================================================================*/
+
+/**
+*   @brief Декодирует очередную инструкцию компактного кода.
+*
+*   @param cpu      [in][out] - исполнитель, cpu->pc указывает на начало инструкции
+*   @param cur_cmd      [out] - декодированная инструкция
+*   @param pc_index [in]      - таблица перевода смещений в байтах в индексы инструкций (nullptr - метки не переводятся,
+*                               только определяется граница инструкции)
+*
+*   @note Регистр - один байт, целые числа - zigzag varint, действительные - varint-индекс в пуле констант,
+*         метки - смещение относительно начала перехода: short или int при COMPACT_LONG_JUMP.
+*/
+
+bool decode_compact(executer *const cpu, instruction *const cur_cmd, const int *const pc_index)
+{
+    assert(cpu     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const int     cmd_beg = cpu->pc;
+    unsigned char cmd     = 0;
+    unsigned char reg     = 0;
+
+    if (!compact_pull(cpu, &cmd, sizeof(unsigned char))) return false;
+
+    *cur_cmd     = {};
+    cur_cmd->cmd = cmd;
+    cur_cmd->reg = ERR_REG;
+
+    switch (cmd & 31) // 5 bit for cmd_asm
+    {
+        case COMPACT_PUSH_SMALL: cur_cmd->cmd         = PUSH;
+                                 cur_cmd->param       = 1 << PARAM_NUM;
+                                 cur_cmd->arg.dbl_num = cmd >> 5;
+                                 return true;
+        case COMPACT_PUSH_MEM  :
+        case COMPACT_POP_MEM   : cur_cmd->cmd   = ((cmd & 31) == COMPACT_PUSH_MEM) ? PUSH : POP;
+                                 cur_cmd->param = (1 << PARAM_MEM) | (1 << PARAM_REG) | (1 << PARAM_NUM);
+                                 cur_cmd->reg   = (REGISTER) ((cmd >> 5) + 1);
+                                 return compact_pull_int(cpu, &cur_cmd->arg.int_num);
+        case PUSH:
+        case POP : cur_cmd->cmd   = cmd &  31;
+                   cur_cmd->param = cmd & (unsigned char) ~31;
+
+                   if (cmd & (1 << PARAM_REG))
+                   {
+                       if (!compact_pull(cpu, &reg, sizeof(unsigned char))) return false;
+                       cur_cmd->reg = (REGISTER) reg;
+                   }
+                   if (!(cmd & (1 << PARAM_NUM))) return true;
+
+                   if ((cmd & (1 << PARAM_MEM)) || (cmd & 31) == POP) return compact_pull_int  (cpu, &cur_cmd->arg.int_num);
+                   else                                               return compact_pull_const(cpu, &cur_cmd->arg.dbl_num);
+        default  : break;
+    }
+
+    const unsigned char jump = cmd & (unsigned char) ~COMPACT_LONG_JUMP;
+
+    if (has_label_operand(jump))
+    {
+        int shift = 0;
+        cur_cmd->cmd = jump;
+
+        if (cmd & COMPACT_LONG_JUMP) { if (!compact_pull(cpu, &shift, sizeof(int)))    return false; }
+        else
+        {
+            short short_shift = 0;
+            if (!compact_pull(cpu, &short_shift, sizeof(short))) return false;
+            shift = short_shift;
+        }
+        if (pc_index == nullptr) return true;
+
+        const long long label_pc = (long long) cmd_beg + shift;
+        if (label_pc < 0 || label_pc >= cpu->capacity || pc_index[label_pc] == -1)
+        {
+            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "label at byte %d pointed out of instruction boundary\n", cmd_beg);
+            return false;
+        }
+        cur_cmd->arg.label = pc_index[label_pc];
+        return true;
+    }
+
+    if (cmd >= UNDEF_ASM_CMD)
+    {
+        fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "undefined command at byte %d\n", cmd_beg);
+        return false;
+    }
+
+    switch (cmd)
+    {
+        case ADD_REG: if (!compact_pull(cpu, &reg, sizeof(unsigned char))) return false;
+                      cur_cmd->reg = (REGISTER) reg;
+                      return compact_pull_const(cpu, &cur_cmd->arg.dbl_num);
+        case ADDI   :
+        case SUBI   : if (!compact_pull(cpu, &reg, sizeof(unsigned char))) return false;
+                      cur_cmd->reg = (REGISTER) reg;
+                      return compact_pull_int(cpu, &cur_cmd->arg.int_num);
+        case ADD_MEM: if (!compact_pull(cpu, &reg, sizeof(unsigned char))) return false;
+                      cur_cmd->reg = (REGISTER) reg;
+                      return compact_pull_int(cpu, cur_cmd->arg.ram_index) && compact_pull_int(cpu, cur_cmd->arg.ram_index + 1);
+        case MEM_OP : {
+                        int offset = 0;
+
+                        if (!compact_pull(cpu, &cur_cmd->param, sizeof(unsigned char)) || !compact_pull(cpu, &reg, sizeof(unsigned char)) ||
+                            !compact_pull_int(cpu, &offset) || !compact_pull_const(cpu, &cur_cmd->arg.dbl_num)) return false;
+
+                        cur_cmd->reg = (REGISTER) reg;
+                        if (offset < SHRT_MIN || offset > SHRT_MAX)
+                        {
+                            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "ram offset at byte %d is too big\n", cmd_beg);
+                            return false;
+                        }
+                        cur_cmd->offset = (short) offset;
+                        return true;
+                      }
+        default  : return true;
+    }
+    return true;
+}
+
+bool compact_pull(executer *const cpu, void *const pull_in, const size_t pull_size)
+{
+    assert(cpu     != nullptr);
+    assert(pull_in != nullptr);
+
+    if ((size_t) cpu->pc + pull_size > (size_t) cpu->capacity)
+    {
+        fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "no parameter at the end of file\n");
+        return false;
+    }
+    executer_pull_cmd(cpu, pull_in, pull_size);
+    return true;
+}
+
+/**
+*   @brief Читает беззнаковое число: по 7 бит в байте, начиная с младших, старший бит байта - есть ли продолжение.
+*/
+
+bool compact_pull_varint(executer *const cpu, unsigned *const num)
+{
+    assert(cpu != nullptr);
+    assert(num != nullptr);
+
+    *num = 0;
+    for (int i = 0; i < VARINT_MAX_SIZE; ++i)
+    {
+        unsigned char byte = 0;
+        if (!compact_pull(cpu, &byte, sizeof(unsigned char))) return false;
+
+        *num |= (unsigned) (byte & 127) << (7 * i);
+        if (!(byte & 128)) return true;
+    }
+
+    fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "too long number at byte %d\n", cpu->pc);
+    return false;
+}
+
+/**
+*   @brief Читает знаковое число, записанное varint после zigzag-преобразования (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...).
+*/
+
+bool compact_pull_int(executer *const cpu, int *const num)
+{
+    assert(cpu != nullptr);
+    assert(num != nullptr);
+
+    unsigned zigzag = 0;
+    if (!compact_pull_varint(cpu, &zigzag)) return false;
+
+    *num = (int) (zigzag >> 1) ^ -(int) (zigzag & 1);
+    return true;
+}
+
+bool compact_pull_const(executer *const cpu, double *const num)
+{
+    assert(cpu != nullptr);
+    assert(num != nullptr);
+
+    unsigned index = 0;
+    if (!compact_pull_varint(cpu, &index)) return false;
+
+    if (cpu->pool == nullptr || index >= (unsigned) cpu->pool_size)
+    {
+        fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "constant at byte %d is out of constant pool\n", cpu->pc);
+        return false;
+    }
+    *num = cpu->pool[index];
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef DECODER
+#define DECODER
+
+#include "cpu.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+enum COMPACT_CMD                        // команды, которые есть только в компактной кодировке (см. binary_compact_code())
+{
+    COMPACT_PUSH_SMALL = UNDEF_ASM_CMD, // push k, k = 0..COMPACT_SMALL_MAX в старших битах байта команды
+    COMPACT_PUSH_MEM                  , // push [reg + off], reg - 1 в старших битах, off - varint
+    COMPACT_POP_MEM                   , // pop  [reg + off]
+};
+
+const int COMPACT_SMALL_MAX = 7;        // наибольшее число в COMPACT_PUSH_SMALL
+const int COMPACT_LONG_JUMP = 1 << 5;   // бит длинного перехода: смещение метки int вместо short
+const int VARINT_MAX_SIZE   = 5;        // наибольший размер varint для 32-битного числа
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct instruction          // декодированная инструкция фиксированного размера
+{
+    unsigned char cmd;      // ASM_CMD
+    unsigned char param;    // биты PARAM_NUM, PARAM_REG, PARAM_MEM (для PUSH и POP), операция ADD, SUB, MUL или DIV (для MEM_OP)
+    short         offset;   // смещение в RAM относительно регистра (для MEM_OP), занимает место выравнивания
+    REGISTER      reg;      // регистр-параметр (ERR_REG, если его нет)
+    union
+    {
+        int    int_num;     // целое число-параметр (индекс в RAM, операнд ADDI и SUBI)
+        double dbl_num;     // действительное число-параметр
+        int    label;       // индекс инструкции, на которую указывает метка (для JMP, Jxx, JZ, CALL)
+        int    ram_index[2];  // смещения слагаемых в RAM относительно регистра (для ADD_MEM)
+    }
+    arg;
+};
+
+static_assert(sizeof(instruction) == 16, "instruction is written as is in ENCODING_ALIGNED (see binary_align_code())");
+
+struct program              // декодированный бинарный код исполнителя
+{
+    instruction *cmd;       // массив декодированных инструкций, заканчивающийся HLT
+    int          size;      // количество инструкций в .cmd (без завершающего HLT)
+
+    const char **name;      // name[i] - метка перед инструкцией i или nullptr (.name == nullptr, если символов нет)
+    int         *line;      // line[i] - строка исходного кода инструкции i или 0 (.line == nullptr, если строк нет)
+    char        *names;     // имена меток, на которые указывает .name
+};
+
+/*===========================================================================================================================*/
+// PROGRAM_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool program_ctor         (program *const prog, executer *const cpu);
+bool program_aligned_ctor (program *const prog, const executer *const cpu);
+bool program_compact_ctor (program *const prog, executer *const cpu);
+void program_dtor         (program *const prog);
+
+/*===========================================================================================================================*/
+// DECODE
+/*===========================================================================================================================*/
+
+int  get_instruction_size (const unsigned char cmd, const bool pool = false);
+bool has_dbl_operand      (const unsigned char cmd);
+bool has_label_operand    (const unsigned char cmd);
+bool decode_instruction   (executer *const cpu, instruction *const cur_cmd, const int *const pc_index);
+bool decode_dbl           (executer *const cpu, double *const num, const int cmd_beg);
+bool check_aligned        (const instruction *const cur_cmd, const int size, const int index);
+
+/*===========================================================================================================================*/
+// COMPACT
+/*===========================================================================================================================*/
+
+bool decode_compact       (executer *const cpu, instruction *const cur_cmd, const int *const pc_index);
+bool compact_pull         (executer *const cpu, void *const pull_in, const size_t pull_size);
+bool compact_pull_varint  (executer *const cpu, unsigned *const num);
+bool compact_pull_int     (executer *const cpu, int *const num);
+bool compact_pull_const   (executer *const cpu, double *const num);
+
+#endif //DECODER
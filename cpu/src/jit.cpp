@@ -0,0 +1,1032 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __x86_64__
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "../../lib/logs/log.h"
+#include "../../lib/algorithm/algorithm.h"
+
+#include "terminal_colors.h"
+#include "jit.h"
+
+// смещение элемента k стека данных относительно r12 (начала кадра текущей функции)
+#define slot(k) ((k) * (int) sizeof(cpu_type))
+
+// смещения полей, к которым обращается скомпилированный код
+#define rt_offset(field)  (int) offsetof(jit_runtime, field)
+#define reg_offset(reg)  ((int) offsetof(machine, int_reg) + (int) (reg) * (int) sizeof(int))
+#define dbl_offset(reg)  ((int) offsetof(machine, dbl_reg) + (int) (reg) * (int) sizeof(double))
+
+/*===========================================================================================================================*/
+// COMPILE
+/*===========================================================================================================================*/
+
+/**
+*   @brief Компилирует программу в jit->code.
+*
+*   @note Код начинается с функции void entry(jit_runtime *rt) и не зависит от адреса, по которому будет лежать.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool jit_compile(jit_code *const jit, const program *const prog)
+{
+    assert(jit  != nullptr);
+    assert(prog != nullptr);
+
+    jit_compile_prologue(jit);
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        jit->cmd_pos[i] = jit->size;
+
+        const instruction *cur_cmd = prog->cmd + i;
+        const int          d       = jit->depth[i];
+
+        if (d != UNKNOWN_DEPTH && cur_cmd->cmd == CALL && i + 1 < prog->size && jit->is_func[i + 1])
+        {
+            log_message("JIT: CALL at instruction %d falls through into function %d\n", i, i + 1);
+            return false;
+        }
+        jit_compile_cmd(jit, prog, i);
+    }
+    jit->cmd_pos[prog->size] = jit->size;
+    jit_emit_jump(jit, 0, jit->exit_pos); // завершающий HLT
+
+    for (int i = 0; i < jit->fixup_size; ++i)
+    {
+        const int rel = jit->cmd_pos[jit->fixup[i].label] - (jit->fixup[i].pos + (int) sizeof(int));
+        memcpy(jit->code + jit->fixup[i].pos, &rel, sizeof(int));
+    }
+
+    return true;
+}
+
+/**
+*   @brief Копирует скомпилированный код в исполняемую память.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool jit_load(jit_code *const jit)
+{
+    assert(jit != nullptr);
+
+#ifdef __x86_64__
+    jit->exec_size = (size_t) jit->size;
+    jit->exec      = mmap(nullptr, jit->exec_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (jit->exec == MAP_FAILED)
+    {
+        jit->exec = nullptr;
+        log_error("can't map memory for compiled code(%d)\n", __LINE__);
+        return false;
+    }
+    memcpy(jit->exec, jit->code, jit->exec_size);
+
+    if (mprotect(jit->exec, jit->exec_size, PROT_READ | PROT_EXEC) != 0)
+    {
+        log_error("can't make compiled code executable(%d)\n", __LINE__);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+*   @brief Компилирует вход в скомпилированный код, выход из него и заглушки ошибок времени исполнения.
+*
+*   @note Вход: void entry(jit_runtime *rt). Сохраняет callee-saved регистры, переходит на стек rt->stack_top и загружает
+*         r15 = rt, r12 = rt->data, r13 = rt->data_end, r14 = rt->computer, rbp = rt->call_capacity.
+*   @note Заглушка ошибки записывает код в rt->error и уходит на выход, который восстанавливает rsp из rt->saved_rsp.
+*/
+
+void jit_compile_prologue(jit_code *const jit)
+{
+    assert(jit != nullptr);
+
+    jit_emit_byte(jit, 0x53);                                                       // push rbx
+    jit_emit_byte(jit, 0x55);                                                       // push rbp
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x54);                             // push r12
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x55);                             // push r13
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x56);                             // push r14
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x57);                             // push r15
+
+    jit_emit_reg(jit, 0, true, 0x89, 1, X86_RDI, X86_R15);                          // mov r15, rdi
+    jit_emit_mem(jit, 0, true, 0x89, 1, X86_RSP, X86_R15, -1, rt_offset(saved_rsp));     // mov [r15 + saved_rsp], rsp
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_RSP, X86_R15, -1, rt_offset(stack_top));     // mov rsp, [r15 + stack_top]
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_R12, X86_R15, -1, rt_offset(data));          // mov r12, [r15 + data]
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_R13, X86_R15, -1, rt_offset(data_end));      // mov r13, [r15 + data_end]
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_R14, X86_R15, -1, rt_offset(computer));      // mov r14, [r15 + computer]
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_RBP, X86_R15, -1, rt_offset(call_capacity)); // mov rbp, [r15 + call_capacity]
+    jit_emit_label(jit, 0, 0);                                                      // jmp <instruction 0>
+
+    jit->exit_pos = jit->size;
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_RSP, X86_R15, -1, rt_offset(saved_rsp));     // mov rsp, [r15 + saved_rsp]
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x5F);                             // pop r15
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x5E);                             // pop r14
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x5D);                             // pop r13
+    jit_emit_byte(jit, 0x41); jit_emit_byte(jit, 0x5C);                             // pop r12
+    jit_emit_byte(jit, 0x5D);                                                       // pop rbp
+    jit_emit_byte(jit, 0x5B);                                                       // pop rbx
+    jit_emit_byte(jit, 0xC3);                                                       // ret
+
+    for (int err = JIT_OK + 1; err < JIT_ERROR_NUMBER; ++err)
+    {
+        jit->err_pos[err] = jit->size;
+        jit_emit_mem (jit, 0, false, 0xC7, 1, 0, X86_R15, -1, rt_offset(error));    // mov dword [r15 + error], err
+        jit_emit_int (jit, err);
+        jit_emit_jump(jit, 0, jit->exit_pos);                                       // jmp exit
+    }
+}
+
+/**
+*   @brief Компилирует инструкцию prog->cmd[index].
+*/
+
+void jit_compile_cmd(jit_code *const jit, const program *const prog, const int index)
+{
+    assert(jit  != nullptr);
+    assert(prog != nullptr);
+
+    const instruction *cur_cmd = prog->cmd + index;
+    const int          d       = jit->depth[index];
+
+    if (d == UNKNOWN_DEPTH)     // недостижимая инструкция
+    {
+        jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, 0x0B);                         // ud2
+        return;
+    }
+
+    int next_depth = d;         // глубина стека при переходе к следующей инструкции
+
+    switch (cur_cmd->cmd)
+    {
+        case HLT : jit_emit_jump(jit, 0, jit->exit_pos);
+                   return;
+
+        case IN  : jit_compile_helper  (jit, rt_offset(in), true);
+                   jit_compile_overflow(jit, d, JIT_IN_OVERFLOW);
+                   jit_emit_mem        (jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d));          // movsd [d], xmm0
+                   next_depth = d + 1;
+                   break;
+
+        case OUT : jit_emit_mem        (jit, 0xF2, false, 0x0F10, 2, 0, X86_R12, -1, slot(d - 1));      // movsd xmm0, [d - 1]
+                   jit_compile_helper  (jit, rt_offset(out), false);
+                   break;
+
+        case PUSH: jit_compile_push(jit, cur_cmd, d);
+                   next_depth = d + 1;
+                   break;
+
+        case POP : jit_compile_pop(jit, cur_cmd, d);
+                   next_depth = d - 1;
+                   break;
+
+        case JMP : jit_compile_goto(jit, 0, cur_cmd->arg.label, d);
+                   return;
+
+        case JA  :
+        case JAE :
+        case JB  :
+        case JBE :
+        case JE  :
+        case JNE : jit_compile_jcc(jit, cur_cmd, d);
+                   next_depth = d - 2;
+                   break;
+
+        case JZ  : jit_emit_mem            (jit, 0xF2, false, 0x0F10, 2, 0, X86_R12, -1, slot(d - 1));    // movsd xmm0, [d - 1]
+                   jit_emit_reg            (jit, 0x66, false, 0x0F57, 2, 1, 1);                           // xorpd xmm1, xmm1
+                   jit_compile_approx_equal(jit);
+                   jit_compile_goto        (jit, X86_JAE, cur_cmd->arg.label, d - 1);
+                   next_depth = d - 1;
+                   break;
+
+        case ADD_REG: jit_compile_add_reg(jit, cur_cmd);
+                      break;
+
+        case ADDI   : jit_emit_mem(jit, 0, false, 0x81, 1, 0, X86_R14, -1, reg_offset(cur_cmd->reg));              // add dword [reg], num
+                      jit_emit_int(jit, cur_cmd->arg.int_num);
+                      break;
+
+        case SUBI   : jit_emit_mem(jit, 0, false, 0x81, 1, 5, X86_R14, -1, reg_offset(cur_cmd->reg));              // sub dword [reg], num
+                      jit_emit_int(jit, cur_cmd->arg.int_num);
+                      break;
+
+        case ADD_MEM: jit_compile_add_mem(jit, cur_cmd, d);
+                      next_depth = d + 1;
+                      break;
+
+        case MEM_OP : jit_compile_mem_op(jit, cur_cmd, d);
+                      next_depth = d + 1;
+                      break;
+
+        case CALL: jit_emit_reg  (jit, 0, true, 0x83, 1, 5, X86_RBP); jit_emit_byte(jit, 1);             // sub rbp, 1
+                   jit_emit_jump (jit, X86_JB, jit->err_pos[JIT_CALL_OVERFLOW]);
+                   jit_emit_byte (jit, 0x41); jit_emit_byte(jit, 0x54);                                   // push r12
+                   if (d != 0)
+                   {
+                       jit_emit_reg(jit, 0, true, 0x81, 1, 0, X86_R12); jit_emit_int(jit, slot(d));        // add r12, 8 * d
+                   }
+                   jit_emit_call (jit, cur_cmd->arg.label);
+                   jit_emit_byte (jit, 0x41); jit_emit_byte(jit, 0x5C);                                   // pop r12
+                   jit_emit_reg  (jit, 0, true, 0x83, 1, 0, X86_RBP); jit_emit_byte(jit, 1);             // add rbp, 1
+                   return;
+
+        case RET : jit_emit_byte(jit, 0xC3);                                                              // ret
+                   return;
+
+        case ADD :
+        case SUB :
+        case MUL : {
+                        const unsigned opcode = (cur_cmd->cmd == ADD) ? 0x0F58 :                          // addsd
+                                                (cur_cmd->cmd == SUB) ? 0x0F5C : 0x0F59;                  // subsd : mulsd
+
+                        jit_emit_mem(jit, 0xF2, false, 0x0F10, 2, 0, X86_R12, -1, slot(d - 2));           // movsd xmm0, [d - 2]
+                        jit_emit_mem(jit, 0xF2, false, opcode, 2, 0, X86_R12, -1, slot(d - 1));           // op    xmm0, [d - 1]
+                        jit_emit_mem(jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d - 2));           // movsd [d - 2], xmm0
+                        next_depth = d - 1;
+                        break;
+                   }
+
+        case DIV : jit_emit_mem (jit, 0xF2, false, 0x0F10, 2, 1, X86_R12, -1, slot(d - 1));               // movsd   xmm1, [d - 1]
+                   jit_emit_reg (jit, 0x66, false, 0x0F28, 2, 2, 1);                                      // movapd  xmm2, xmm1
+                   jit_emit_mem (jit, 0x66, false, 0x0F54, 2, 2, X86_R15, -1, rt_offset(abs_mask));       // andpd   xmm2, [abs_mask]
+                   jit_emit_mem (jit, 0xF2, false, 0x0F10, 2, 3, X86_R15, -1, rt_offset(delta));          // movsd   xmm3, [delta]
+                   jit_emit_reg (jit, 0x66, false, 0x0F2E, 2, 3, 2);                                      // ucomisd xmm3, xmm2
+                   jit_emit_jump(jit, X86_JAE, jit->err_pos[JIT_DIV_ZERO]);
+                   jit_emit_mem (jit, 0xF2, false, 0x0F10, 2, 0, X86_R12, -1, slot(d - 2));               // movsd   xmm0, [d - 2]
+                   jit_emit_reg (jit, 0xF2, false, 0x0F5E, 2, 0, 1);                                      // divsd   xmm0, xmm1
+                   jit_emit_mem (jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d - 2));               // movsd   [d - 2], xmm0
+                   next_depth = d - 1;
+                   break;
+
+        case POW : jit_emit_mem      (jit, 0xF2, false, 0x0F10, 2, 0, X86_R12, -1, slot(d - 2));          // movsd xmm0, [d - 2]
+                   jit_emit_mem      (jit, 0xF2, false, 0x0F10, 2, 1, X86_R12, -1, slot(d - 1));          // movsd xmm1, [d - 1]
+                   jit_compile_helper(jit, rt_offset(pow), true);
+                   jit_emit_mem      (jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d - 2));          // movsd [d - 2], xmm0
+                   next_depth = d - 1;
+                   break;
+
+        case SQRT:
+        case SIN :
+        case COS :
+        case LOG : {
+                        const int helper = (cur_cmd->cmd == SQRT) ? rt_offset(sqrt) :
+                                           (cur_cmd->cmd == SIN ) ? rt_offset(sin ) :
+                                           (cur_cmd->cmd == COS ) ? rt_offset(cos ) : rt_offset(log);
+
+                        jit_emit_mem      (jit, 0xF2, false, 0x0F10, 2, 0, X86_R12, -1, slot(d - 1));     // movsd xmm0, [d - 1]
+                        jit_compile_helper(jit, helper, cur_cmd->cmd == SQRT || cur_cmd->cmd == LOG);
+                        jit_emit_mem      (jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d - 1));     // movsd [d - 1], xmm0
+                        break;
+                   }
+
+        default  : log_error("default case in jit_compile_cmd(): cmd=%d(%d)\n", cur_cmd->cmd, __LINE__);
+                   jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, 0x0B);                                    // ud2
+                   return;
+    }
+
+    if (index + 1 < prog->size && jit->is_func[index + 1] && next_depth != 0)
+    {
+        // проваливание в начало функции - хвостовой вызов: кадр функции начинается на текущей глубине
+        jit_emit_reg(jit, 0, true, 0x81, 1, 0, X86_R12); jit_emit_int(jit, slot(next_depth));             // add r12, 8 * next_depth
+    }
+}
+
+void jit_compile_push(jit_code *const jit, const instruction *const cur_cmd, const int d)
+{
+    assert(jit     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const unsigned char param = cur_cmd->param;
+    const REGISTER    reg_arg = cur_cmd->reg;
+
+    if (param & (1 << PARAM_MEM))
+    {
+        jit_compile_ram_index(jit, cur_cmd, JIT_PUSH_RAM);
+        jit_emit_mem         (jit, 0, true, 0x8B, 1, X86_RAX, X86_RCX, X86_RAX, 0);                          // mov rax, [rcx + rax * 8]
+        jit_compile_overflow (jit, d, JIT_PUSH_OVERFLOW);
+        jit_emit_mem         (jit, 0, true, 0x89, 1, X86_RAX, X86_R12, -1, slot(d));                         // mov [d], rax
+        return;
+    }
+
+    if (!(param & (1 << PARAM_REG)))
+    {
+        long long bits = 0;
+        double    num1 = 0;
+
+        if (param & (1 << PARAM_NUM)) num1 += cur_cmd->arg.dbl_num;
+        memcpy(&bits, &num1, sizeof(double));
+
+        jit_emit_byte       (jit, 0x48); jit_emit_byte(jit, 0xB8); jit_emit_long(jit, bits);                // mov rax, imm64
+        jit_compile_overflow(jit, d, JIT_PUSH_OVERFLOW);
+        jit_emit_mem        (jit, 0, true, 0x89, 1, X86_RAX, X86_R12, -1, slot(d));                          // mov [d], rax
+        return;
+    }
+
+    if (param & (1 << PARAM_NUM))
+    {
+        long long bits = 0;
+        double    num1 = 0;
+
+        num1 += cur_cmd->arg.dbl_num;
+        memcpy(&bits, &num1, sizeof(double));
+
+        jit_emit_byte(jit, 0x48); jit_emit_byte(jit, 0xB8); jit_emit_long(jit, bits);                       // mov  rax, imm64
+        jit_emit_reg (jit, 0x66, true, 0x0F6E, 2, 0, X86_RAX);                                              // movq xmm0, rax
+    }
+    else jit_emit_reg(jit, 0x66, false, 0x0F57, 2, 0, 0);                                                    // xorpd xmm0, xmm0
+
+    if (is_int_reg(reg_arg))
+    {
+        jit_emit_mem(jit, 0xF2, false, 0x0F2A, 2, 1, X86_R14, -1, reg_offset(reg_arg));                      // cvtsi2sd xmm1, dword [reg]
+        jit_emit_reg(jit, 0xF2, false, 0x0F58, 2, 0, 1);                                                     // addsd    xmm0, xmm1
+    }
+    else jit_emit_mem(jit, 0xF2, false, 0x0F58, 2, 0, X86_R14, -1, dbl_offset(reg_arg));                     // addsd    xmm0, [reg]
+
+    jit_compile_overflow(jit, d, JIT_PUSH_OVERFLOW);
+    jit_emit_mem        (jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d));                              // movsd [d], xmm0
+}
+
+void jit_compile_pop(jit_code *const jit, const instruction *const cur_cmd, const int d)
+{
+    assert(jit     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const unsigned char param = cur_cmd->param;
+    const REGISTER    reg_arg = cur_cmd->reg;
+
+    if (param & (1 << PARAM_MEM))
+    {
+        jit_compile_ram_index(jit, cur_cmd, JIT_POP_RAM);
+        jit_emit_mem         (jit, 0, true, 0x8B, 1, X86_RDX, X86_R12, -1, slot(d - 1));                     // mov rdx, [d - 1]
+        jit_emit_mem         (jit, 0, true, 0x89, 1, X86_RDX, X86_RCX, X86_RAX, 0);                          // mov [rcx + rax * 8], rdx
+        return;
+    }
+    if (!(param & (1 << PARAM_REG))) return; // pop void
+
+    if (is_int_reg(reg_arg))
+    {
+        jit_emit_mem(jit, 0xF2, false, 0x0F2C, 2, X86_RAX, X86_R12, -1, slot(d - 1));                        // cvttsd2si eax, [d - 1]
+        jit_emit_mem(jit, 0, false, 0x89, 1, X86_RAX, X86_R14, -1, reg_offset(reg_arg));                     // mov [reg], eax
+        return;
+    }
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_RAX, X86_R12, -1, slot(d - 1));                                  // mov rax, [d - 1]
+    jit_emit_mem(jit, 0, true, 0x89, 1, X86_RAX, X86_R14, -1, dbl_offset(reg_arg));                          // mov [reg], rax
+}
+
+/**
+*   @brief Компилирует условный переход: num1 = [d - 2], num2 = [d - 1].
+*
+*   @note Сравнения повторяют execute_jump(): JE и JNE - через approx_equal(), JAE и JBE - строгое сравнение или approx_equal().
+*/
+
+void jit_compile_jcc(jit_code *const jit, const instruction *const cur_cmd, const int d)
+{
+    assert(jit     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const int label = cur_cmd->arg.label;
+
+    jit_emit_mem(jit, 0xF2, false, 0x0F10, 2, 0, X86_R12, -1, slot(d - 2));                                 // movsd xmm0, [d - 2]
+    jit_emit_mem(jit, 0xF2, false, 0x0F10, 2, 1, X86_R12, -1, slot(d - 1));                                 // movsd xmm1, [d - 1]
+
+    switch (cur_cmd->cmd)
+    {
+        case JA  :
+        case JAE : jit_emit_reg    (jit, 0x66, false, 0x0F2E, 2, 0, 1);                                      // ucomisd xmm0, xmm1
+                   jit_compile_goto(jit, X86_JA, label, d - 2);
+                   break;
+        case JB  :
+        case JBE : jit_emit_reg    (jit, 0x66, false, 0x0F2E, 2, 1, 0);                                      // ucomisd xmm1, xmm0
+                   jit_compile_goto(jit, X86_JA, label, d - 2);
+                   break;
+        default  : break;
+    }
+
+    switch (cur_cmd->cmd)
+    {
+        case JAE :
+        case JBE :
+        case JE  : jit_compile_approx_equal(jit);
+                   jit_compile_goto        (jit, X86_JAE, label, d - 2);
+                   break;
+        case JNE : jit_compile_approx_equal(jit);
+                   jit_compile_goto        (jit, X86_JB , label, d - 2);
+                   break;
+        default  : break;
+    }
+}
+
+/**
+*   @brief Компилирует ADD_REG: reg += num.
+*
+*   @note Целое число прибавляется к целочисленному регистру одной инструкцией add,
+*         в остальных случаях сложение, как и в интерпретаторе, выполняется в double.
+*/
+
+void jit_compile_add_reg(jit_code *const jit, const instruction *const cur_cmd)
+{
+    assert(jit     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const REGISTER reg_arg = cur_cmd->reg;
+    const double   num     = cur_cmd->arg.dbl_num;
+
+    if (is_int_reg(reg_arg) && -2147483648.0 <= num && num <= 2147483647.0 && !((int) num < num) && !((int) num > num))
+    {
+        jit_emit_mem(jit, 0, false, 0x81, 1, 0, X86_R14, -1, reg_offset(reg_arg));                          // add dword [reg], num
+        jit_emit_int(jit, (int) num);
+        return;
+    }
+
+    long long bits = 0;
+    memcpy(&bits, &num, sizeof(double));
+
+    jit_emit_byte(jit, 0x48); jit_emit_byte(jit, 0xB8); jit_emit_long(jit, bits);                           // mov  rax, imm64
+    jit_emit_reg (jit, 0x66, true, 0x0F6E, 2, 1, X86_RAX);                                                  // movq xmm1, rax
+
+    if (is_int_reg(reg_arg))
+    {
+        jit_emit_mem(jit, 0xF2, false, 0x0F2A, 2, 0, X86_R14, -1, reg_offset(reg_arg));                      // cvtsi2sd  xmm0, dword [reg]
+        jit_emit_reg(jit, 0xF2, false, 0x0F58, 2, 0, 1);                                                     // addsd     xmm0, xmm1
+        jit_emit_reg(jit, 0xF2, false, 0x0F2C, 2, X86_RAX, 0);                                               // cvttsd2si eax, xmm0
+        jit_emit_mem(jit, 0, false, 0x89, 1, X86_RAX, X86_R14, -1, reg_offset(reg_arg));                     // mov       [reg], eax
+        return;
+    }
+    jit_emit_mem(jit, 0xF2, false, 0x0F10, 2, 0, X86_R14, -1, dbl_offset(reg_arg));                          // movsd xmm0, [reg]
+    jit_emit_reg(jit, 0xF2, false, 0x0F58, 2, 0, 1);                                                         // addsd xmm0, xmm1
+    jit_emit_mem(jit, 0xF2, false, 0x0F11, 2, 0, X86_R14, -1, dbl_offset(reg_arg));                          // movsd [reg], xmm0
+}
+
+/**
+*   @brief Компилирует ADD_MEM: push [reg + n] + [reg + m].
+*/
+
+void jit_compile_add_mem(jit_code *const jit, const instruction *const cur_cmd, const int d)
+{
+    assert(jit     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    instruction ram_arg = {};   // операнд [reg + n] в виде параметра PUSH, см. jit_compile_ram_index()
+
+    ram_arg.cmd   = PUSH;
+    ram_arg.param = (1 << PARAM_MEM) | (1 << PARAM_REG) | (1 << PARAM_NUM);
+    ram_arg.reg   = cur_cmd->reg;
+
+    ram_arg.arg.int_num = cur_cmd->arg.ram_index[0];
+    jit_compile_ram_index(jit, &ram_arg, JIT_PUSH_RAM);
+    jit_emit_mem         (jit, 0xF2, false, 0x0F10, 2, 0, X86_RCX, X86_RAX, 0);                             // movsd xmm0, [rcx + rax * 8]
+
+    ram_arg.arg.int_num = cur_cmd->arg.ram_index[1];
+    jit_compile_ram_index(jit, &ram_arg, JIT_PUSH_RAM);
+    jit_emit_mem         (jit, 0xF2, false, 0x0F58, 2, 0, X86_RCX, X86_RAX, 0);                             // addsd xmm0, [rcx + rax * 8]
+
+    jit_compile_overflow (jit, d, JIT_PUSH_OVERFLOW);
+    jit_emit_mem         (jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d));                             // movsd [d], xmm0
+}
+
+/**
+*   @brief Компилирует MEM_OP: push [reg + n] op num.
+*
+*   @note Число известно при компиляции, поэтому деление на ноль сразу становится переходом на заглушку ошибки.
+*/
+
+void jit_compile_mem_op(jit_code *const jit, const instruction *const cur_cmd, const int d)
+{
+    assert(jit     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const double num = cur_cmd->arg.dbl_num;
+
+    if (cur_cmd->param == DIV && approx_equal(num, 0))
+    {
+        jit_emit_jump(jit, 0, jit->err_pos[JIT_DIV_ZERO]);
+        return;
+    }
+
+    const unsigned opcode = (cur_cmd->param == ADD) ? 0x0F58 :                                              // addsd
+                            (cur_cmd->param == SUB) ? 0x0F5C :                                              // subsd
+                            (cur_cmd->param == MUL) ? 0x0F59 : 0x0F5E;                                      // mulsd : divsd
+
+    instruction ram_arg = {};   // операнд [reg + n] в виде параметра PUSH, см. jit_compile_ram_index()
+
+    ram_arg.cmd         = PUSH;
+    ram_arg.param       = (1 << PARAM_MEM) | (1 << PARAM_REG) | (1 << PARAM_NUM);
+    ram_arg.reg         = cur_cmd->reg;
+    ram_arg.arg.int_num = cur_cmd->offset;
+
+    long long bits = 0;
+    memcpy(&bits, &num, sizeof(double));
+
+    jit_compile_ram_index(jit, &ram_arg, JIT_PUSH_RAM);
+    jit_emit_mem         (jit, 0xF2, false, 0x0F10, 2, 0, X86_RCX, X86_RAX, 0);                             // movsd xmm0, [rcx + rax * 8]
+    jit_emit_byte        (jit, 0x48); jit_emit_byte(jit, 0xB8); jit_emit_long(jit, bits);                   // mov   rax, imm64
+    jit_emit_reg         (jit, 0x66, true, 0x0F6E, 2, 1, X86_RAX);                                          // movq  xmm1, rax
+    jit_emit_reg         (jit, 0xF2, false, opcode, 2, 0, 1);                                               // op    xmm0, xmm1
+    jit_compile_overflow (jit, d, JIT_PUSH_OVERFLOW);
+    jit_emit_mem         (jit, 0xF2, false, 0x0F11, 2, 0, X86_R12, -1, slot(d));                             // movsd [d], xmm0
+}
+
+/**
+*   @brief Сравнивает delta с |xmm0 - xmm1|: после него JAE - approx_equal(), JB - !approx_equal().
+*/
+
+void jit_compile_approx_equal(jit_code *const jit)
+{
+    assert(jit != nullptr);
+
+    jit_emit_reg(jit, 0x66, false, 0x0F28, 2, 2, 0);                                                         // movapd  xmm2, xmm0
+    jit_emit_reg(jit, 0xF2, false, 0x0F5C, 2, 2, 1);                                                         // subsd   xmm2, xmm1
+    jit_emit_mem(jit, 0x66, false, 0x0F54, 2, 2, X86_R15, -1, rt_offset(abs_mask));                          // andpd   xmm2, [abs_mask]
+    jit_emit_mem(jit, 0xF2, false, 0x0F10, 2, 3, X86_R15, -1, rt_offset(delta));                             // movsd   xmm3, [delta]
+    jit_emit_reg(jit, 0x66, false, 0x0F2E, 2, 3, 2);                                                         // ucomisd xmm3, xmm2
+}
+
+/**
+*   @brief Компилирует переход (jcc = 0 - безусловный) на инструкцию label с глубиной стека d.
+*
+*   @note Переход в начало функции - хвостовой вызов: r12 сдвигается на d, функция вернется туда же, куда текущая.
+*/
+
+void jit_compile_goto(jit_code *const jit, const unsigned char jcc, const int label, const int d)
+{
+    assert(jit != nullptr);
+
+    if (!jit->is_func[label] || d == 0)
+    {
+        jit_emit_label(jit, jcc, label);
+        return;
+    }
+
+    int skip_pos = 0;
+    if (jcc != 0)
+    {
+        jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, (unsigned char) (jcc ^ 1));                             // j!cc skip
+        skip_pos = jit->size;
+        jit_emit_int (jit, 0);
+    }
+    jit_emit_reg  (jit, 0, true, 0x81, 1, 0, X86_R12); jit_emit_int(jit, slot(d));                           // add r12, 8 * d
+    jit_emit_label(jit, 0, label);                                                                           // jmp label
+
+    if (jcc != 0)
+    {
+        const int rel = jit->size - (skip_pos + (int) sizeof(int));
+        memcpy(jit->code + skip_pos, &rel, sizeof(int));
+    }
+}
+
+/**
+*   @brief Вычисляет в rax индекс RAM операнда cur_cmd, проверяет его и загружает в rcx начало RAM.
+*
+*   @note Если RAM может расти (jit->ram_growable), индекс за границей передается в rt->grow(),
+*         который расширяет RAM или записывает ошибку err. xmm0 сохраняется: ADD_MEM держит в нем первое слагаемое.
+*/
+
+void jit_compile_ram_index(jit_code *const jit, const instruction *const cur_cmd, const JIT_ERROR err)
+{
+    assert(jit     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const unsigned char param = cur_cmd->param;
+
+    if (param & (1 << PARAM_REG))
+    {
+        jit_emit_mem(jit, 0, false, 0x8B, 1, X86_RAX, X86_R14, -1, reg_offset(cur_cmd->reg));                // mov eax, [reg]
+        if (param & (1 << PARAM_NUM)) { jit_emit_byte(jit, 0x05); jit_emit_int(jit, cur_cmd->arg.int_num); } // add eax, num
+    }
+    else
+    {
+        jit_emit_byte(jit, 0xB8);                                                                            // mov eax, num
+        jit_emit_int (jit, (param & (1 << PARAM_NUM)) ? cur_cmd->arg.int_num : 0);
+    }
+    jit_emit_mem(jit, 0, false, 0x3B, 1, X86_RAX, X86_R15, -1, rt_offset(ram_size));                         // cmp eax, [r15 + ram_size]
+
+    if (!jit->ram_growable)
+    {
+        jit_emit_jump(jit, X86_JAE, jit->err_pos[err]);                                                      // отрицательный индекс тоже >= как беззнаковый
+    }
+    else
+    {
+        jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, (unsigned char) X86_JB);                                // jb ok
+        const int ok_pos = jit->size;
+        jit_emit_int (jit, 0);
+
+        jit_emit_reg (jit, 0, true, 0x83, 1, 5, X86_RSP); jit_emit_byte(jit, 8);                             // sub   rsp, 8
+        jit_emit_mem (jit, 0xF2, false, 0x0F11, 2, 0, X86_RSP, -1, 0);                                       // movsd [rsp], xmm0
+        jit_emit_reg (jit, 0, false, 0x89, 1, X86_RAX, X86_RSI);                                             // mov   esi, eax
+        jit_emit_byte(jit, 0xBA); jit_emit_int(jit, err);                                                    // mov   edx, err
+        jit_compile_helper(jit, rt_offset(grow), true);                                                      // eax = rt->grow(rt, esi, edx)
+        jit_emit_mem (jit, 0xF2, false, 0x0F10, 2, 0, X86_RSP, -1, 0);                                       // movsd xmm0, [rsp]
+        jit_emit_reg (jit, 0, true, 0x83, 1, 0, X86_RSP); jit_emit_byte(jit, 8);                             // add   rsp, 8
+
+        const int rel = jit->size - (ok_pos + (int) sizeof(int));
+        memcpy(jit->code + ok_pos, &rel, sizeof(int));
+    }
+    jit_emit_mem(jit, 0, true, 0x8B, 1, X86_RCX, X86_R15, -1, rt_offset(ram));                               // mov rcx, [r15 + ram]
+}
+
+/**
+*   @brief Проверяет, что элемент стека данных с глубиной d помещается в стек: r12 + 8 * (d + 1) <= r13.
+*/
+
+void jit_compile_overflow(jit_code *const jit, const int d, const JIT_ERROR err)
+{
+    assert(jit != nullptr);
+
+    jit_emit_mem (jit, 0, true, 0x8D, 1, X86_RCX, X86_R12, -1, slot(d + 1));                                 // lea rcx, [d + 1]
+    jit_emit_reg (jit, 0, true, 0x39, 1, X86_R13, X86_RCX);                                                  // cmp rcx, r13
+    jit_emit_jump(jit, X86_JA, jit->err_pos[err]);
+}
+
+/**
+*   @brief Вызывает rt->helper(rt, xmm0, xmm1) с выравниванием стека на 16 байт.
+*
+*   @param check_error - после вызова проверить rt->error
+*/
+
+void jit_compile_helper(jit_code *const jit, const int helper_offset, const bool check_error)
+{
+    assert(jit != nullptr);
+
+    jit_emit_reg(jit, 0, true , 0x89, 1, X86_R15, X86_RDI);                                                  // mov  rdi, r15
+    jit_emit_reg(jit, 0, true , 0x89, 1, X86_RSP, X86_RBX);                                                  // mov  rbx, rsp
+    jit_emit_reg(jit, 0, true , 0x83, 1, 4, X86_RSP); jit_emit_byte(jit, 0xF0);                              // and  rsp, -16
+    jit_emit_mem(jit, 0, false, 0xFF, 1, 2, X86_R15, -1, helper_offset);                                     // call [r15 + helper]
+    jit_emit_reg(jit, 0, true , 0x89, 1, X86_RBX, X86_RSP);                                                  // mov  rsp, rbx
+
+    if (!check_error) return;
+
+    jit_emit_mem (jit, 0, false, 0x83, 1, 7, X86_R15, -1, rt_offset(error)); jit_emit_byte(jit, 0);          // cmp dword [r15 + error], 0
+    jit_emit_jump(jit, X86_JNE, jit->exit_pos);
+}
+
+/*===========================================================================================================================*/
+// EMIT
+/*===========================================================================================================================*/
+
+void jit_emit_byte(jit_code *const jit, const unsigned char byte)
+{
+    assert(jit != nullptr);
+
+    if (jit->size == jit->capacity)
+    {
+        unsigned char *code = (unsigned char *) log_realloc(jit->code, (size_t) jit->capacity * 2);
+        if (code == nullptr)
+        {
+            log_error("can't allocate memory for compiled code(%d)\n", __LINE__);
+            abort();
+        }
+        jit->code      = code;
+        jit->capacity *= 2;
+    }
+    jit->code[jit->size++] = byte;
+}
+
+void jit_emit_int(jit_code *const jit, const int num)
+{
+    assert(jit != nullptr);
+
+    const unsigned bits = (unsigned) num;
+
+    for (unsigned i = 0; i < sizeof(int); ++i) jit_emit_byte(jit, (unsigned char) (bits >> (8 * i))); // little-endian
+}
+
+void jit_emit_long(jit_code *const jit, const long long num)
+{
+    assert(jit != nullptr);
+
+    const unsigned long long bits = (unsigned long long) num;
+
+    for (unsigned i = 0; i < sizeof(long long); ++i) jit_emit_byte(jit, (unsigned char) (bits >> (8 * i)));
+}
+
+/**
+*   @brief Записывает префикс, REX (если нужен) и опкод инструкции.
+*
+*   @param prefix - обязательный префикс SSE (0x66, 0xF2) или 0
+*   @param reg    - поле reg ModRM (регистр или расширение опкода)
+*   @param base   - регистр в поле rm или базовый регистр
+*   @param index  - индексный регистр или -1
+*/
+
+void jit_emit_opcode(jit_code *const jit, const unsigned char prefix, const bool rex_w, const unsigned opcode,
+                                                                                         const int      opcode_size,
+                                                                                         const int      reg,
+                                                                                         const int      base,
+                                                                                         const int      index)
+{
+    assert(jit != nullptr);
+
+    if (prefix != 0) jit_emit_byte(jit, prefix);
+
+    unsigned char rex = 0x40;
+    if (rex_w)                     rex |= 0x08;
+    if (reg  >= 8)                 rex |= 0x04;
+    if (index >= 8)                rex |= 0x02;
+    if (base >= 8)                 rex |= 0x01;
+    if (rex != 0x40) jit_emit_byte(jit, rex);
+
+    if (opcode_size == 2) jit_emit_byte(jit, (unsigned char) (opcode >> 8));
+    jit_emit_byte(jit, (unsigned char) opcode);
+}
+
+/**
+*   @brief Инструкция с операндом в памяти [base + index * 8 + disp32].
+*/
+
+void jit_emit_mem(jit_code *const jit, const unsigned char prefix, const bool rex_w, const unsigned opcode,
+                                                                                      const int      opcode_size,
+                                                                                      const int      reg,
+                                                                                      const int      base,
+                                                                                      const int      index,
+                                                                                      const int      disp)
+{
+    assert(jit != nullptr);
+
+    jit_emit_opcode(jit, prefix, rex_w, opcode, opcode_size, reg, base, index);
+
+    if (index >= 0)
+    {
+        jit_emit_byte(jit, (unsigned char) (0x80 | ((reg & 7) << 3) | 4));                      // mod = 10, rm = SIB
+        jit_emit_byte(jit, (unsigned char) (0xC0 | ((index & 7) << 3) | (base & 7)));           // scale = 8
+    }
+    else if ((base & 7) == X86_RSP)
+    {
+        jit_emit_byte(jit, (unsigned char) (0x80 | ((reg & 7) << 3) | 4));                      // mod = 10, rm = SIB
+        jit_emit_byte(jit, (unsigned char) (0x20 | (base & 7)));                                // без индекса
+    }
+    else jit_emit_byte(jit, (unsigned char) (0x80 | ((reg & 7) << 3) | (base & 7)));            // mod = 10
+
+    jit_emit_int(jit, disp);
+}
+
+/**
+*   @brief Инструкция с регистровыми операндами (mod = 11).
+*/
+
+void jit_emit_reg(jit_code *const jit, const unsigned char prefix, const bool rex_w, const unsigned opcode,
+                                                                                      const int      opcode_size,
+                                                                                      const int      reg,
+                                                                                      const int      rm)
+{
+    assert(jit != nullptr);
+
+    jit_emit_opcode(jit, prefix, rex_w, opcode, opcode_size, reg, rm, -1);
+    jit_emit_byte  (jit, (unsigned char) (0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+/**
+*   @brief Переход (jcc = 0 - безусловный) на уже известную позицию кода.
+*/
+
+void jit_emit_jump(jit_code *const jit, const unsigned char jcc, const int target_pos)
+{
+    assert(jit != nullptr);
+
+    if (jcc == 0) jit_emit_byte(jit, 0xE9);
+    else        { jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, jcc); }
+
+    jit_emit_int(jit, target_pos - (jit->size + (int) sizeof(int)));
+}
+
+/**
+*   @brief Переход (jcc = 0 - безусловный) на инструкцию label, смещение заполняется в jit_compile().
+*/
+
+void jit_emit_label(jit_code *const jit, const unsigned char jcc, const int label)
+{
+    assert(jit != nullptr);
+    assert(jit->fixup_size < jit->fixup_capacity);
+
+    if (jcc == 0) jit_emit_byte(jit, 0xE9);
+    else        { jit_emit_byte(jit, 0x0F); jit_emit_byte(jit, jcc); }
+
+    jit->fixup[jit->fixup_size++] = {jit->size, label};
+    jit_emit_int(jit, 0);
+}
+
+void jit_emit_call(jit_code *const jit, const int label)
+{
+    assert(jit != nullptr);
+    assert(jit->fixup_size < jit->fixup_capacity);
+
+    jit_emit_byte(jit, 0xE8);
+
+    jit->fixup[jit->fixup_size++] = {jit->size, label};
+    jit_emit_int(jit, 0);
+}
+
+/*===========================================================================================================================*/
+// HELPERS
+/*===========================================================================================================================*/
+
+double jit_helper_in(jit_runtime *const rt)
+{
+    assert(rt != nullptr);
+
+    double num = 0;
+    if (!io_read_double(&rt->computer->io, &num)) rt->error = JIT_IN_VALUE;
+
+    return num;
+}
+
+void jit_helper_out(jit_runtime *const rt, const double num)
+{
+    assert(rt != nullptr);
+
+    io_write_double(&rt->computer->io, num);
+}
+
+double jit_helper_pow(jit_runtime *const rt, const double num1, const double num2)
+{
+    assert(rt != nullptr);
+
+    if (approx_equal(num1, 0) && num2 < 0) { rt->error = JIT_POW_ZERO; return 0; }
+    if (num1 < 0)                          { rt->error = JIT_POW_BASE; return 0; }
+
+    return pow(num1, num2);
+}
+
+double jit_helper_sqrt(jit_runtime *const rt, const double num)
+{
+    assert(rt != nullptr);
+
+    if (num < 0) { rt->error = JIT_SQRT_DOMAIN; return 0; }
+
+    return sqrt(num);
+}
+
+double jit_helper_sin(jit_runtime *const rt, const double num)
+{
+    assert(rt != nullptr);
+
+    return sin(num);
+}
+
+double jit_helper_cos(jit_runtime *const rt, const double num)
+{
+    assert(rt != nullptr);
+
+    return cos(num);
+}
+
+double jit_helper_log(jit_runtime *const rt, const double num)
+{
+    assert(rt != nullptr);
+
+    if (num < 0 || approx_equal(num, 0)) { rt->error = JIT_LOG_DOMAIN; return 0; }
+
+    return log(num);
+}
+
+/**
+*   @brief Расширяет RAM до ячейки index (см. ram_grow()).
+*
+*   @return index, если ячейка стала доступна
+*/
+
+int jit_helper_grow(jit_runtime *const rt, const int index, const int err)
+{
+    assert(rt != nullptr);
+
+    if (!ram_grow(&rt->computer->ram, index)) { rt->error = err; return 0; }
+
+    rt->ram      = rt->computer->ram.data;
+    rt->ram_size = rt->computer->ram.size;
+    return index;
+}
+
+/*===========================================================================================================================*/
+// JIT_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Анализирует и компилирует программу в jit->code (см. jit_compile()).
+*
+*   @param ram_growable - RAM может расти при обращении за ее границу (см. jit_compile_ram_index())
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool jit_ctor(jit_code *const jit, const program *const prog, const bool ram_growable)
+{
+    assert(jit  != nullptr);
+    assert(prog != nullptr);
+
+    jit->ram_growable = ram_growable;
+
+    const size_t size = (size_t) prog->size + 1;
+
+    jit->capacity       = 64 * (int) size;
+    jit->fixup_capacity =  2 * (int) size;
+
+    jit->code    = (unsigned char *) log_calloc((size_t) jit->capacity      , sizeof(unsigned char));
+    jit->cmd_pos = (int           *) log_calloc(size                        , sizeof(int));
+    jit->depth   = (int           *) log_calloc(size                        , sizeof(int));
+    jit->is_func = (bool          *) log_calloc(size                        , sizeof(bool));
+    jit->fixup   = (jit_fixup     *) log_calloc((size_t) jit->fixup_capacity, sizeof(jit_fixup));
+
+    if (jit->code == nullptr || jit->cmd_pos == nullptr || jit->depth == nullptr || jit->is_func == nullptr || jit->fixup == nullptr)
+    {
+        log_error("can't allocate memory for jit(%d)\n", __LINE__);
+        return false;
+    }
+
+    if (!program_verify(prog, jit->depth)) return false;
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        if (prog->cmd[i].cmd == CALL) jit->is_func[prog->cmd[i].arg.label] = true;
+    }
+    return jit_compile(jit, prog);
+}
+
+void jit_dtor(jit_code *const jit)
+{
+    assert(jit != nullptr);
+
+#ifdef __x86_64__
+    if (jit->exec != nullptr) munmap(jit->exec, jit->exec_size);
+#endif
+
+    log_free(jit->code);
+    log_free(jit->cmd_pos);
+    log_free(jit->depth);
+    log_free(jit->is_func);
+    log_free(jit->fixup);
+
+    *jit = {};
+}
+
+/**
+*   @brief Отображает машинный стек, в который помещается call_capacity вложенных CALL и вызовы jit_helper_*().
+*
+*   @note Страницы выделяются при первом обращении, поэтому большой --call-stack не занимает память заранее.
+*         Защитная страница под стеком превращает переполнение в SIGSEGV вместо порчи чужой памяти.
+*/
+
+bool jit_stack_ctor(jit_stack *const stack, const long long call_capacity)
+{
+    assert(stack != nullptr);
+
+#ifdef __x86_64__
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+
+    stack->map_size = jit_stack_size(call_capacity, page);
+    stack->map      = mmap(nullptr, stack->map_size, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack->map == MAP_FAILED)
+    {
+        *stack = {};
+        log_error("can't map memory for jit stack(%d)\n", __LINE__);
+        return false;
+    }
+    if (mprotect(stack->map, page, PROT_NONE) != 0)
+    {
+        jit_stack_dtor(stack);
+        log_error("can't protect jit stack guard page(%d)\n", __LINE__);
+        return false;
+    }
+    stack->top = (char *) stack->map + stack->map_size;
+    return true;
+#else
+    (void) call_capacity;
+    return false;
+#endif
+}
+
+/**
+*   @return размер отображения машинного стека вместе с защитной страницей (кратен page)
+*/
+
+size_t jit_stack_size(const long long call_capacity, const size_t page)
+{
+    const size_t size = (size_t) call_capacity * (size_t) JIT_CALL_FRAME + JIT_HELPER_STACK;
+
+    return (size + page - 1) / page * page + page;
+}
+
+void jit_stack_dtor(jit_stack *const stack)
+{
+    assert(stack != nullptr);
+
+#ifdef __x86_64__
+    if (stack->map != nullptr) munmap(stack->map, stack->map_size);
+#endif
+
+    *stack = {};
+}
+
+#undef slot
+#undef rt_offset
+#undef reg_offset
+#undef dbl_offset
@@ -0,0 +1,213 @@
+#ifndef JIT
+#define JIT
+
+#include <stddef.h>
+
+#include "machine.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+const long long JIT_CALL_FRAME   = 16;          // байт машинного стека на один CALL: сохраненный r12 и адрес возврата
+const size_t    JIT_HELPER_STACK = 1 << 20;     // запас машинного стека для jit_helper_*() и библиотечных функций
+
+enum X86_REG                // регистры общего назначения x86-64 (номер в ModRM/REX)
+{
+    X86_RAX =  0,
+    X86_RCX =  1,
+    X86_RDX =  2,
+    X86_RBX =  3,
+    X86_RSP =  4,
+    X86_RBP =  5,
+    X86_RSI =  6,
+    X86_RDI =  7,
+    X86_R12 = 12,
+    X86_R13 = 13,
+    X86_R14 = 14,
+    X86_R15 = 15,
+};
+
+enum X86_JCC                // второй байт опкода условного перехода 0F 8x
+{
+    X86_JB  = 0x82,
+    X86_JAE = 0x83,
+    X86_JNE = 0x85,
+    X86_JA  = 0x87,
+};
+
+enum JIT_ERROR              // ошибки времени исполнения скомпилированного кода
+{
+    JIT_OK              ,
+
+    JIT_IN_VALUE        ,
+    JIT_IN_OVERFLOW     ,
+    JIT_PUSH_OVERFLOW   ,
+    JIT_PUSH_RAM        ,
+    JIT_POP_RAM         ,
+    JIT_CALL_OVERFLOW   ,
+    JIT_DIV_ZERO        ,
+    JIT_POW_ZERO        ,
+    JIT_POW_BASE        ,
+    JIT_SQRT_DOMAIN     ,
+    JIT_LOG_DOMAIN      ,
+    JIT_CALL_STACK_MAP  ,               // не удалось отобразить машинный стек (только AOT, JIT переходит на шитый код)
+
+    JIT_ERROR_NUMBER    ,
+};
+
+static const char *const JIT_ERROR_MESSAGES[][2] = // {имя инструкции, сообщение}, как в интерпретаторе
+{
+    {""    , ""                         },
+
+    {"IN"  , "input value is not double"},
+    {"IN"  , "data_stack overflow"      },
+    {"PUSH", "data_stack overflow"      },
+    {"PUSH", "invalid ram index"        },
+    {"POP" , "invalid ram index"        },
+    {"CALL", "call_stack overflow"      },
+    {"DIV" , "division by zero"         },
+    {"POW" , "division by zero"         },
+    {"POW" , "pow of less zero basis"   },
+    {"SQRT", "sqrt of less zero number" },
+    {"LOG" , "log of less zero number"  },
+    {"CALL", "can't allocate call_stack"},
+};
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct jit_runtime                                              // данные, доступные скомпилированному коду через r15
+{
+    alignas(16)
+    unsigned long long abs_mask[2];                             // маска для andpd: сброс знакового бита
+    double             delta;                                   // точность approx_equal()
+    int                error;                                   // JIT_ERROR
+
+    machine           *computer;                                // r14
+    cpu_type          *data;                                    // r12 при входе: дно стека данных
+    cpu_type          *data_end;                                // r13: конец стека данных
+    cpu_type          *ram;                                     // ячейки RAM
+    int                ram_size;                                // количество доступных ячеек RAM
+    long long          call_capacity;                           // rbp: сколько еще CALL поместится в стек вызовов
+    void              *saved_rsp;                               // rsp после пролога, для выхода из любой глубины
+    void              *stack_top;                               // rsp скомпилированного кода: вершина jit_stack
+
+    double (*in)  (jit_runtime *const rt);
+    void   (*out) (jit_runtime *const rt, const double num);
+    double (*pow) (jit_runtime *const rt, const double num1, const double num2);
+    double (*sqrt)(jit_runtime *const rt, const double num);
+    double (*sin) (jit_runtime *const rt, const double num);
+    double (*cos) (jit_runtime *const rt, const double num);
+    double (*log) (jit_runtime *const rt, const double num);
+    int    (*grow)(jit_runtime *const rt, const int index, const int err);
+};
+
+struct jit_stack            // машинный стек скомпилированного кода: CALL становится call, поэтому стек потока может быть мал
+{
+    void   *map;            // отображение: [защитная страница][стек]
+    size_t  map_size;
+    void   *top;
+};
+
+struct jit_fixup            // rel32, который нужно заполнить после компиляции
+{
+    int pos;                // позиция rel32 в .code
+    int label;              // индекс инструкции, на которую указывает переход
+};
+
+struct jit_code
+{
+    unsigned char *code;                    // буфер машинного кода
+    int            size;                    // размер .code
+    int            capacity;                // емкость .code
+
+    int           *cmd_pos;                 // cmd_pos[i] - смещение кода инструкции i в .code
+    int           *depth;                   // depth  [i] - глубина стека данных перед инструкцией i (см. program_verify())
+    bool          *is_func;                 // is_func[i] - инструкция i является целью CALL
+
+    jit_fixup     *fixup;                   // переходы на инструкции
+    int            fixup_size;
+    int            fixup_capacity;
+
+    bool           ram_growable;            // при обращении за границу RAM вызывать rt->grow() вместо ошибки
+
+    int            exit_pos;                // выход из скомпилированного кода
+    int            err_pos[JIT_ERROR_NUMBER];
+
+    void          *exec;                    // исполняемая копия .code (mmap)
+    size_t         exec_size;
+};
+
+/*===========================================================================================================================*/
+// COMPILE
+/*===========================================================================================================================*/
+
+bool jit_compile        (jit_code *const jit, const program *const prog);
+bool jit_load           (jit_code *const jit);
+void jit_compile_prologue(jit_code *const jit);
+void jit_compile_cmd    (jit_code *const jit, const program *const prog, const int index);
+void jit_compile_push   (jit_code *const jit, const instruction *const cur_cmd, const int d);
+void jit_compile_pop    (jit_code *const jit, const instruction *const cur_cmd, const int d);
+void jit_compile_jcc    (jit_code *const jit, const instruction *const cur_cmd, const int d);
+void jit_compile_add_reg(jit_code *const jit, const instruction *const cur_cmd);
+void jit_compile_add_mem(jit_code *const jit, const instruction *const cur_cmd, const int d);
+void jit_compile_mem_op (jit_code *const jit, const instruction *const cur_cmd, const int d);
+void jit_compile_goto   (jit_code *const jit, const unsigned char jcc, const int label, const int d);
+void jit_compile_ram_index(jit_code *const jit, const instruction *const cur_cmd, const JIT_ERROR err);
+void jit_compile_overflow(jit_code *const jit, const int d, const JIT_ERROR err);
+void jit_compile_helper (jit_code *const jit, const int helper_offset, const bool check_error);
+void jit_compile_approx_equal(jit_code *const jit);
+
+/*===========================================================================================================================*/
+// EMIT
+/*===========================================================================================================================*/
+
+void jit_emit_byte      (jit_code *const jit, const unsigned char byte);
+void jit_emit_int       (jit_code *const jit, const int num);
+void jit_emit_long      (jit_code *const jit, const long long num);
+void jit_emit_opcode    (jit_code *const jit, const unsigned char prefix, const bool rex_w, const unsigned opcode,
+                                                                                              const int      opcode_size,
+                                                                                              const int      reg,
+                                                                                              const int      base,
+                                                                                              const int      index);
+void jit_emit_mem       (jit_code *const jit, const unsigned char prefix, const bool rex_w, const unsigned opcode,
+                                                                                              const int      opcode_size,
+                                                                                              const int      reg,
+                                                                                              const int      base,
+                                                                                              const int      index,
+                                                                                              const int      disp);
+void jit_emit_reg       (jit_code *const jit, const unsigned char prefix, const bool rex_w, const unsigned opcode,
+                                                                                              const int      opcode_size,
+                                                                                              const int      reg,
+                                                                                              const int      rm);
+void jit_emit_jump      (jit_code *const jit, const unsigned char jcc, const int target_pos);
+void jit_emit_label     (jit_code *const jit, const unsigned char jcc, const int label);
+void jit_emit_call      (jit_code *const jit, const int label);
+
+/*===========================================================================================================================*/
+// HELPERS
+/*===========================================================================================================================*/
+
+double jit_helper_in    (jit_runtime *const rt);
+void   jit_helper_out   (jit_runtime *const rt, const double num);
+double jit_helper_pow   (jit_runtime *const rt, const double num1, const double num2);
+double jit_helper_sqrt  (jit_runtime *const rt, const double num);
+double jit_helper_sin   (jit_runtime *const rt, const double num);
+double jit_helper_cos   (jit_runtime *const rt, const double num);
+double jit_helper_log   (jit_runtime *const rt, const double num);
+int    jit_helper_grow  (jit_runtime *const rt, const int index, const int err);
+
+/*===========================================================================================================================*/
+// JIT_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool jit_ctor           (jit_code *const jit, const program *const prog, const bool ram_growable = false);
+void jit_dtor           (jit_code *const jit);
+
+bool   jit_stack_ctor   (jit_stack *const stack, const long long call_capacity);
+void   jit_stack_dtor   (jit_stack *const stack);
+size_t jit_stack_size   (const long long call_capacity, const size_t page);
+
+#endif //JIT
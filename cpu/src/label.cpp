@@ -20,26 +20,40 @@ void label_store_ctor(label_store *const link)
 {
     assert(link != nullptr);
 
-    link->store    = nullptr;
-    link->size     = 0;
-    link->capacity = 0;
+    *link = {};
 }
 
+/**
+*   @brief Выделяет память под capacity меток и столько же ссылок вперед.
+*
+*   @note Каждая метка и каждая ссылка - отдельный токен, поэтому capacity - количество неопознанных токенов в исходном коде.
+*/
+
 bool label_store_ctor(label_store *const link, const int capacity)
 {
     assert(link     != nullptr);
     assert(capacity >=       0);
 
-    link->store    = (label *) log_calloc((size_t) capacity, sizeof(label));
+    *link = {};
+
+    link->table_size = 1;
+    while (link->table_size < 2 * capacity) link->table_size *= 2;
+
+    link->store    = (label       *) log_calloc((size_t) capacity        , sizeof(label));
+    link->fixup    = (label_fixup *) log_calloc((size_t) capacity        , sizeof(label_fixup));
+    link->table    = (int         *) log_calloc((size_t) link->table_size, sizeof(int));
     link->capacity = capacity;
-    link->size     = 0;
-    
-    if (link->store == nullptr && capacity != 0)
+    link->fixup_capacity = capacity;
+
+    if ((capacity != 0 && (link->store == nullptr || link->fixup == nullptr)) || link->table == nullptr)
     {
         log_error(        "can't allocate memory for label array(%d)\n", __LINE__);
         fprintf  (stderr, "can't allocate memory for label array\n");
+        label_store_dtor(link);
         return false;
     }
+    for (int i = 0; i < link->table_size; ++i) link->table[i] = -1;
+
     return true;
 }
 
@@ -48,19 +62,85 @@ void label_store_dtor(label_store *const link)
     assert(link != nullptr);
 
     log_free(link->store);
+    log_free(link->fixup);
+    log_free(link->table);
+
+    *link = {};
 }
 
 /*===========================================================================================================================*/
 // LABEL_STORE_PUSH
 /*===========================================================================================================================*/
 
-void label_store_push(label_store *const link, const int token_num, const int label_pc)
+void label_store_push(label_store *const link, const int token_num, const char *const name, const int name_len, const int label_pc)
 {
     assert(link != nullptr);
+    assert(name != nullptr);
     assert(link->size < link->capacity);
 
     link->store[link->size].token_num = token_num;
     link->store[link->size].pc        = label_pc;
+    link->store[link->size].name      = name;
+    link->store[link->size].name_len  = name_len;
+
+    const unsigned mask = (unsigned) link->table_size - 1;
+    unsigned       pos  = label_hash(name, name_len) & mask;
+
+    while (link->table[pos] != -1) pos = (pos + 1) & mask;
+    link->table[pos] = link->size;
 
     link->size++;
 }
+
+void label_store_add_fixup(label_store *const link, const int token_num, const int cmd_pos)
+{
+    assert(link != nullptr);
+    assert(link->fixup_size < link->fixup_capacity);
+
+    link->fixup[link->fixup_size].token_num = token_num;
+    link->fixup[link->fixup_size].cmd_pos   = cmd_pos;
+
+    link->fixup_size++;
+}
+
+/**
+*   @return индекс метки name в .store и -1, если такой метки нет
+*
+*   @note Имена меток сравниваются без учета регистра.
+*/
+
+int label_store_find(const label_store *const link, const char *const name, const int name_len)
+{
+    assert(link != nullptr);
+    assert(name != nullptr);
+
+    if (link->table == nullptr) return -1;
+
+    const unsigned mask = (unsigned) link->table_size - 1;
+
+    for (unsigned pos = label_hash(name, name_len) & mask; link->table[pos] != -1; pos = (pos + 1) & mask)
+    {
+        const label *cur = link->store + link->table[pos];
+
+        if (cur->name_len == name_len && !strncasecmp(cur->name, name, (size_t) name_len)) return link->table[pos];
+    }
+    return -1;
+}
+
+/**
+*   @brief FNV-1a от имени, приведенного к нижнему регистру.
+*/
+
+unsigned label_hash(const char *const name, const int name_len)
+{
+    assert(name != nullptr);
+
+    unsigned hash = 2166136261u;
+
+    for (int i = 0; i < name_len; ++i)
+    {
+        hash ^= (unsigned char) tolower((unsigned char) name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
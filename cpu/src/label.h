@@ -9,6 +9,15 @@ struct label        // структура, описывающая метку
 {
     int token_num;  // номер токена метки
     int pc;         // номер инструкции, на которую ссылается метка
+
+    const char *name;   // имя метки в исходном коде (не заканчивается '\0')
+    int     name_len;   // длина .name
+};
+
+struct label_fixup  // ссылка на метку, еще не определенную к моменту трансляции перехода
+{
+    int token_num;  // номер токена с именем метки
+    int cmd_pos;    // смещение параметра перехода в коде, куда нужно записать адрес метки
 };
 
 struct label_store
@@ -16,6 +25,13 @@ struct label_store
     label *store;   // массив, хранящий метки
     int     size;   // размер .store
     int capacity;   // емкость .store
+
+    int *table;     // хеш-таблица с открытой адресацией: индексы .store или -1 для пустой ячейки
+    int  table_size;// размер .table (степень двойки, не меньше 2 * .capacity)
+
+    label_fixup *fixup;     // ссылки вперед, которые заполняются после трансляции всего кода
+    int          fixup_size;
+    int          fixup_capacity;
 };
 
 /*===========================================================================================================================*/
@@ -30,6 +46,10 @@ void label_store_dtor (label_store *const link);
 // LABEL_STORE_PUSH
 /*===========================================================================================================================*/
 
-void label_store_push (label_store *const link, const int token_num, const int label_pc);
+void     label_store_push      (label_store *const link, const int token_num, const char *const name, const int name_len,
+                                                                                                      const int label_pc);
+void     label_store_add_fixup (label_store *const link, const int token_num, const int cmd_pos);
+int      label_store_find      (const label_store *const link, const char *const name, const int name_len);
+unsigned label_hash            (const char *const name, const int name_len);
 
-#endif //LABEL
\ No newline at end of file
+#endif //LABEL
@@ -11,6 +11,11 @@
 
 #include "terminal_colors.h"
 #include "machine.h"
+#include "jit.h"
+#include "server.h"
+#include "batch.h"
+#include "snapshot.h"
+#include "binary.h"
 
 /*===========================================================================================================================*/
 // MAIN
@@ -18,64 +23,260 @@
 
 int main(const int argc, const char *argv[])
 {
-    if (argc != 2)
+    bool        threaded            = false;                // исполнять шитым кодом вместо switch-цикла
+    bool        verify              = true;                 // проверять программу при загрузке
+    bool        jit                 = false;                // компилировать программу в машинный код
+    bool        server              = false;                // исполнять программу для каждой записи ввода (см. execute_server())
+    int         batch_threads       = -1;                   // исполнять записи ввода на пуле потоков (см. execute_batch())
+    int         data_stack_capacity = DATA_STACK_CAPACITY;
+    int         call_stack_capacity = CALL_STACK_CAPACITY;
+    int         ram_size            = 0;                    // 0 - размер из заголовка исполняемого файла
+    int         ram_limit           = 0;                    // до скольких ячеек RAM может расти (0 - без роста)
+    const char *execute_file        = nullptr;
+    const char *profile_file        = nullptr;              // файл для отчета профилировщика (см. execute_profiled())
+    const char *out_file            = nullptr;              // куда выводить результаты OUT (см. io_ctor())
+    const char *socket_path         = nullptr;              // Unix-сокет сервера (nullptr - записи из stdin)
+    const char *snapshot_file       = nullptr;              // куда сохранить снимок состояния (см. execute_snapshot())
+    int         snapshot_pc         = -1;                   // перед какой инструкцией сделать снимок (-1 - перед первым IN)
+    const char *restore_file        = nullptr;              // снимок, с которого продолжить исполнение (см. snapshot_load())
+
+    for (int i = 1; i < argc; ++i)
     {
-        fprintf(stderr, "you should give execute file\n");
+        if      (!strcmp(argv[i], "--threaded"))                  threaded            = true;
+        else if (!strcmp(argv[i], "--no-verify"))                 verify              = false;
+        else if (!strcmp(argv[i], "--jit"))                       jit                 = true;
+        else if (!strcmp(argv[i], "--server"))                    server              = true;
+        else if (!strcmp(argv[i], "--socket")     && i + 1 < argc) socket_path         = argv[++i];
+        else if (!strcmp(argv[i], "--batch")      && i + 1 < argc) batch_threads       = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--snapshot")   && i + 1 < argc) snapshot_file       = argv[++i];
+        else if (!strcmp(argv[i], "--snapshot-at") && i + 1 < argc) snapshot_pc         = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--restore")    && i + 1 < argc) restore_file        = argv[++i];
+        else if (!strcmp(argv[i], "--data-stack") && i + 1 < argc) data_stack_capacity = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--call-stack") && i + 1 < argc) call_stack_capacity = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ram")        && i + 1 < argc) ram_size            = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ram-max")    && i + 1 < argc) ram_limit           = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--profile")    && i + 1 < argc) profile_file        = argv[++i];
+        else if (!strcmp(argv[i], "--out")        && i + 1 < argc) out_file            = argv[++i];
+        else                                                       execute_file        = argv[i];
+    }
+    if (execute_file == nullptr || data_stack_capacity <= 0 || call_stack_capacity <= 0 || ram_size < 0 || ram_limit < 0)
+    {
+        fprintf(stderr, "you should give execute file: machine [--threaded | --jit] [--no-verify] [--data-stack N] [--call-stack N] [--ram N] [--ram-max N] [--profile report_file] [--out stdout | stderr | file] [--server [--socket path] | --batch threads] [--snapshot file [--snapshot-at index]] [--restore file] execute_file\n");
+        return 0;
+    }
+
+    machine computer = {};
+    if (!machine_ctor(&computer, execute_file, verify, data_stack_capacity, call_stack_capacity, out_file, ram_size, ram_limit))
+    {
+        machine_dtor(&computer);
+        fprintf(stderr, TERMINAL_RED "execute failed\n" TERMINAL_CANCEL);
+        return 0;
+    }
+
+    if (restore_file != nullptr && !snapshot_load(&computer, restore_file))
+    {
+        machine_dtor(&computer);
+        fprintf(stderr, TERMINAL_RED "execute failed\n" TERMINAL_CANCEL);
+        return 0;
+    }
+    if ((restore_file != nullptr || snapshot_file != nullptr) && jit)
+    {
+        log_message("JIT code always starts from the first instruction, snapshots are executed by execute_threaded()\n");
+        jit      = false;
+        threaded = true;
+    }
+
+    if (server || batch_threads >= 0)
+    {
+        if (profile_file != nullptr) log_message("server does not profile the program, --profile is ignored\n");
+        if (restore_file != nullptr) log_message("server resets the machine before each record, --restore is ignored\n");
+
+        const bool no_err = (batch_threads >= 0) ? execute_batch (&computer, jit, threaded, batch_threads) :
+                                                   execute_server(&computer, jit, threaded, socket_path);
+
+        if      (batch_threads >= 0) fprintf(stderr, no_err ? TERMINAL_GREEN "batch success\n"  TERMINAL_CANCEL :
+                                                              TERMINAL_RED   "batch failed\n"   TERMINAL_CANCEL);
+        else if (no_err)             fprintf(stderr,          TERMINAL_GREEN "server stopped\n" TERMINAL_CANCEL);
+        else                         fprintf(stderr,          TERMINAL_RED   "server failed\n"  TERMINAL_CANCEL);
         return 0;
     }
 
-    machine computer = {}; machine_ctor(&computer, argv[1]);
+    if (computer.reg_code && (jit || threaded || profile_file != nullptr))
+        log_message("register code is executed by execute_reg(), --jit, --threaded and --profile are ignored\n");
+    else if (profile_file != nullptr && (jit || threaded))
+        log_message("profiled program is executed by execute(), --jit and --threaded are ignored\n");
+
+    bool no_err = snapshot_file != nullptr ? execute_snapshot(&computer, snapshot_file, snapshot_pc, threaded) :
+                  computer.reg_code        ? execute_reg     (&computer) :
+                  profile_file  != nullptr ? execute_profiled(&computer, profile_file) :
+                  jit                      ? execute_jit     (&computer) :
+                  threaded                 ? execute_threaded(&computer) : execute(&computer);
 
-    if (execute(&computer)) fprintf(stderr, TERMINAL_GREEN "execute success\n" TERMINAL_CANCEL);
-    else                    fprintf(stderr, TERMINAL_RED   "execute failed\n"  TERMINAL_CANCEL);
+    if (no_err) fprintf(stderr, TERMINAL_GREEN "execute success\n" TERMINAL_CANCEL);
+    else        fprintf(stderr, TERMINAL_RED   "execute failed\n"  TERMINAL_CANCEL);
 }
 
 /*===========================================================================================================================*/
 // EXECUTE
 /*===========================================================================================================================*/
 
+// prints the runtime error message to io.err after the buffered output of the program
+#define runtime_error(fmt, ...)                                                                                             \
+    (io_flush(&computer->io), fprintf(computer->io.err, fmt, ##__VA_ARGS__))
+
 bool execute(machine *const computer)
 {
     assert(computer != nullptr);
 
-    unsigned char cur_cmd = 0;
-    
-    while ($cpu.pc < $cpu.capacity)
+    const bool no_err = do_execute<false>(computer, nullptr);
+    if (!no_err) report_source_line(computer);
+
+    machine_dtor(computer);
+    return no_err;
+}
+
+/**
+*   @brief Исполняет программу так же, как execute(), и собирает профиль исполнения (см. profiler).
+*
+*   @param report_file - файл для отчета, свернутые стеки записываются в report_file.folded
+*/
+
+bool execute_profiled(machine *const computer, const char *const report_file)
+{
+    assert(computer    != nullptr);
+    assert(report_file != nullptr);
+
+    profiler prof = {};
+    if (!profiler_ctor(&prof, &$cpu, $call_stack.capacity))
     {
-        executer_pull_cmd(&$cpu, &cur_cmd, sizeof(unsigned char));
+        machine_dtor(computer);
+        return false;
+    }
 
-        switch(cur_cmd)
-        {
-            case HLT : machine_dtor(computer); return true;
+    const bool no_err = do_execute<true>(computer, &prof);
+    if (!no_err) report_source_line(computer);
+
+    profiler_stop (&prof);
+    profiler_write(&prof, &$cpu, report_file);
+    profiler_dtor (&prof);
+
+    machine_dtor(computer);
+    return no_err;
+}
+
+/**
+*   @brief Сообщает, на какой инструкции и строке исходного кода остановилось исполнение после ошибки.
+*
+*   @note Строка известна, только если в исполняемом файле есть таблица строк (программа собрана без --strip).
+*/
+
+void report_source_line(machine *const computer)
+{
+    assert(computer != nullptr);
 
-            case IN  : if (execute_in   (computer) == false) { machine_dtor(computer); return false; } break;
-            case OUT : if (execute_out  (computer) == false) { machine_dtor(computer); return false; } break;
+    const int cur = $pc - 1;
+    if ($cpu.line == nullptr || cur < 0 || cur >= $cpu.size || $cpu.line[cur] == 0) return;
+
+    runtime_error("      at instruction %d (%s), source line %d\n", cur, ASM_CMD_NAMES[$cpu.cmd[cur].cmd], $cpu.line[cur]);
+}
+
+/**
+*   @brief Исполняет загруженную программу один раз и не освобождает машину (см. execute_server()).
+*
+*   @param jit      - скомпилированная программа (jit_ctor() и jit_load()) или nullptr
+*   @param threaded - исполнять шитым кодом, если jit == nullptr
+*
+*   @note Регистровый код всегда исполняется do_execute_reg().
+*/
+
+bool execute_loaded(machine *const computer, const jit_code *const jit, const bool threaded)
+{
+    assert(computer != nullptr);
+
+    if (computer->reg_code) return do_execute_reg  (computer);
+    if (jit != nullptr)     return execute_jit_code(computer, jit);
+
+#ifdef __GNUC__
+    if (threaded) return computer->verified ? do_execute_threaded<false>(computer) :
+                                              do_execute_threaded<true> (computer);
+#else
+    (void) threaded;
+#endif
+    return do_execute<false>(computer, nullptr);
+}
+
+/**
+*   @brief Switch-цикл исполнения.
+*
+*   @note При PROFILE == false профилировщик не используется (prof == nullptr) и код цикла совпадает с execute() без профиля.
+*   @note Вершина стека данных здесь не кешируется: команды исполняются функциями execute_*(), которые работают
+*         со стеком машины в памяти, и локальную вершину пришлось бы сбрасывать в память перед каждым вызовом.
+*         Кеширование вершины есть в do_execute_threaded(), где обработчики команд встроены в цикл.
+*/
+
+template <bool PROFILE>
+bool do_execute(machine *const computer, profiler *const prof)
+{
+    assert(computer != nullptr);
 
-            case RET : if (execute_ret  (computer) == false) { machine_dtor(computer); return false; } break;
+    while ($pc < $cpu.size)
+    {
+        const instruction *cur_cmd = $cpu.cmd + $pc++;
 
-            case ADD : if (execute_add  (computer) == false) { machine_dtor(computer); return false; } break;
-            case SUB : if (execute_sub  (computer) == false) { machine_dtor(computer); return false; } break;
-            case MUL : if (execute_mul  (computer) == false) { machine_dtor(computer); return false; } break;
-            case DIV : if (execute_div  (computer) == false) { machine_dtor(computer); return false; } break;
-            case POW : if (execute_pow  (computer) == false) { machine_dtor(computer); return false; } break;
-            case SQRT: if (execute_sqrt (computer) == false) { machine_dtor(computer); return false; } break;
-            case SIN : if (execute_sin  (computer) == false) { machine_dtor(computer); return false; } break;
-            case COS : if (execute_cos  (computer) == false) { machine_dtor(computer); return false; } break;
-            case LOG : if (execute_log  (computer) == false) { machine_dtor(computer); return false; } break;
+        if constexpr (PROFILE)
+        {
+            prof->cmd_count[cur_cmd->cmd]++;
+            prof->pc_count [$pc - 1]++;
+        }
 
-            case CALL: if (execute_call (computer) == false) { machine_dtor(computer); return false; } break;
+        switch(cur_cmd->cmd)
+        {
+            case HLT : return true;
+
+            case IN  : if (execute_in   (computer) == false) return false; break;
+            case OUT : if (execute_out  (computer) == false) return false; break;
+
+            case RET : if (execute_ret  (computer) == false) return false;
+                       if constexpr (PROFILE) profiler_ret(prof);
+                       break;
+
+            case ADD : if (execute_add  (computer) == false) return false; break;
+            case SUB : if (execute_sub  (computer) == false) return false; break;
+            case MUL : if (execute_mul  (computer) == false) return false; break;
+            case DIV : if (execute_div  (computer) == false) return false; break;
+            case POW : if (execute_pow  (computer) == false) return false; break;
+            case SQRT: if (execute_sqrt (computer) == false) return false; break;
+            case SIN : if (execute_sin  (computer) == false) return false; break;
+            case COS : if (execute_cos  (computer) == false) return false; break;
+            case LOG : if (execute_log  (computer) == false) return false; break;
+
+            case PUSH: if (execute_push (computer, cur_cmd) == false) return false; break;
+            case POP : if (execute_pop  (computer, cur_cmd) == false) return false; break;
+
+            case CALL: if (execute_call (computer, cur_cmd) == false) return false;
+                       if constexpr (PROFILE) profiler_call(prof, cur_cmd->arg.label);
+                       break;
             case JMP :
             case JA  :
             case JAE :
             case JB  :
             case JBE :
             case JE  :
-            case JNE : if (execute_jump (computer, cur_cmd) == false) { machine_dtor(computer); return false; } break;
+            case JNE :
+            case JZ  : if (execute_jump (computer, cur_cmd) == false) return false; break;
 
-            default  : if (execute_param(computer, cur_cmd) == false) { machine_dtor(computer); return false; } break;
+            case ADD_REG: if (execute_add_reg(computer, cur_cmd) == false) return false; break;
+            case ADD_MEM: if (execute_add_mem(computer, cur_cmd) == false) return false; break;
+            case MEM_OP : if (execute_mem_op (computer, cur_cmd) == false) return false; break;
+
+            case ADDI:
+            case SUBI: if (execute_int_alu(computer, cur_cmd) == false) return false; break;
+
+            default  : runtime_error(TERMINAL_RED "RUNTIME ERROR: " TERMINAL_CANCEL "undefined command\n");
+                       log_error("default case in do_execute(): cmd=%d(%d)\n", cur_cmd->cmd, __LINE__);
+                       return false;
         }
     }
-    machine_dtor(computer);
     return true;
 }
 
@@ -83,263 +284,295 @@ bool execute(machine *const computer)
 #define check_reg_arg(reg_arg, instruction_name)                                                                            \
   if (reg_arg <= 0 || reg_arg > REG_NUMBER)                                                                                 \
   {                                                                                                                         \
-      fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "invalid register\n", #instruction_name);      \
+      runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "invalid register\n", #instruction_name);        \
+      return false;                                                                                                         \
+  }
+
+// checks if reg_arg is not an int register (only int registers can be an index in RAM)
+#define check_int_reg_arg(reg_arg, instruction_name)                                                                        \
+  if (!is_int_reg(reg_arg))                                                                                                 \
+  {                                                                                                                         \
+      runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "expected int register, but it is double\n", #instruction_name); \
       return false;                                                                                                         \
   }
 
 // checks if ram_index is invalid
 #define check_ram_index(ram_index, instruction_name)                                                                        \
-  if (ram_index <  0 || ram_index >= RAM_SIZE)                                                                              \
+  if ((ram_index < 0 || ram_index >= computer->ram.size) && !ram_grow(&computer->ram, ram_index))                          \
   {                                                                                                                         \
-      fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "invalid ram index\n", #instruction_name);     \
+      runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "invalid ram index\n", #instruction_name);       \
       return false;                                                                                                         \
   }
 
 // checks if stack #stack_name is empty
 #define check_empty(stack_name, instruction_name)                                                                           \
-  if (stack_empty(&$##stack_name))                                                                                          \
+  if ($##stack_name.size == 0)                                                                                              \
   {                                                                                                                         \
-      fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL #stack_name " is empty\n", #instruction_name); \
+      runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL #stack_name " is empty\n", #instruction_name);   \
       return false;                                                                                                         \
   }
 
-// checks if #pc pointed out of execute boundary
-#define check_pc_inside(pc)                                                                                                 \
-    if ((size_t) pc < 0 || (size_t) pc >= (size_t) $cpu.capacity)                                                           \
-    {                                                                                                                       \
-        fprintf(stderr, TERMINAL_RED "RUNTIME ERROR: " TERMINAL_CANCEL "label pointed out of execute boundary\n");          \
-        return false;                                                                                                       \
-    }
+// checks if stack #stack_name is full
+#define check_full(stack_name, instruction_name)                                                                            \
+  if ($##stack_name.size == $##stack_name.capacity)                                                                         \
+  {                                                                                                                         \
+      runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL #stack_name " overflow\n", #instruction_name);   \
+      return false;                                                                                                         \
+  }
 
-// checks if pc will go out of boundary after pulling cmd with size #pull_size
-#define check_inside(pull_size)                                                                                             \
-    if ((size_t) $cpu.pc + pull_size > (size_t) $cpu.capacity)                                                              \
-    {                                                                                                                       \
-        fprintf(stderr, TERMINAL_RED "RUNTIME ERROR: " TERMINAL_CANCEL "no parameter at the end of file\n");                \
-        return false;                                                                                                       \
-    }
+// pushes #value on the data stack
+#define data_stack_push(value, instruction_name)                                                                            \
+    check_full(data_stack, instruction_name);                                                                               \
+    $data_stack.data[$data_stack.size++] = value
 
-bool execute_param(machine *const computer, const unsigned char cmd)
-{
-    assert(computer != nullptr);
+// pushes #value on the call stack
+#define call_stack_push(value, instruction_name)                                                                            \
+    check_full(call_stack, instruction_name);                                                                               \
+    $call_stack.data[$call_stack.size++] = value
 
-    switch (cmd & 31) // 5 bit for cmd_asm
-    {
-        case PUSH: return execute_push(computer, cmd);
-        case POP : return execute_pop (computer, cmd);
+#define data_stack_pop $data_stack.data[--$data_stack.size]
+#define data_stack_top $data_stack.data[  $data_stack.size - 1]
+#define call_stack_pop $call_stack.data[--$call_stack.size]
 
-        default  : fprintf(stderr, TERMINAL_RED "RUNTIME ERROR: " TERMINAL_CANCEL "undefined command\n");
-                   log_error("default case in execute_param(): cmd=%d(%d)\n", cmd, __LINE__);
-                   break;
-    }
-    return false;
-}
-
-bool execute_push(machine *const computer, const unsigned char cmd)
+bool execute_push(machine *const computer, const instruction *const cur_cmd)
 {
     assert(computer != nullptr);
+    assert(cur_cmd  != nullptr);
 
-    bool     mem_arg = false;
-    REGISTER reg_arg = ERR_REG;
-    double   dbl_arg = 0;
-    int      int_arg = 0;
+    const unsigned char param = cur_cmd->param;
+    const REGISTER    reg_arg = cur_cmd->reg;
 
-    if (cmd & (1 << PARAM_MEM))
+    if (param & (1 << PARAM_MEM))
     {
-        if  (!executer_pull_reg_int(computer, cmd, &mem_arg, &reg_arg, &int_arg)) return false;
-    }
-    else if (!executer_pull_reg_dbl(computer, cmd, &mem_arg, &reg_arg, &dbl_arg)) return false;
+        int int_param = 0;
 
-    int    int_param = 0;
-    double dbl_param = 0;
-    if (mem_arg)
-    {
-        if (cmd & (1 << PARAM_NUM)) int_param += int_arg;
-        if (cmd & (1 << PARAM_REG))
+        if (param & (1 << PARAM_NUM)) int_param += cur_cmd->arg.int_num;
+        if (param & (1 << PARAM_REG))
         {
-            check_reg_arg(reg_arg, PUSH);
-            if (!is_int_reg(reg_arg))
-            {
-                fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL, "expected int register, but it is double\n");
-                return false;
-            }
+            check_reg_arg    (reg_arg, PUSH);
+            check_int_reg_arg(reg_arg, PUSH);
             int_param += $int_reg[reg_arg];
         }
         check_ram_index(int_param, PUSH);
-        stack_push(&$data_stack, &$ram[int_param]);
+        data_stack_push($ram[int_param], PUSH);
         return true;
     }
-    if (cmd & (1 << PARAM_NUM)) dbl_param += dbl_arg;
-    if (cmd & (1 << PARAM_REG))
+
+    double dbl_param = 0;
+
+    if (param & (1 << PARAM_NUM)) dbl_param += cur_cmd->arg.dbl_num;
+    if (param & (1 << PARAM_REG))
     {
         check_reg_arg(reg_arg, PUSH);
         if (is_int_reg(reg_arg)) dbl_param += $int_reg[reg_arg];
         else                     dbl_param += $dbl_reg[reg_arg];
     }
-    stack_push(&$data_stack, &dbl_param);
+    data_stack_push(dbl_param, PUSH);
     return true;
 }
 
-bool execute_pop(machine *const computer, const unsigned char cmd)
+bool execute_pop(machine *const computer, const instruction *const cur_cmd)
 {
     assert(computer != nullptr);
+    assert(cur_cmd  != nullptr);
 
     check_empty(data_stack, POP);
 
-    bool     mem_arg = false;
-    REGISTER reg_arg = ERR_REG;
-    int      cpu_arg = 0;
+    const unsigned char param = cur_cmd->param;
+    const REGISTER    reg_arg = cur_cmd->reg;
 
-    if (!(cmd & (1 << PARAM_MEM)) && (cmd & (1 << PARAM_NUM)))
+    if (!(param & (1 << PARAM_MEM)) && (param & (1 << PARAM_NUM)))
     {
-        fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "rvalue as a pop-argument\n", "POP");
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "rvalue as a pop-argument\n", "POP");
         return false;
     }
-    if (!executer_pull_reg_int(computer, cmd, &mem_arg, &reg_arg, &cpu_arg)) return false;
 
     int num_param = 0;
-    if (cmd & (1 << PARAM_MEM))
+    if (param & (1 << PARAM_MEM))
     {
-        if (cmd & (1 << PARAM_REG))
+        if (param & (1 << PARAM_REG))
         {
-            check_reg_arg(reg_arg, POP);
-            if (!is_int_reg(reg_arg))   // только целочисленные регистры могут быть индексом в RAM
-            {
-                fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL, "expected int register, but it is double\n");
-                return false;
-            }
+            check_reg_arg    (reg_arg, POP);
+            check_int_reg_arg(reg_arg, POP);
             num_param += $int_reg[reg_arg];
         }
-        if (cmd & (1 << PARAM_NUM)) num_param += cpu_arg;
+        if (param & (1 << PARAM_NUM)) num_param += cur_cmd->arg.int_num;
 
         check_ram_index(num_param, POP);
-        $ram[num_param] = *(cpu_type *) stack_pop(&$data_stack);
+        $ram[num_param] = data_stack_pop;
         return true;
     }
-    if (cmd & (1 << PARAM_REG))
+    if (param & (1 << PARAM_REG))
     {
         check_reg_arg (reg_arg, POP);
-        if (is_int_reg(reg_arg)) $int_reg[reg_arg] = (int) *(cpu_type *) stack_pop(&$data_stack); // кладём действительное число в целочисленный регистр
-        else                     $dbl_reg[reg_arg] =       *(cpu_type *) stack_pop(&$data_stack);
+        if (is_int_reg(reg_arg)) $int_reg[reg_arg] = (int) data_stack_pop; // кладём действительное число в целочисленный регистр
+        else                     $dbl_reg[reg_arg] =       data_stack_pop;
         return true;
     }
-    stack_pop(&$data_stack); // void case
+    $data_stack.size--; // void case
     return true;
 }
 
-bool executer_pull_reg_int(machine *const computer, const unsigned char cmd, bool     *const mem_arg,
-                                                                             REGISTER *const reg_arg,
-                                                                             int      *const cpu_arg)
+bool execute_call(machine *const computer, const instruction *const cur_cmd)
 {
     assert(computer != nullptr);
-    assert(mem_arg  != nullptr);
-    assert(reg_arg  != nullptr);
-    assert(cpu_arg  != nullptr);
-
-    *mem_arg = cmd & (1 << PARAM_MEM);
+    assert(cur_cmd  != nullptr);
 
-    bool is_reg_arg = cmd & (1 << PARAM_REG);
-    bool is_cpu_arg = cmd & (1 << PARAM_NUM);
-    
-    if (is_reg_arg)
-    {
-        check_inside(sizeof(REGISTER));
-        executer_pull_cmd(&$cpu, reg_arg, sizeof(REGISTER));
-    }
-    if (is_cpu_arg)
-    {
-        check_inside(sizeof(cpu_type));
-        executer_pull_cmd(&$cpu, cpu_arg, sizeof(int));
-    }
+    call_stack_push($pc, CALL);
+    $pc = cur_cmd->arg.label;
     return true;
 }
 
-bool executer_pull_reg_dbl(machine *const computer, const unsigned char cmd, bool     *const mem_arg,
-                                                                             REGISTER *const reg_arg,
-                                                                             double   *const cpu_arg)
+bool execute_jump(machine *const computer, const instruction *const cur_cmd)
 {
     assert(computer != nullptr);
-    assert(mem_arg  != nullptr);
-    assert(reg_arg  != nullptr);
-    assert(cpu_arg  != nullptr);
+    assert(cur_cmd  != nullptr);
 
-    *mem_arg = cmd & (1 << PARAM_MEM);
+    const int label_pc = cur_cmd->arg.label;
 
-    bool is_reg_arg = cmd & (1 << PARAM_REG);
-    bool is_cpu_arg = cmd & (1 << PARAM_NUM);
-    
-    if (is_reg_arg)
+    if (cur_cmd->cmd == JMP)
+    {
+        $pc = label_pc;
+        return true;
+    }
+
+    cpu_type num1 = 0;
+    cpu_type num2 = 0;
+
+    if (cur_cmd->cmd == JZ)
     {
-        check_inside(sizeof(REGISTER));
-        executer_pull_cmd(&$cpu, reg_arg, sizeof(REGISTER));
+        check_empty(data_stack, JZ);
+        num1 = data_stack_pop;
+
+        if (approx_equal(num1, 0)) $pc = label_pc;
+        return true;
     }
-    if (is_cpu_arg)
+
+    check_empty(data_stack, "JUMP");
+    num2 = data_stack_pop;
+
+    check_empty(data_stack, "JUMP");
+    num1 = data_stack_pop;
+
+    switch(cur_cmd->cmd)
     {
-        check_inside(sizeof(cpu_type));
-        executer_pull_cmd(&$cpu, cpu_arg, sizeof(double));
+        case JA : if (num1 > num2)                             { $pc = label_pc; } return true;
+        case JAE: if (num1 > num2 || approx_equal(num1, num2)) { $pc = label_pc; } return true;
+        case JB : if (num1 < num2)                             { $pc = label_pc; } return true;
+        case JBE: if (num1 < num2 || approx_equal(num1, num2)) { $pc = label_pc; } return true;
+        case JE : if (               approx_equal(num1, num2)) { $pc = label_pc; } return true;
+        case JNE: if (              !approx_equal(num1, num2)) { $pc = label_pc; } return true;
+
+        default : log_error(         "default case in execute_jump: cmd=%d(%d)\n", cur_cmd->cmd, __LINE__);
+                  assert   (false && "default vase in execute_jump");
+                  break;
     }
-    return true;
+    return false;
 }
 
-bool execute_call(machine *const computer)
+/**
+*   @brief Суперинструкция "push reg; push num; add; pop reg": прибавляет число к регистру.
+*
+*   @note Как и в исходной последовательности, сложение выполняется в cpu_type,
+*         в целочисленный регистр результат кладется с отбрасыванием дробной части.
+*/
+
+bool execute_add_reg(machine *const computer, const instruction *const cur_cmd)
 {
     assert(computer != nullptr);
+    assert(cur_cmd  != nullptr);
 
-    int label_pc = 0;
-    if (!executer_pull_label(computer, &label_pc)) return false;
+    const REGISTER reg_arg = cur_cmd->reg;
+    check_reg_arg(reg_arg, ADD_REG);
 
-    check_pc_inside(label_pc);
-    stack_push     (&$call_stack, &$cpu.pc);
-    $cpu.pc = label_pc;
+    if (is_int_reg(reg_arg)) $int_reg[reg_arg] = (int) ($int_reg[reg_arg] + cur_cmd->arg.dbl_num);
+    else                     $dbl_reg[reg_arg] =        $dbl_reg[reg_arg] + cur_cmd->arg.dbl_num;
     return true;
 }
 
-bool execute_jump(machine *const computer, const unsigned char cmd)
+/**
+*   @brief ADDI и SUBI: прибавляет целое число к целочисленному регистру или вычитает его.
+*
+*   @note Переполнение, как и в JIT, заворачивается по модулю 2^32.
+*/
+
+bool execute_int_alu(machine *const computer, const instruction *const cur_cmd)
 {
     assert(computer != nullptr);
+    assert(cur_cmd  != nullptr);
 
-    int label_pc = 0;
-    if (!executer_pull_label(computer, &label_pc)) return false;
-
-    check_pc_inside(label_pc);
-    if (cmd == JMP)
+    const REGISTER reg_arg = cur_cmd->reg;
+    if (reg_arg <= 0 || reg_arg > REG_NUMBER || !is_int_reg(reg_arg))
     {
-        $cpu.pc = label_pc;
-        return true;
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "expected int register\n", ASM_CMD_NAMES[cur_cmd->cmd]);
+        return false;
     }
 
-    cpu_type num1 = 0;
-    cpu_type num2 = 0;
+    const unsigned num = (unsigned) cur_cmd->arg.int_num;
 
-    check_empty(data_stack, "JUMP");
-    num2 = *(cpu_type *) stack_pop(&$data_stack);
+    if (cur_cmd->cmd == ADDI) $int_reg[reg_arg] = (int) ((unsigned) $int_reg[reg_arg] + num);
+    else                      $int_reg[reg_arg] = (int) ((unsigned) $int_reg[reg_arg] - num);
+    return true;
+}
 
-    check_empty(data_stack, "JUMP");
-    num1 = *(cpu_type *) stack_pop(&$data_stack);
+/**
+*   @brief Суперинструкция "push [reg+n]; push [reg+m]; add": кладет в стек сумму двух ячеек RAM.
+*/
 
-    switch(cmd)
-    {
-        case JA : if (num1 > num2)                             { $cpu.pc = label_pc; } return true;
-        case JAE: if (num1 > num2 || approx_equal(num1, num2)) { $cpu.pc = label_pc; } return true;
-        case JB : if (num1 < num2)                             { $cpu.pc = label_pc; } return true;
-        case JBE: if (num1 < num2 || approx_equal(num1, num2)) { $cpu.pc = label_pc; } return true;
-        case JE : if (               approx_equal(num1, num2)) { $cpu.pc = label_pc; } return true;
-        case JNE: if (              !approx_equal(num1, num2)) { $cpu.pc = label_pc; } return true;
+bool execute_add_mem(machine *const computer, const instruction *const cur_cmd)
+{
+    assert(computer != nullptr);
+    assert(cur_cmd  != nullptr);
 
-        default : log_error(         "default case in execute_jump: cmd=%d(%d)\n", cmd, __LINE__);
-                  assert   (false && "default vase in execute_jump");
-                  break;
-    }
-    return false;
+    const REGISTER reg_arg = cur_cmd->reg;
+    check_reg_arg    (reg_arg, ADD_MEM);
+    check_int_reg_arg(reg_arg, ADD_MEM);
+
+    const int index1 = $int_reg[reg_arg] + cur_cmd->arg.ram_index[0];
+    const int index2 = $int_reg[reg_arg] + cur_cmd->arg.ram_index[1];
+
+    check_ram_index(index1, PUSH);
+    check_ram_index(index2, PUSH);
+
+    data_stack_push($ram[index1] + $ram[index2], PUSH);
+    return true;
 }
 
-bool executer_pull_label(machine *const computer, int *const label_pc)
+/**
+*   @brief Суперинструкция "push [reg+n]; push num; op": кладет в стек результат операции op (ADD, SUB, MUL, DIV) над ячейкой RAM и числом.
+*/
+
+bool execute_mem_op(machine *const computer, const instruction *const cur_cmd)
 {
     assert(computer != nullptr);
-    assert(label_pc != nullptr);
+    assert(cur_cmd  != nullptr);
+
+    const REGISTER reg_arg = cur_cmd->reg;
+    check_reg_arg    (reg_arg, MEM_OP);
+    check_int_reg_arg(reg_arg, MEM_OP);
+
+    const int index = $int_reg[reg_arg] + cur_cmd->offset;
+    check_ram_index(index, PUSH);
 
-    check_inside(sizeof(int));
-    executer_pull_cmd(&$cpu, label_pc, sizeof(int));
+    cpu_type num1 = $ram[index];
+    cpu_type num2 = cur_cmd->arg.dbl_num;
+
+    switch (cur_cmd->param)
+    {
+        case ADD: num1 += num2; break;
+        case SUB: num1 -= num2; break;
+        case MUL: num1 *= num2; break;
+        case DIV: if (approx_equal(num2, 0))
+                  {
+                      runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "DIV");
+                      return false;
+                  }
+                  num1 /= num2;
+                  break;
+        default : runtime_error(TERMINAL_RED "RUNTIME ERROR: " TERMINAL_CANCEL "undefined command\n");
+                  return false;
+    }
+    data_stack_push(num1, PUSH);
     return true;
 }
 
@@ -348,13 +581,13 @@ bool execute_in(machine *const computer)
     assert(computer != nullptr);
 
     cpu_type num = 0;
-    if (scanf("%lg", &num) != 1)
+    if (!io_read_double(&computer->io, &num))
     {
-        fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "input value is not double\n", "IN");
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "input value is not double\n", "IN");
         return false;
     }
 
-    stack_push(&$data_stack, &num);
+    data_stack_push(num, IN);
     return true;
 }
 
@@ -364,8 +597,8 @@ bool execute_out(machine *const computer)
 
     check_empty(data_stack, OUT);
 
-    cpu_type num = *(cpu_type *) stack_front(&$data_stack);
-    fprintf(stderr, "%lg\n", num);
+    cpu_type num = data_stack_top;
+    io_write_double(&computer->io, num);
     return true;
 }
 
@@ -375,7 +608,7 @@ bool execute_ret(machine *const computer)
 
     check_empty(call_stack, RET);
 
-    $cpu.pc = *(int *) stack_pop(&$call_stack);
+    $pc = call_stack_pop;
     return true;
 }
 
@@ -387,13 +620,13 @@ bool execute_add(machine *const computer)
     cpu_type num2 = 0;
 
     check_empty(data_stack, ADD);
-    num2 = *(cpu_type *) stack_pop(&$data_stack);
+    num2 = data_stack_pop;
     
     check_empty(data_stack, ADD);
-    num1 = *(cpu_type *) stack_pop(&$data_stack);
+    num1 = data_stack_pop;
 
     num1 += num2;
-    stack_push(&$data_stack, &num1);
+    data_stack_push(num1, ADD);
     return true;
 }
 
@@ -405,13 +638,13 @@ bool execute_sub(machine *const computer)
     cpu_type num2 = 0;
 
     check_empty(data_stack, SUB);
-    num2 = *(cpu_type *) stack_pop(&$data_stack);
+    num2 = data_stack_pop;
 
     check_empty(data_stack, SUB);
-    num1 = *(cpu_type *) stack_pop(&$data_stack);
+    num1 = data_stack_pop;
 
     num1 -= num2;
-    stack_push(&$data_stack, &num1);
+    data_stack_push(num1, SUB);
     return true;
 }
 
@@ -423,13 +656,13 @@ bool execute_mul(machine *const computer)
     cpu_type num2 = 0;
 
     check_empty(data_stack, MUL);
-    num2 = *(cpu_type *) stack_pop(&$data_stack);
+    num2 = data_stack_pop;
 
     check_empty(data_stack, MUL);
-    num1 = *(cpu_type *) stack_pop(&$data_stack);
+    num1 = data_stack_pop;
 
     num1 *= num2;
-    stack_push(&$data_stack, &num1);
+    data_stack_push(num1, MUL);
     return true;
 }
 
@@ -441,19 +674,19 @@ bool execute_div(machine *const computer)
     cpu_type num2 = 0;
 
     check_empty(data_stack, DIV);
-    num2 = *(cpu_type *) stack_pop(&$data_stack);
+    num2 = data_stack_pop;
 
     check_empty(data_stack, DIV);
-    num1 = *(cpu_type *) stack_pop(&$data_stack);
+    num1 = data_stack_pop;
 
     if (approx_equal(num2, 0))
     {
-        fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "DIV");
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "DIV");
         return false;
     }
 
     num1 /= num2;
-    stack_push(&$data_stack, &num1);
+    data_stack_push(num1, DIV);
     return true;
 }
 
@@ -465,23 +698,23 @@ bool execute_pow(machine *const computer)
     cpu_type num2 = 0;
 
     check_empty(data_stack, POW);
-    num2 = *(cpu_type *) stack_pop(&$data_stack);
+    num2 = data_stack_pop;
 
     check_empty(data_stack, POW);
-    num1 = *(cpu_type *) stack_pop(&$data_stack);
+    num1 = data_stack_pop;
 
     if (approx_equal(num1, 0) && num2 < 0)
     {
-        fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "POW");
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "POW");
         return false;
     }
     if (num1 < 0)
     {
-        fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "pow of less zero basis\n", "POW");
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "pow of less zero basis\n", "POW");
         return false;
     }
     num1 = pow(num1, num2);
-    stack_push(&$data_stack, &num1);
+    data_stack_push(num1, POW);
     return true;
 }
 
@@ -492,15 +725,15 @@ bool execute_sqrt(machine *const computer)
     cpu_type num = 0;
 
     check_empty(data_stack, SQRT);
-    num = *(cpu_type *) stack_pop(&$data_stack);
+    num = data_stack_pop;
 
     if (num < 0)
     {
-        fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "sqrt of less zero number\n", "SQRT");
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "sqrt of less zero number\n", "SQRT");
         return false;
     }
     num = sqrt(num);
-    stack_push(&$data_stack, &num);
+    data_stack_push(num, SQRT);
     return true;
 }
 
@@ -511,10 +744,10 @@ bool execute_sin(machine *const computer)
     cpu_type num = 0;
 
     check_empty(data_stack, SIN);
-    num = *(cpu_type *) stack_pop(&$data_stack);
+    num = data_stack_pop;
 
     num = sin(num);
-    stack_push(&$data_stack, &num);
+    data_stack_push(num, SIN);
     return true;
 }
 
@@ -525,10 +758,10 @@ bool execute_cos(machine *const computer)
     cpu_type num = 0;
 
     check_empty(data_stack, COS);
-    num = *(cpu_type *) stack_pop(&$data_stack);
+    num = data_stack_pop;
 
     num = cos(num);
-    stack_push(&$data_stack, &num);
+    data_stack_push(num, COS);
 
     return true;
 }
@@ -540,49 +773,1012 @@ bool execute_log(machine *const computer)
     cpu_type num = 0;
 
     check_empty(data_stack, LOG);
-    num = *(cpu_type *) stack_pop(&$data_stack);
+    num = data_stack_pop;
 
     if (num < 0 || approx_equal(num, 0))
     {
-        fprintf(stderr, "%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "log of less zero number\n", "LOG");
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "log of less zero number\n", "LOG");
         return false;
     }
     num = log(num);
-    stack_push(&$data_stack, &num);
+    data_stack_push(num, LOG);
+
+    return true;
+}
+
+/*===========================================================================================================================*/
+// EXECUTE_THREADED
+/*===========================================================================================================================*/
+
+/**
+*   @brief Исполняет программу с прямой шитой диспетчеризацией (GCC labels as values).
+*
+*   @note Каждый обработчик заканчивается собственным косвенным переходом на следующую инструкцию,
+*         поэтому предсказатель переходов видит отдельную историю для каждой команды.
+*   @note Без поддержки computed goto исполнение передается в execute().
+*/
+
+bool execute_threaded(machine *const computer)
+{
+    assert(computer != nullptr);
+
+#ifdef __GNUC__
+    bool no_err = computer->verified ? do_execute_threaded<false>(computer) :
+                                       do_execute_threaded<true> (computer);
+
+    machine_dtor(computer);
+    return no_err;
+#else
+    return execute(computer);
+#endif
+}
+
+#ifdef __GNUC__
+
+// checks if there are less than #count elements on the data stack (only if the program is not verified)
+#define threaded_check_size(count, instruction_name)                                                                        \
+    if (CHECKED && sp - data_beg + 1 < count)                                                                               \
+    {                                                                                                                       \
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "data_stack is empty\n", #instruction_name);    \
+        return false;                                                                                                       \
+    }
+
+// pushes #value on the data stack, the old top is spilled into memory
+#define threaded_push(value, instruction_name)                                                                              \
+    if (sp + 1 == data_end)                                                                                                 \
+    {                                                                                                                       \
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "data_stack overflow\n", #instruction_name);    \
+        return false;                                                                                                       \
+    }                                                                                                                       \
+    *sp++ = tos;                                                                                                            \
+    tos   = value;
+
+// pops two operands of the binary instruction #instruction_name into num1 and num2
+#define threaded_pop_operands(instruction_name)                                                                             \
+    threaded_check_size(2, instruction_name);                                                                               \
+    num2 = tos;                                                                                                             \
+    num1 = *--sp;
+
+// pops the operand of the unary instruction #instruction_name into num1
+#define threaded_pop_operand(instruction_name)                                                                              \
+    threaded_check_size(1, instruction_name);                                                                               \
+    num1 = tos;                                                                                                             \
+    tos  = *--sp;
+
+// jumps to the handler of the next instruction
+#define threaded_next                                                                                                       \
+    cur_cmd = ip++;                                                                                                         \
+    goto *DISPATCH[cur_cmd->cmd];
+
+// jumps to the label of the current instruction if #condition is true
+#define threaded_jump_if(condition)                                                                                         \
+    threaded_pop_operands(JUMP);                                                                                            \
+    tos = *--sp;                                                                                                            \
+    if (condition) ip = $cpu.cmd + cur_cmd->arg.label;                                                                      \
+    threaded_next
+
+/**
+*   @param CHECKED - проверять ли регистры-параметры, пустоту стека данных и стека вызовов.
+*                    Для программы, прошедшей program_verify(), эти проверки не нужны и не компилируются.
+*
+*   @note Вершина стека данных кешируется в локальной переменной tos, в памяти лежат только остальные элементы.
+*         sp указывает на ячейку вершины, для пустого стека это data[-1] (см. operand_stack_ctor()).
+*   @note Переполнение стеков, индекс RAM и области определения операций проверяются всегда.
+*/
+
+template <bool CHECKED>
+bool do_execute_threaded(machine *const computer)
+{
+    assert(computer != nullptr);
+
+    static const void *const DISPATCH[UNDEF_ASM_CMD] =
+    {
+        &&cmd_hlt   ,
+
+        &&cmd_in    ,
+        &&cmd_out   ,
+
+        &&cmd_push  ,
+        &&cmd_pop   ,
+
+        &&cmd_jmp   ,
+        &&cmd_ja    ,
+        &&cmd_jae   ,
+        &&cmd_jb    ,
+        &&cmd_jbe   ,
+        &&cmd_je    ,
+        &&cmd_jne   ,
+
+        &&cmd_call  ,
+        &&cmd_ret   ,
+
+        &&cmd_add   ,
+        &&cmd_sub   ,
+        &&cmd_mul   ,
+        &&cmd_div   ,
+        &&cmd_pow   ,
+        &&cmd_sqrt  ,
+        &&cmd_sin   ,
+        &&cmd_cos   ,
+        &&cmd_log   ,
+
+        &&cmd_add_reg,
+        &&cmd_jz    ,
+        &&cmd_add_mem,
+        &&cmd_mem_op,
+
+        &&cmd_addi  ,
+        &&cmd_subi  ,
+    };
+
+    const instruction *ip      = $cpu.cmd + $pc; // указатель на следующую инструкцию
+    const instruction *cur_cmd = nullptr;            // указатель на исполняемую инструкцию
+
+    cpu_type *const data_beg = $data_stack.data;
+    cpu_type *const data_end = $data_stack.data + $data_stack.capacity;
+    cpu_type       *sp       = $data_stack.data + $data_stack.size - 1;
+    cpu_type        tos      = *sp;
+
+    cpu_type num1 = 0;
+    cpu_type num2 = 0;
+
+    threaded_next
+
+cmd_hlt:
+    *sp = tos;
+
+    $data_stack.size = (int) (sp - data_beg + 1);
+    $pc              = (int) (ip - $cpu.cmd);
+    return true;
+
+cmd_in:
+    if (!io_read_double(&computer->io, &num1))
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "input value is not double\n", "IN");
+        return false;
+    }
+    threaded_push(num1, IN);
+    threaded_next
+
+cmd_out:
+    threaded_check_size(1, OUT);
+    io_write_double(&computer->io, tos);
+    threaded_next
+
+cmd_push:
+    {
+        const unsigned char param = cur_cmd->param;
+        const REGISTER    reg_arg = cur_cmd->reg;
+
+        if (param & (1 << PARAM_MEM))
+        {
+            int int_param = 0;
+
+            if (param & (1 << PARAM_NUM)) int_param += cur_cmd->arg.int_num;
+            if (param & (1 << PARAM_REG))
+            {
+                if (CHECKED)
+                {
+                    check_reg_arg    (reg_arg, PUSH);
+                    check_int_reg_arg(reg_arg, PUSH);
+                }
+                int_param += $int_reg[reg_arg];
+            }
+            check_ram_index(int_param, PUSH);
+            threaded_push($ram[int_param], PUSH);
+            threaded_next
+        }
+
+        num1 = 0;
+        if (param & (1 << PARAM_NUM)) num1 += cur_cmd->arg.dbl_num;
+        if (param & (1 << PARAM_REG))
+        {
+            if (CHECKED) { check_reg_arg(reg_arg, PUSH); }
+            if (is_int_reg(reg_arg)) num1 += $int_reg[reg_arg];
+            else                     num1 += $dbl_reg[reg_arg];
+        }
+        threaded_push(num1, PUSH);
+        threaded_next
+    }
+
+cmd_pop:
+    {
+        const unsigned char param = cur_cmd->param;
+        const REGISTER    reg_arg = cur_cmd->reg;
+
+        threaded_pop_operand(POP);
+
+        if (param & (1 << PARAM_MEM))
+        {
+            int int_param = 0;
+
+            if (param & (1 << PARAM_REG))
+            {
+                if (CHECKED)
+                {
+                    check_reg_arg    (reg_arg, POP);
+                    check_int_reg_arg(reg_arg, POP);
+                }
+                int_param += $int_reg[reg_arg];
+            }
+            if (param & (1 << PARAM_NUM)) int_param += cur_cmd->arg.int_num;
+
+            check_ram_index(int_param, POP);
+            $ram[int_param] = num1;
+            threaded_next
+        }
+        if (CHECKED && (param & (1 << PARAM_NUM)))
+        {
+            runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "rvalue as a pop-argument\n", "POP");
+            return false;
+        }
+        if (param & (1 << PARAM_REG))
+        {
+            if (CHECKED) { check_reg_arg(reg_arg, POP); }
+            if (is_int_reg(reg_arg)) $int_reg[reg_arg] = (int) num1;
+            else                     $dbl_reg[reg_arg] =       num1;
+        }
+        threaded_next
+    }
+
+cmd_jmp:
+    ip = $cpu.cmd + cur_cmd->arg.label;
+    threaded_next
+
+cmd_ja : threaded_jump_if(num1 > num2)
+cmd_jae: threaded_jump_if(num1 > num2 || approx_equal(num1, num2))
+cmd_jb : threaded_jump_if(num1 < num2)
+cmd_jbe: threaded_jump_if(num1 < num2 || approx_equal(num1, num2))
+cmd_je : threaded_jump_if(               approx_equal(num1, num2))
+cmd_jne: threaded_jump_if(              !approx_equal(num1, num2))
+
+cmd_call:
+    call_stack_push((int) (ip - $cpu.cmd), CALL);
+    ip = $cpu.cmd + cur_cmd->arg.label;
+    threaded_next
+
+cmd_ret:
+    if (CHECKED) { check_empty(call_stack, RET); }
+    ip = $cpu.cmd + call_stack_pop;
+    threaded_next
+
+cmd_add:
+    threaded_pop_operands(ADD);
+    tos = num1 + num2;
+    threaded_next
+
+cmd_sub:
+    threaded_pop_operands(SUB);
+    tos = num1 - num2;
+    threaded_next
+
+cmd_mul:
+    threaded_pop_operands(MUL);
+    tos = num1 * num2;
+    threaded_next
+
+cmd_div:
+    threaded_pop_operands(DIV);
+    if (approx_equal(num2, 0))
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "DIV");
+        return false;
+    }
+    tos = num1 / num2;
+    threaded_next
+
+cmd_pow:
+    threaded_pop_operands(POW);
+    if (approx_equal(num1, 0) && num2 < 0)
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "POW");
+        return false;
+    }
+    if (num1 < 0)
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "pow of less zero basis\n", "POW");
+        return false;
+    }
+    tos = pow(num1, num2);
+    threaded_next
+
+cmd_sqrt:
+    threaded_check_size(1, SQRT);
+    if (tos < 0)
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "sqrt of less zero number\n", "SQRT");
+        return false;
+    }
+    tos = sqrt(tos);
+    threaded_next
+
+cmd_sin:
+    threaded_check_size(1, SIN);
+    tos = sin(tos);
+    threaded_next
+
+cmd_cos:
+    threaded_check_size(1, COS);
+    tos = cos(tos);
+    threaded_next
+
+cmd_log:
+    threaded_check_size(1, LOG);
+    if (tos < 0 || approx_equal(tos, 0))
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "log of less zero number\n", "LOG");
+        return false;
+    }
+    tos = log(tos);
+    threaded_next
+
+cmd_add_reg:
+    {
+        const REGISTER reg_arg = cur_cmd->reg;
+
+        if (CHECKED) { check_reg_arg(reg_arg, ADD_REG); }
+        if (is_int_reg(reg_arg)) $int_reg[reg_arg] = (int) ($int_reg[reg_arg] + cur_cmd->arg.dbl_num);
+        else                     $dbl_reg[reg_arg] =        $dbl_reg[reg_arg] + cur_cmd->arg.dbl_num;
+        threaded_next
+    }
+
+cmd_jz:
+    threaded_pop_operand(JZ);
+    if (approx_equal(num1, 0)) ip = $cpu.cmd + cur_cmd->arg.label;
+    threaded_next
+
+cmd_add_mem:
+    {
+        const REGISTER reg_arg = cur_cmd->reg;
+
+        if (CHECKED)
+        {
+            check_reg_arg    (reg_arg, ADD_MEM);
+            check_int_reg_arg(reg_arg, ADD_MEM);
+        }
+        const int index1 = $int_reg[reg_arg] + cur_cmd->arg.ram_index[0];
+        const int index2 = $int_reg[reg_arg] + cur_cmd->arg.ram_index[1];
+
+        check_ram_index(index1, PUSH);
+        check_ram_index(index2, PUSH);
+        threaded_push($ram[index1] + $ram[index2], PUSH);
+        threaded_next
+    }
+
+cmd_mem_op:
+    {
+        const REGISTER reg_arg = cur_cmd->reg;
+
+        if (CHECKED)
+        {
+            check_reg_arg    (reg_arg, MEM_OP);
+            check_int_reg_arg(reg_arg, MEM_OP);
+        }
+        const int index = $int_reg[reg_arg] + cur_cmd->offset;
+        check_ram_index(index, PUSH);
+
+        num1 = $ram[index];
+        num2 = cur_cmd->arg.dbl_num;
+
+        switch (cur_cmd->param)
+        {
+            case ADD: num1 += num2; break;
+            case SUB: num1 -= num2; break;
+            case MUL: num1 *= num2; break;
+            case DIV: if (approx_equal(num2, 0))
+                      {
+                          runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "DIV");
+                          return false;
+                      }
+                      num1 /= num2;
+                      break;
+            default : runtime_error(TERMINAL_RED "RUNTIME ERROR: " TERMINAL_CANCEL "undefined command\n");
+                      return false;
+        }
+        threaded_push(num1, PUSH);
+        threaded_next
+    }
+
+cmd_addi:
+    if (CHECKED && (cur_cmd->reg <= 0 || cur_cmd->reg > REG_NUMBER || !is_int_reg(cur_cmd->reg)))
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "expected int register\n", "ADDI");
+        return false;
+    }
+    $int_reg[cur_cmd->reg] = (int) ((unsigned) $int_reg[cur_cmd->reg] + (unsigned) cur_cmd->arg.int_num);
+    threaded_next
+
+cmd_subi:
+    if (CHECKED && (cur_cmd->reg <= 0 || cur_cmd->reg > REG_NUMBER || !is_int_reg(cur_cmd->reg)))
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "expected int register\n", "SUBI");
+        return false;
+    }
+    $int_reg[cur_cmd->reg] = (int) ((unsigned) $int_reg[cur_cmd->reg] - (unsigned) cur_cmd->arg.int_num);
+    threaded_next
+}
+
+#undef threaded_check_size
+#undef threaded_push
+#undef threaded_pop_operands
+#undef threaded_pop_operand
+#undef threaded_next
+#undef threaded_jump_if
+
+#endif //__GNUC__
+
+/*===========================================================================================================================*/
+// EXECUTE_JIT
+/*===========================================================================================================================*/
+
+/**
+*   @brief Компилирует программу в машинный код x86-64 и исполняет его.
+*
+*   @note Глубина стека данных перед каждой инструкцией известна из program_verify(), поэтому элементы стека
+*         адресуются как [r12 + 8 * глубина], где r12 - начало кадра функции. CALL сдвигает r12 на глубину
+*         в точке вызова и становится call, RET - ret. Обращения к регистрам - прямые операнды [r14 + смещение],
+*         к RAM - [rt->ram + 8 * индекс] с проверкой индекса по rt->ram_size.
+*   @note IN, OUT и математические функции вызываются через jit_helper_*(), остальные инструкции компилируются в SSE2.
+*   @note Непроверенная программа (--no-verify) и программа, которую не удалось скомпилировать,
+*         исполняются execute_threaded().
+*/
+
+bool execute_jit(machine *const computer)
+{
+    assert(computer != nullptr);
+
+#ifdef __x86_64__
+    if (!computer->verified)
+    {
+        log_message("JIT: program is not verified, execute_threaded() is used instead\n");
+        return execute_threaded(computer);
+    }
+
+    jit_code jit = {};
+    if (!jit_ctor(&jit, &$cpu, computer->ram.limit > computer->ram.size) || !jit_load(&jit))
+    {
+        jit_dtor(&jit);
+        log_message("JIT: can't compile program, execute_threaded() is used instead\n");
+        return execute_threaded(computer);
+    }
+
+    const bool no_err = execute_jit_code(computer, &jit);
+
+    jit_dtor    (&jit);
+    machine_dtor(computer);
+    return no_err;
+#else
+    return execute_threaded(computer);
+#endif
+}
+
+/**
+*   @brief Исполняет программу, скомпилированную jit_ctor() и загруженную jit_load(), не освобождая машину.
+*
+*   @note Код исполняется на отдельном стеке (см. jit_stack_ctor()): глубина рекурсии ограничена --call-stack,
+*         а не размером стека потока. Если стек выделить не удалось, программа исполняется шитым кодом.
+*/
+
+bool execute_jit_code(machine *const computer, const jit_code *const jit)
+{
+    assert(computer != nullptr);
+    assert(jit      != nullptr);
+
+#ifdef __x86_64__
+    jit_runtime rt = {};
+
+    rt.abs_mask[0]   = 0x7FFFFFFFFFFFFFFFull;
+    rt.abs_mask[1]   = 0x7FFFFFFFFFFFFFFFull;
+    rt.delta         = 0.0001;  // как в approx_equal()
+    rt.error         = JIT_OK;
+    rt.computer      = computer;
+    rt.data          = $data_stack.data + $data_stack.size;
+    rt.data_end      = $data_stack.data + $data_stack.capacity;
+    rt.ram           = $ram;
+    rt.ram_size      = computer->ram.size;
+    rt.call_capacity = $call_stack.capacity - $call_stack.size;
+
+    jit_stack stack = {};
+    if (!jit_stack_ctor(&stack, rt.call_capacity))
+    {
+        log_message("JIT: can't allocate stack, execute_threaded() is used instead\n");
+        return execute_loaded(computer, nullptr, true);
+    }
+    rt.stack_top = stack.top;
+
+    rt.in   = jit_helper_in;
+    rt.out  = jit_helper_out;
+    rt.pow  = jit_helper_pow;
+    rt.sqrt = jit_helper_sqrt;
+    rt.sin  = jit_helper_sin;
+    rt.cos  = jit_helper_cos;
+    rt.log  = jit_helper_log;
+    rt.grow = jit_helper_grow;
+
+    void (*entry)(jit_runtime *const rt) = nullptr;
+    memcpy(&entry, &jit->exec, sizeof(entry));
+
+    entry(&rt);
+    jit_stack_dtor(&stack);
+
+    if (rt.error != JIT_OK)
+    {
+        runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "%s\n", JIT_ERROR_MESSAGES[rt.error][0],
+                                                                                     JIT_ERROR_MESSAGES[rt.error][1]);
+    }
+    return rt.error == JIT_OK;
+#else
+    return false;
+#endif
+}
+
+/*===========================================================================================================================*/
+// EXECUTE_REG
+/*===========================================================================================================================*/
+
+/**
+*   @brief Исполняет программу в регистровом коде (см. reg_lower()).
+*
+*   @note Регистры кадра лежат в стеке данных: slot[k] - это data[base + k]. CALL кладет в стек вызовов
+*         начало кадра и адрес возврата и сдвигает начало кадра на cur_cmd->shift, RET восстанавливает их.
+*   @note reg_decode() ограничивает индексы регистров кадра [-frame, frame), поэтому base держится
+*         в [data + frame, data + capacity - frame]: первый кадр начинается с запасом frame ячеек под ним.
+*/
+
+bool execute_reg(machine *const computer)
+{
+    assert(computer != nullptr);
+
+    const bool no_err = do_execute_reg(computer);
+
+    machine_dtor(computer);
+    return no_err;
+}
+
+// checks if the frame starting at #base_ptr fits in the data stack
+#define check_frame(base_ptr, instruction_name)                                                                             \
+  if (base_ptr < frame_beg || base_ptr > frame_end)                                                                         \
+  {                                                                                                                         \
+      runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "data_stack %s\n", instruction_name,             \
+                                                               (base_ptr < frame_beg) ? "underflow" : "overflow");          \
+      return false;                                                                                                         \
+  }
 
+bool do_execute_reg(machine *const computer)
+{
+    assert(computer != nullptr);
+
+    const reg_program *prog      = &computer->reg_cpu;
+    const cpu_type    *frame_beg = $data_stack.data + prog->frame;                         // наименьшее допустимое начало кадра
+    const cpu_type    *frame_end = $data_stack.data + $data_stack.capacity - prog->frame;  // наибольшее допустимое начало кадра
+
+    cpu_type *base = $data_stack.data + prog->frame;
+    int       pc   = 0;
+
+    check_frame(base, "HLT");
+
+    while (true)
+    {
+        const reg_instruction *cur_cmd = prog->cmd + pc++;
+
+        cpu_type num1 = 0;
+        cpu_type num2 = 0;
+
+        switch (cur_cmd->cmd)
+        {
+            case R_HLT : return true;
+
+            case R_IN  : if (!io_read_double(&computer->io, &num1))
+                         {
+                             runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "input value is not double\n", "IN");
+                             return false;
+                         }
+                         if (!execute_reg_write(computer, base, cur_cmd, num1)) return false;
+                         break;
+
+            case R_OUT : if (!execute_reg_read(computer, base, cur_cmd, &cur_cmd->src1, &num1)) return false;
+                         io_write_double(&computer->io, num1);
+                         break;
+
+            case R_MOV : if (!execute_reg_read (computer, base, cur_cmd, &cur_cmd->src1, &num1)) return false;
+                         if (!execute_reg_write(computer, base, cur_cmd, num1))                 return false;
+                         break;
+
+            case R_CALL: call_stack_push((int) (base - $data_stack.data), CALL);
+                         call_stack_push(pc                             , CALL);
+                         [[fallthrough]];
+            case R_JMP : base += cur_cmd->shift;
+                         check_frame(base, REG_ASM_CMD_NAMES[cur_cmd->cmd]);
+
+                         pc = cur_cmd->label;
+                         break;
+
+            case R_JA  :
+            case R_JAE :
+            case R_JB  :
+            case R_JBE :
+            case R_JE  :
+            case R_JNE : if (!execute_reg_read(computer, base, cur_cmd, &cur_cmd->src1, &num1) ||
+                             !execute_reg_read(computer, base, cur_cmd, &cur_cmd->src2, &num2)) return false;
+
+                         if (execute_reg_condition(cur_cmd->cmd, num1, num2))
+                         {
+                             base += cur_cmd->shift;
+                             check_frame(base, REG_ASM_CMD_NAMES[cur_cmd->cmd]);
+
+                             pc = cur_cmd->label;
+                         }
+                         break;
+
+            case R_RET : check_empty(call_stack, RET);
+                         pc = call_stack_pop;
+
+                         check_empty(call_stack, RET);
+                         base = $data_stack.data + call_stack_pop;
+                         break;
+
+            case R_ADD :
+            case R_SUB :
+            case R_MUL :
+            case R_DIV :
+            case R_POW : if (!execute_reg_read(computer, base, cur_cmd, &cur_cmd->src2, &num2)) return false;
+                         [[fallthrough]];
+            case R_SQRT:
+            case R_SIN :
+            case R_COS :
+            case R_LOG : if (!execute_reg_read (computer, base, cur_cmd, &cur_cmd->src1, &num1)) return false;
+                         if (!execute_reg_calc (computer, cur_cmd->cmd, num1, num2, &num1))               return false;
+                         if (!execute_reg_write(computer, base, cur_cmd, num1))                 return false;
+                         break;
+
+            default    : runtime_error(TERMINAL_RED "RUNTIME ERROR: " TERMINAL_CANCEL "undefined command\n");
+                         log_error("default case in do_execute_reg(): cmd=%d(%d)\n", cur_cmd->cmd, __LINE__);
+                         return false;
+        }
+    }
     return true;
 }
 
+#undef check_frame
+
+bool execute_reg_read(machine *const computer, const cpu_type *const base, const reg_instruction *const cur_cmd,
+                                                                          const reg_operand     *const operand,
+                                                                                cpu_type        *const value)
+{
+    assert(computer != nullptr);
+    assert(base     != nullptr);
+    assert(cur_cmd  != nullptr);
+    assert(operand  != nullptr);
+    assert(value    != nullptr);
+
+    int ram_index = 0;
+
+    switch (operand->type)
+    {
+        case OPERAND_SLOT: *value = base[operand->arg.slot];
+                           return true;
+
+        case OPERAND_NUM : *value = operand->arg.num;
+                           return true;
+
+        case OPERAND_REG : *value = is_int_reg(operand->reg) ? $int_reg[operand->reg] : $dbl_reg[operand->reg];
+                           return true;
+
+        case OPERAND_RAM : ram_index = operand->arg.ram_index + (operand->reg == ERR_REG ? 0 : $int_reg[operand->reg]);
+                           if ((ram_index < 0 || ram_index >= computer->ram.size) && !ram_grow(&computer->ram, ram_index))
+                           {
+                               runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "invalid ram index\n",
+                                               REG_ASM_CMD_NAMES[cur_cmd->cmd]);
+                               return false;
+                           }
+                           *value = $ram[ram_index];
+                           return true;
+
+        default          : log_error(         "default case in execute_reg_read(): type=%d(%d)\n", operand->type, __LINE__);
+                           assert   (false && "default case in execute_reg_read()");
+                           break;
+    }
+    return false;
+}
+
+/**
+*   @brief Записывает value в результат инструкции cur_cmd.
+*
+*   @note Как и POP, в целочисленный регистр число кладется с отбрасыванием дробной части.
+*/
+
+bool execute_reg_write(machine *const computer, cpu_type *const base, const reg_instruction *const cur_cmd,
+                                                                     const cpu_type              value)
+{
+    assert(computer != nullptr);
+    assert(base     != nullptr);
+    assert(cur_cmd  != nullptr);
+
+    const reg_operand *dst = &cur_cmd->dst;
+    int ram_index = 0;
+
+    switch (dst->type)
+    {
+        case OPERAND_SLOT: base[dst->arg.slot] = value;
+                           return true;
+
+        case OPERAND_REG : if (is_int_reg(dst->reg)) $int_reg[dst->reg] = (int) value;
+                           else                      $dbl_reg[dst->reg] =       value;
+                           return true;
+
+        case OPERAND_RAM : ram_index = dst->arg.ram_index + (dst->reg == ERR_REG ? 0 : $int_reg[dst->reg]);
+                           if ((ram_index < 0 || ram_index >= computer->ram.size) && !ram_grow(&computer->ram, ram_index))
+                           {
+                               runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "invalid ram index\n",
+                                               REG_ASM_CMD_NAMES[cur_cmd->cmd]);
+                               return false;
+                           }
+                           $ram[ram_index] = value;
+                           return true;
+
+        default          : log_error(         "default case in execute_reg_write(): type=%d(%d)\n", dst->type, __LINE__);
+                           assert   (false && "default case in execute_reg_write()");
+                           break;
+    }
+    return false;
+}
+
+/**
+*   @brief Вычисляет result = num1 op num2 (или op num1 для унарных команд) с теми же проверками, что и стековый код.
+*/
+
+bool execute_reg_calc(machine *const computer, const unsigned char cmd, const cpu_type num1, const cpu_type num2, cpu_type *const result)
+{
+    assert(computer != nullptr);
+    assert(result   != nullptr);
+
+    switch (cmd)
+    {
+        case R_ADD : *result = num1 + num2; return true;
+        case R_SUB : *result = num1 - num2; return true;
+        case R_MUL : *result = num1 * num2; return true;
+
+        case R_DIV : if (approx_equal(num2, 0))
+                     {
+                         runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "DIV");
+                         return false;
+                     }
+                     *result = num1 / num2;
+                     return true;
+
+        case R_POW : if (approx_equal(num1, 0) && num2 < 0)
+                     {
+                         runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "division by zero\n", "POW");
+                         return false;
+                     }
+                     if (num1 < 0)
+                     {
+                         runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "pow of less zero basis\n", "POW");
+                         return false;
+                     }
+                     *result = pow(num1, num2);
+                     return true;
+
+        case R_SQRT: if (num1 < 0)
+                     {
+                         runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "sqrt of less zero number\n", "SQRT");
+                         return false;
+                     }
+                     *result = sqrt(num1);
+                     return true;
+
+        case R_SIN : *result = sin(num1); return true;
+        case R_COS : *result = cos(num1); return true;
+
+        case R_LOG : if (num1 < 0 || approx_equal(num1, 0))
+                     {
+                         runtime_error("%-5s" TERMINAL_RED " RUNTIME ERROR: " TERMINAL_CANCEL "log of less zero number\n", "LOG");
+                         return false;
+                     }
+                     *result = log(num1);
+                     return true;
+
+        default    : log_error(         "default case in execute_reg_calc(): cmd=%d(%d)\n", cmd, __LINE__);
+                     assert   (false && "default case in execute_reg_calc()");
+                     break;
+    }
+    return false;
+}
+
+bool execute_reg_condition(const unsigned char cmd, const cpu_type num1, const cpu_type num2)
+{
+    switch (cmd)
+    {
+        case R_JA : return num1 > num2;
+        case R_JAE: return num1 > num2 || approx_equal(num1, num2);
+        case R_JB : return num1 < num2;
+        case R_JBE: return num1 < num2 || approx_equal(num1, num2);
+        case R_JE : return                approx_equal(num1, num2);
+        case R_JNE: return               !approx_equal(num1, num2);
+
+        default   : log_error(         "default case in execute_reg_condition(): cmd=%d(%d)\n", cmd, __LINE__);
+                    assert   (false && "default case in execute_reg_condition()");
+                    break;
+    }
+    return false;
+}
+
 /*===========================================================================================================================*/
 // MACHINE_CTOR_DTOR
 /*===========================================================================================================================*/
 
-bool machine_ctor(machine *const computer, const char *execute_file)
+bool machine_ctor(machine *const computer, const char *execute_file, const bool verify,
+                                                                       const int  data_stack_capacity,
+                                                                       const int  call_stack_capacity,
+                                                                       const char *out_file,
+                                                                       const int  ram_size,
+                                                                       const int  ram_limit)
 {
     assert(computer     != nullptr);
     assert(execute_file != nullptr);
 
-    bool no_err = true;
+    binary_file file   = {};
+    bool        no_err = binary_load(&file, execute_file);
+
+    int ram_cells = ram_size;
+    if (ram_cells <= 0) ram_cells = file.header.ram_size;
+    if (ram_cells <= 0) ram_cells = RAM_SIZE;
 
-    stack_ctor(&$call_stack, sizeof(int));
-    stack_ctor(&$data_stack, sizeof(cpu_type));
+    no_err = no_err && operand_stack_ctor(&$data_stack, data_stack_capacity) &&
+                       return_stack_ctor (&$call_stack, call_stack_capacity) &&
+                       io_ctor           (&computer->io, out_file) &&
+                       ram_ctor          (&computer->ram, ram_cells, ram_limit);
 
-    no_err = executer_ctor(&$cpu, execute_file);
+    computer->reg_code = no_err && file.header.encoding == ENCODING_REG;
+    if (no_err) no_err = computer->reg_code ? reg_decode   (&computer->reg_cpu, &file.code) :
+                                              binary_decode(&$cpu             , &file);
+    binary_unload(&file);
+
+    computer->verified = false;
+    computer->shared   = false;
+    $pc                = 0;
+
+    if (no_err && verify && !computer->reg_code) no_err = computer->verified = program_verify(&$cpu);
 
-    for (int i = 0; i <  RAM_SIZE  ; ++i)     $ram[i] = 0;
     for (int i = 0; i <= REG_NUMBER; ++i) $int_reg[i] = 0;
 
     if (no_err) return true;
 
-    log_error("executer_ctor returned false(%d)\n", __LINE__);
+    log_error("can't load execute file \"%s\"(%d)\n", execute_file, __LINE__);
     return false;
 }
 
+/**
+*   @brief Создает машину, исполняющую программу машины origin: у нее свои стеки, регистры, RAM и ввод-вывод,
+*          а декодированная программа общая и только читается.
+*
+*   @note machine_dtor() такой машины не освобождает программу, origin должна жить дольше нее.
+*/
+
+bool machine_share_ctor(machine *const computer, const machine *const origin)
+{
+    assert(computer != nullptr);
+    assert(origin   != nullptr);
+
+    $cpu               = origin->cpu;
+    computer->reg_cpu  = origin->reg_cpu;
+    computer->reg_code = origin->reg_code;
+    computer->verified = origin->verified;
+    computer->shared   = true;
+    $pc                = 0;
+
+    for (int i = 0; i <= REG_NUMBER; ++i) $int_reg[i] = 0;
+    for (int i = 0; i <= REG_NUMBER; ++i) $dbl_reg[i] = 0;
+
+    return operand_stack_ctor(&$data_stack, origin->data_stack.capacity) &&
+           return_stack_ctor (&$call_stack, origin->call_stack.capacity) &&
+           io_ctor           (&computer->io) &&
+           ram_ctor          (&computer->ram, origin->ram.initial_size, origin->ram.limit);
+}
+
+/**
+*   @brief Возвращает машину в состояние после machine_ctor(), не перезагружая программу.
+*
+*   @note Сбрасываются стеки, регистры и RAM (см. ram_reset()). Ввод и вывод не меняются.
+*/
+
+void machine_reset(machine *const computer)
+{
+    assert(computer != nullptr);
+
+    $data_stack.size = 0;
+    $call_stack.size = 0;
+    $pc              = 0;
+
+    for (int i = 0; i <= REG_NUMBER; ++i) $int_reg[i] = 0;
+    for (int i = 0; i <= REG_NUMBER; ++i) $dbl_reg[i] = 0;
+
+    ram_reset(&computer->ram);
+}
+
 void machine_dtor(machine *const computer)
 {
     assert(computer != nullptr);
 
-    stack_dtor   (&$call_stack);
-    stack_dtor   (&$data_stack);
-    executer_dtor(&$cpu);
+    return_stack_dtor (&$call_stack);
+    operand_stack_dtor(&$data_stack);
+    if (!computer->shared)
+    {
+        program_dtor    (&$cpu);
+        reg_program_dtor(&computer->reg_cpu);
+    }
+    $cpu              = {};
+    computer->reg_cpu = {};
+    io_dtor           (&computer->io);
+    ram_dtor          (&computer->ram);
+}
+
+/*===========================================================================================================================*/
+// STACK_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Выделяет память под стек данных емкости capacity.
+*
+*   @note Перед первым элементом выделяется еще одна ячейка, так что запись в data[-1] безопасна.
+*         Туда сбрасывается закешированная вершина пустого стека в do_execute_threaded().
+*/
+
+bool operand_stack_ctor(operand_stack *const stk, const int capacity)
+{
+    assert(stk      != nullptr);
+    assert(capacity >        0);
+
+    stk->data     = (cpu_type *) log_calloc((size_t) capacity + 1, sizeof(cpu_type));
+    stk->size     = 0;
+    stk->capacity = capacity;
+
+    if (stk->data == nullptr)
+    {
+        log_error(        "can't allocate memory for data stack(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for data stack\n");
+        return false;
+    }
+    stk->data += 1;
+    return true;
+}
+
+void operand_stack_dtor(operand_stack *const stk)
+{
+    assert(stk != nullptr);
+
+    if (stk->data != nullptr) log_free(stk->data - 1);
+
+    stk->data     = nullptr;
+    stk->size     = 0;
+    stk->capacity = 0;
+}
+
+bool return_stack_ctor(return_stack *const stk, const int capacity)
+{
+    assert(stk      != nullptr);
+    assert(capacity >        0);
+
+    stk->data     = (int *) log_calloc((size_t) capacity, sizeof(int));
+    stk->size     = 0;
+    stk->capacity = capacity;
+
+    if (stk->data == nullptr)
+    {
+        log_error(        "can't allocate memory for call stack(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for call stack\n");
+        return false;
+    }
+    return true;
+}
+
+void return_stack_dtor(return_stack *const stk)
+{
+    assert(stk != nullptr);
+
+    log_free(stk->data);
+
+    stk->data     = nullptr;
+    stk->size     = 0;
+    stk->capacity = 0;
 }
\ No newline at end of file
@@ -2,7 +2,12 @@
 #define MACHINE
 
 #include "cpu.h"
-#include "../../lib/stack/stack.h"
+#include "decoder.h"
+#include "verifier.h"
+#include "regcode.h"
+#include "profiler.h"
+#include "buffered_io.h"
+#include "machine_ram.h"
 
 /*===========================================================================================================================*/
 // DSL
@@ -10,8 +15,9 @@
 
 #define _CALL_STACK(computer) computer->call_stack
 #define _DATA_STACK(computer) computer->data_stack
-#define        _RAM(computer) computer->ram
+#define        _RAM(computer) computer->ram.data
 #define        _CPU(computer) computer->cpu
+#define         _PC(computer) computer->pc
 #define    _INT_REG(computer) computer->int_reg
 #define    _DBL_REG(computer) computer->dbl_reg
 
@@ -19,6 +25,7 @@
 #define $data_stack _DATA_STACK(computer)
 #define $ram               _RAM(computer)
 #define $cpu               _CPU(computer)
+#define $pc                 _PC(computer)
 #define $int_reg       _INT_REG(computer)
 #define $dbl_reg       _DBL_REG(computer)
 
@@ -26,40 +33,64 @@
 // CONST
 /*===========================================================================================================================*/
 
-const int RAM_SIZE = 10000;
+const int DATA_STACK_CAPACITY = 1 << 16;    // емкость стека данных по умолчанию
+const int CALL_STACK_CAPACITY = 1 << 16;    // емкость стека вызовов по умолчанию
 
 /*===========================================================================================================================*/
 // STRUCT
 /*===========================================================================================================================*/
 
+struct operand_stack                    // стек с данными фиксированной емкости
+{
+    cpu_type *data;                     // массив элементов
+    int       size;                     // количество элементов
+    int       capacity;                 // емкость .data
+};
+
+struct return_stack                     // стек адресов возврата фиксированной емкости
+{
+    int *data;                          // массив индексов инструкций, следующих за CALL
+    int  size;                          // количество элементов
+    int  capacity;                      // емкость .data
+};
+
 struct machine
 {
-    stack    call_stack;                // стек вызовов
-    stack    data_stack;                // стек с данными
-    executer cpu;                       // структура, содержащая инструкции и параметры
-    cpu_type ram    [RAM_SIZE];         // оперативка
-    int      int_reg[REG_NUMBER + 1];   // целочисленные  регистры
-    double   dbl_reg[REG_NUMBER + 1];   // действительные регистры
+    return_stack  call_stack;               // стек вызовов
+    operand_stack data_stack;               // стек с данными
+    program       cpu;                      // декодированные инструкции и параметры (только для чтения)
+    int           pc;                       // индекс следующей инструкции в .cpu
+    bool          verified;                 // программа прошла program_verify(), шитый код исполняется без лишних проверок
+    reg_program   reg_cpu;                  // программа в регистровом коде (см. reg_lower())
+    bool          reg_code;                 // исполняемый файл содержит регистровый код, исполняется execute_reg()
+    bool          shared;                   // программа принадлежит другой машине (см. machine_share_ctor())
+    machine_io    io;                       // буферизованный ввод и вывод IN и OUT
+    machine_ram   ram;                      // оперативка (см. ram_ctor())
+    int           int_reg[REG_NUMBER + 1];  // целочисленные  регистры
+    double        dbl_reg[REG_NUMBER + 1];  // действительные регистры
 };
 
 /*===========================================================================================================================*/
 // EXECUTE
 /*===========================================================================================================================*/
 
+struct jit_code;
+
 bool execute                   (machine *const computer);
+bool execute_profiled          (machine *const computer, const char *const report_file);
+bool execute_loaded            (machine *const computer, const jit_code *const jit, const bool threaded);
+void report_source_line        (machine *const computer);
+template <bool PROFILE>
+bool do_execute                (machine *const computer, profiler *const prof);
 
-bool execute_param             (machine *const computer, const unsigned char cmd);
-bool execute_push              (machine *const computer, const unsigned char cmd);
-bool execute_pop               (machine *const computer, const unsigned char cmd);
-bool executer_pull_reg_int     (machine *const computer, const unsigned char cmd, bool     *const mem_arg,
-                                                                                  REGISTER *const reg_arg,
-                                                                                  int      *const cpu_arg);
-bool executer_pull_reg_dbl     (machine *const computer, const unsigned char cmd, bool     *const mem_arg,
-                                                                                  REGISTER *const reg_arg,
-                                                                                  double   *const cpu_arg);
-bool execute_call              (machine *const computer);
-bool execute_jump              (machine *const computer, const unsigned char cmd);
-bool executer_pull_label       (machine *const computer, int *const label_pc);
+bool execute_push              (machine *const computer, const instruction *const cur_cmd);
+bool execute_pop               (machine *const computer, const instruction *const cur_cmd);
+bool execute_call              (machine *const computer, const instruction *const cur_cmd);
+bool execute_jump              (machine *const computer, const instruction *const cur_cmd);
+bool execute_add_reg           (machine *const computer, const instruction *const cur_cmd);
+bool execute_add_mem           (machine *const computer, const instruction *const cur_cmd);
+bool execute_mem_op            (machine *const computer, const instruction *const cur_cmd);
+bool execute_int_alu           (machine *const computer, const instruction *const cur_cmd);
 
 bool execute_in                (machine *const computer);
 bool execute_out               (machine *const computer);
@@ -74,11 +105,58 @@ bool execute_sin               (machine *const computer);
 bool execute_cos               (machine *const computer);
 bool execute_log               (machine *const computer);
 
+/*===========================================================================================================================*/
+// EXECUTE_THREADED
+/*===========================================================================================================================*/
+
+bool execute_threaded          (machine *const computer);
+template <bool CHECKED>
+bool do_execute_threaded       (machine *const computer);
+
+/*===========================================================================================================================*/
+// EXECUTE_JIT
+/*===========================================================================================================================*/
+
+bool execute_jit               (machine *const computer);
+bool execute_jit_code          (machine *const computer, const jit_code *const jit);
+
+/*===========================================================================================================================*/
+// EXECUTE_REG
+/*===========================================================================================================================*/
+
+bool execute_reg               (machine *const computer);
+bool do_execute_reg            (machine *const computer);
+
+bool execute_reg_read          (machine *const computer, const cpu_type *const base, const reg_instruction *const cur_cmd,
+                                                                                    const reg_operand     *const operand,
+                                                                                          cpu_type        *const value);
+bool execute_reg_write         (machine *const computer,       cpu_type *const base, const reg_instruction *const cur_cmd,
+                                                                                    const cpu_type              value);
+bool execute_reg_calc          (machine *const computer, const unsigned char cmd, const cpu_type num1, const cpu_type num2, cpu_type *const result);
+bool execute_reg_condition     (const unsigned char cmd, const cpu_type num1, const cpu_type num2);
+
 /*===========================================================================================================================*/
 // MACHINE_CTOR_DTOR
 /*===========================================================================================================================*/
 
-bool machine_ctor (machine *const computer, const char *execute_file);
-void machine_dtor (machine *const computer);
+bool machine_ctor (machine *const computer, const char *execute_file, const bool verify              = true,
+                                                                       const int  data_stack_capacity = DATA_STACK_CAPACITY,
+                                                                       const int  call_stack_capacity = CALL_STACK_CAPACITY,
+                                                                       const char *out_file           = nullptr,
+                                                                       const int  ram_size            = 0,
+                                                                       const int  ram_limit           = 0);
+bool machine_share_ctor(machine *const computer, const machine *const origin);
+void machine_reset     (machine *const computer);
+void machine_dtor      (machine *const computer);
+
+/*===========================================================================================================================*/
+// STACK_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool operand_stack_ctor (operand_stack *const stk, const int capacity);
+void operand_stack_dtor (operand_stack *const stk);
+
+bool return_stack_ctor  (return_stack  *const stk, const int capacity);
+void return_stack_dtor  (return_stack  *const stk);
 
 #endif //MACHINE
\ No newline at end of file
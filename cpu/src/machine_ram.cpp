@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../../lib/logs/log.h"
+
+#include "machine_ram.h"
+
+/*===========================================================================================================================*/
+// RAM
+/*===========================================================================================================================*/
+
+/**
+*   @brief Расширяет RAM так, чтобы ячейка index стала доступна.
+*
+*   @return true, если ячейка index доступна и false, если index < 0 или index >= ram->limit
+*
+*   @note RAM растет как минимум вдвое, чтобы при последовательном росте индексов mprotect() вызывался редко.
+*/
+
+bool ram_grow(machine_ram *const ram, const int index)
+{
+    assert(ram != nullptr);
+
+    if (index < 0 || index >= ram->limit) return false;
+    if (index < ram->size)                return true;
+
+    long long new_size = 2 * (long long) ram->size;
+    if (new_size < (long long) index + 1) new_size = (long long) index + 1;
+    if (new_size > ram->limit)            new_size = ram->limit;
+
+    if (!ram_commit(ram, (size_t) new_size * sizeof(cpu_type))) return false;
+
+    ram->size = (int) new_size;
+    return true;
+}
+
+/**
+*   @brief Открывает для чтения и записи первые bytes байт RAM (с округлением до страницы).
+*
+*   @note Физическая память под страницы выделяется ядром при первом обращении к ним.
+*/
+
+bool ram_commit(machine_ram *const ram, const size_t bytes)
+{
+    assert(ram != nullptr);
+
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t need = (bytes + page - 1) / page * page;
+
+    if (need <= ram->committed) return true;
+
+    if (mprotect((char *) ram->data + ram->committed, need - ram->committed, PROT_READ | PROT_WRITE) != 0)
+    {
+        log_error("can't commit %zu bytes of RAM(%d)\n", need, __LINE__);
+        return false;
+    }
+    ram->committed = need;
+    return true;
+}
+
+/**
+*   @brief Обнуляет RAM и возвращает ей размер после ram_ctor().
+*
+*   @note Небольшая RAM обнуляется memset(). У большой ядро освобождает страницы по madvise(MADV_DONTNEED),
+*         при следующем обращении они снова заполняются нулями. Так стоимость сброса зависит от количества
+*         страниц, которых касалась программа, а не от размера RAM.
+*/
+
+void ram_reset(machine_ram *const ram)
+{
+    assert(ram != nullptr);
+
+    if (ram->committed <= RAM_RESET_MEMSET || madvise(ram->data, ram->committed, MADV_DONTNEED) != 0)
+    {
+        memset(ram->data, 0, ram->committed);
+    }
+
+    ram->size = ram->initial_size;
+}
+
+/*===========================================================================================================================*/
+// RAM_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Резервирует адресное пространство под limit ячеек RAM и открывает первые size ячеек.
+*
+*   @param limit - наибольший размер RAM при росте (0 или limit <= size - RAM не растет)
+*
+*   @note Вокруг RAM лежат страницы без доступа, поэтому выход за границы мимо проверок индекса
+*         заканчивается ошибкой сегментации, а не порчей чужой памяти.
+*/
+
+bool ram_ctor(machine_ram *const ram, const int size, const int limit)
+{
+    assert(ram  != nullptr);
+    assert(size >        0);
+
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+
+    ram->size         = size;
+    ram->initial_size = size;
+    ram->limit        = (limit > size) ? limit : size;
+    ram->committed    = 0;
+    ram->region_size  = ((size_t) ram->limit * sizeof(cpu_type) + page - 1) / page * page + 2 * page;
+    ram->region       = mmap(nullptr, ram->region_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (ram->region == MAP_FAILED)
+    {
+        log_error(        "can't reserve memory for RAM(%d)\n", __LINE__);
+        fprintf  (stderr, "can't reserve memory for RAM\n");
+        *ram = {};
+        return false;
+    }
+    ram->data = (cpu_type *) ((char *) ram->region + page);
+
+    if (!ram_commit(ram, (size_t) size * sizeof(cpu_type)))
+    {
+        fprintf (stderr, "can't allocate memory for RAM\n");
+        ram_dtor(ram);
+        return false;
+    }
+    return true;
+}
+
+void ram_dtor(machine_ram *const ram)
+{
+    assert(ram != nullptr);
+
+    if (ram->region != nullptr) munmap(ram->region, ram->region_size);
+
+    *ram = {};
+}
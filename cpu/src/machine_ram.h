@@ -0,0 +1,44 @@
+#ifndef MACHINE_RAM
+#define MACHINE_RAM
+
+#include "cpu.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+const int    RAM_SIZE         = 10000;   // размер RAM по умолчанию (в ячейках)
+const size_t RAM_RESET_MEMSET = 1 << 17; // RAM не больше стольких байт ram_reset() обнуляет memset(), а не madvise()
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct machine_ram                      // оперативка машины: отображение анонимной памяти
+{
+    cpu_type *data;                     // ячейки RAM
+    int       size;                     // количество доступных ячеек
+    int       limit;                    // до скольких ячеек RAM может расти (limit == size - без роста)
+    int       initial_size;             // размер RAM после ram_ctor(), к нему возвращает ram_reset()
+
+    void     *region;                   // зарезервированная область: [guard][limit ячеек][guard]
+    size_t    region_size;              // размер .region
+    size_t    committed;                // сколько байт с начала .data доступно для чтения и записи
+};
+
+/*===========================================================================================================================*/
+// RAM
+/*===========================================================================================================================*/
+
+bool ram_grow  (machine_ram *const ram, const int index);
+bool ram_commit(machine_ram *const ram, const size_t bytes);
+void ram_reset (machine_ram *const ram);
+
+/*===========================================================================================================================*/
+// RAM_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool ram_ctor  (machine_ram *const ram, const int size = RAM_SIZE, const int limit = 0);
+void ram_dtor  (machine_ram *const ram);
+
+#endif //MACHINE_RAM
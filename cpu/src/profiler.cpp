@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../lib/logs/log.h"
+
+#include "profiler.h"
+#include "terminal_colors.h"
+
+/*===========================================================================================================================*/
+// PROFILE
+/*===========================================================================================================================*/
+
+/**
+*   @brief Отмечает вызов функции, начинающейся с инструкции label.
+*
+*   @note Вызывается после успешного исполнения CALL. Время до вызова приписывается вызывающей функции.
+*/
+
+void profiler_call(profiler *const prof, const int label)
+{
+    assert(prof != nullptr);
+    assert(prof->frame_size < prof->frame_capacity);
+
+    profiler_account(prof);
+
+    const int parent = prof->frame[prof->frame_size - 1].node;
+
+    prof->frame[prof->frame_size].node     = profiler_node_child(prof, parent, label);
+    prof->frame[prof->frame_size].start_ns = prof->last_ns;
+    prof->frame_size++;
+
+    prof->func_calls [label]++;
+    prof->func_active[label]++;
+}
+
+/**
+*   @brief Отмечает возврат из функции.
+*/
+
+void profiler_ret(profiler *const prof)
+{
+    assert(prof != nullptr);
+
+    if (prof->frame_size <= 1) return;
+
+    profiler_account(prof);
+
+    const profile_frame *top  = prof->frame + --prof->frame_size;
+    const int            func = prof->node[top->node].func;
+
+    if (--prof->func_active[func] == 0) prof->func_incl_ns[func] += prof->last_ns - top->start_ns;
+}
+
+/**
+*   @brief Завершает профилирование: закрывает все активные вызовы (исполнение могло остановиться внутри функции).
+*/
+
+void profiler_stop(profiler *const prof)
+{
+    assert(prof != nullptr);
+
+    while (prof->frame_size > 1) profiler_ret(prof);
+
+    profiler_account(prof);
+
+    prof->total_ns          = prof->last_ns - prof->frame[0].start_ns;
+    prof->func_incl_ns[0]   = prof->total_ns;
+    prof->frame_size        = 0;
+}
+
+/**
+*   @brief Приписывает время, прошедшее с последнего CALL или RET, текущему стеку вызовов.
+*/
+
+void profiler_account(profiler *const prof)
+{
+    assert(prof != nullptr);
+
+    const long long now   = get_time_ns();
+    const int       node  = prof->frame[prof->frame_size - 1].node;
+    const long long delta = now - prof->last_ns;
+
+    prof->node[node].self_ns                 += delta;
+    prof->func_excl_ns[prof->node[node].func] += delta;
+    prof->last_ns                             = now;
+}
+
+/**
+*   @brief Находит потомка parent для функции func в дереве вызовов, при необходимости создает его.
+*
+*   @return индекс потомка
+*/
+
+int profiler_node_child(profiler *const prof, const int parent, const int func)
+{
+    assert(prof != nullptr);
+
+    for (int child = prof->node[parent].child; child != -1; child = prof->node[child].next)
+    {
+        if (prof->node[child].func == func) return child;
+    }
+
+    if (prof->node_size == prof->node_capacity)
+    {
+        profile_node *new_node = (profile_node *) log_realloc(prof->node, 2 * (size_t) prof->node_capacity * sizeof(profile_node));
+        if (new_node == nullptr)
+        {
+            log_error("can't allocate memory for call tree(%d)\n", __LINE__);
+            abort();
+        }
+        prof->node           = new_node;
+        prof->node_capacity *= 2;
+    }
+
+    const int child = prof->node_size++;
+
+    prof->node[child].func    = func;
+    prof->node[child].parent  = parent;
+    prof->node[child].child   = -1;
+    prof->node[child].next    = prof->node[parent].child;
+    prof->node[child].self_ns = 0;
+
+    prof->node[parent].child = child;
+    return child;
+}
+
+long long get_time_ns()
+{
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long) now.tv_sec * 1000000000ll + now.tv_nsec;
+}
+
+/*===========================================================================================================================*/
+// REPORT
+/*===========================================================================================================================*/
+
+/**
+*   @brief Записывает отчет в report_file и свернутые стеки в report_file.folded.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool profiler_write(const profiler *const prof, const program *const prog, const char *const report_file)
+{
+    assert(prof        != nullptr);
+    assert(prog        != nullptr);
+    assert(report_file != nullptr);
+
+    const size_t name_len    = strlen(report_file);
+    char        *folded_file = (char *) log_calloc(name_len + strlen(PROFILE_FOLDED_SUFFIX) + 1, sizeof(char));
+    if (folded_file == nullptr)
+    {
+        log_error("can't allocate memory for profile file name(%d)\n", __LINE__);
+        return false;
+    }
+    strcpy(folded_file           , report_file);
+    strcpy(folded_file + name_len, PROFILE_FOLDED_SUFFIX);
+
+    FILE *report = fopen(report_file, "w");
+    FILE *folded = fopen(folded_file, "w");
+
+    bool no_err = report != nullptr && folded != nullptr;
+    if  (no_err)
+    {
+        profiler_write_report(prof, prog, report);
+        profiler_write_folded(prof, prog, folded);
+    }
+    else fprintf(stderr, TERMINAL_RED "PROFILE ERROR: " TERMINAL_CANCEL "can't open \"%s\" or \"%s\"\n", report_file, folded_file);
+
+    if (report != nullptr) fclose(report);
+    if (folded != nullptr) fclose(folded);
+
+    log_free(folded_file);
+    return no_err;
+}
+
+/**
+*   @brief Записывает отчет: по строке на каждую запись, поля разделены табуляцией.
+*
+*   @note Формат:
+*         total   <исполнено инструкций>  <время, нс>
+*         cmd     <команда>   <исполнений>
+*         pc      <индекс инструкции> <команда>   <исполнений>
+*         func    <функция>   <индекс первой инструкции>  <вызовов>   <inclusive, нс> <exclusive, нс>
+*         Функция - "main" для всей программы, для целей CALL - имя метки из таблицы символов
+*         или "func_<индекс первой инструкции>", если таблицы нет.
+*/
+
+void profiler_write_report(const profiler *const prof, const program *const prog, FILE *const stream)
+{
+    assert(prof   != nullptr);
+    assert(prog   != nullptr);
+    assert(stream != nullptr);
+
+    long long total = 0;
+    for (int i = 0; i < UNDEF_ASM_CMD; ++i) total += prof->cmd_count[i];
+
+    fprintf(stream, "total\t%lld\t%lld\n", total, prof->total_ns);
+
+    for (int i = 0; i < UNDEF_ASM_CMD; ++i)
+    {
+        if (prof->cmd_count[i] != 0) fprintf(stream, "cmd\t%s\t%lld\n", ASM_CMD_NAMES[i], prof->cmd_count[i]);
+    }
+
+    for (int i = 0; i < prof->size; ++i)
+    {
+        if (prof->pc_count[i] != 0) fprintf(stream, "pc\t%d\t%s\t%lld\n", i, ASM_CMD_NAMES[prog->cmd[i].cmd], prof->pc_count[i]);
+    }
+
+    for (int i = 0; i < prof->size; ++i)
+    {
+        if (i != 0 && prof->func_calls[i] == 0) continue;
+
+        fprintf             (stream, "func\t");
+        profiler_write_func (prog, stream, i);
+        fprintf             (stream, "\t%d\t%lld\t%lld\t%lld\n", i, i == 0 ? 1 : prof->func_calls[i], prof->func_incl_ns[i],
+                                                                                                       prof->func_excl_ns[i]);
+    }
+}
+
+/**
+*   @brief Записывает свернутые стеки в формате flamegraph.pl: "main;func_12;func_40 <exclusive, нс>".
+*/
+
+void profiler_write_folded(const profiler *const prof, const program *const prog, FILE *const stream)
+{
+    assert(prof   != nullptr);
+    assert(prog   != nullptr);
+    assert(stream != nullptr);
+
+    for (int i = 0; i < prof->node_size; ++i)
+    {
+        if (prof->node[i].self_ns == 0) continue;
+
+        profiler_write_path(prof, prog, stream, i);
+        fprintf(stream, " %lld\n", prof->node[i].self_ns);
+    }
+}
+
+void profiler_write_path(const profiler *const prof, const program *const prog, FILE *const stream, const int node)
+{
+    assert(prof   != nullptr);
+    assert(prog   != nullptr);
+    assert(stream != nullptr);
+
+    if (prof->node[node].parent != -1)
+    {
+        profiler_write_path(prof, prog, stream, prof->node[node].parent);
+        fprintf(stream, ";");
+    }
+    profiler_write_func(prog, stream, prof->node[node].func);
+}
+
+void profiler_write_func(const program *const prog, FILE *const stream, const int func)
+{
+    assert(prog   != nullptr);
+    assert(stream != nullptr);
+
+    if      (func == 0)                                            fprintf(stream, "main");
+    else if (prog->name != nullptr && prog->name[func] != nullptr) fprintf(stream, "%s", prog->name[func]);
+    else                                                           fprintf(stream, "func_%d", func);
+}
+
+/*===========================================================================================================================*/
+// PROFILER_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Готовит профилировщик к исполнению prog и запускает отсчет времени.
+*
+*   @param call_stack_capacity - емкость стека вызовов машины, столько кадров может быть активно одновременно
+*/
+
+bool profiler_ctor(profiler *const prof, const program *const prog, const int call_stack_capacity)
+{
+    assert(prof != nullptr);
+    assert(prog != nullptr);
+
+    const size_t size = (size_t) prog->size + 1;
+
+    for (int i = 0; i < UNDEF_ASM_CMD; ++i) prof->cmd_count[i] = 0;
+
+    prof->size           = prog->size;
+    prof->pc_count       = (long long     *) log_calloc(size, sizeof(long long));
+    prof->func_calls     = (long long     *) log_calloc(size, sizeof(long long));
+    prof->func_incl_ns   = (long long     *) log_calloc(size, sizeof(long long));
+    prof->func_excl_ns   = (long long     *) log_calloc(size, sizeof(long long));
+    prof->func_active    = (int           *) log_calloc(size, sizeof(int));
+    prof->node           = (profile_node  *) log_calloc(size, sizeof(profile_node));
+    prof->node_size      = 0;
+    prof->node_capacity  = (int) size;
+    prof->frame          = (profile_frame *) log_calloc((size_t) call_stack_capacity + 1, sizeof(profile_frame));
+    prof->frame_size     = 0;
+    prof->frame_capacity = call_stack_capacity + 1;
+
+    if (prof->pc_count == nullptr || prof->func_calls  == nullptr || prof->func_incl_ns == nullptr ||
+        prof->node     == nullptr || prof->func_active == nullptr || prof->func_excl_ns == nullptr || prof->frame == nullptr)
+    {
+        log_error(        "can't allocate memory for profiler(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for profiler\n");
+        profiler_dtor(prof);
+        return false;
+    }
+
+    prof->node[0]   = {0, -1, -1, -1, 0};   // корень - вся программа
+    prof->node_size = 1;
+
+    prof->last_ns  = get_time_ns();
+    prof->total_ns = 0;
+    prof->frame[0] = {0, prof->last_ns};
+    prof->frame_size = 1;
+
+    return true;
+}
+
+void profiler_dtor(profiler *const prof)
+{
+    assert(prof != nullptr);
+
+    log_free(prof->pc_count);
+    log_free(prof->func_calls);
+    log_free(prof->func_incl_ns);
+    log_free(prof->func_excl_ns);
+    log_free(prof->func_active);
+    log_free(prof->node);
+    log_free(prof->frame);
+
+    *prof = {};
+}
@@ -0,0 +1,82 @@
+#ifndef PROFILER
+#define PROFILER
+
+#include "decoder.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+static const char *const PROFILE_FOLDED_SUFFIX = ".folded";   // файл со свернутыми стеками: <отчет>.folded
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct profile_node             // вершина дерева вызовов (путь от корня - стек вызовов)
+{
+    int       func;             // индекс первой инструкции функции (0 - вся программа)
+    int       parent;           // индекс родителя в profiler::node (-1 у корня)
+    int       child;            // первый потомок
+    int       next;             // следующий потомок родителя
+    long long self_ns;          // время, проведенное в функции с этим стеком вызовов, без вызванных из нее функций
+};
+
+struct profile_frame            // активный вызов функции
+{
+    int       node;             // вершина дерева вызовов
+    long long start_ns;         // время входа в функцию
+};
+
+struct profiler
+{
+    long long      cmd_count[UNDEF_ASM_CMD];    // количество исполнений каждой команды
+    long long     *pc_count;                    // pc_count[i] - количество исполнений инструкции i
+    int            size;                        // количество инструкций в программе
+
+    long long     *func_calls;                  // func_*[i] - статистика функции, начинающейся с инструкции i
+    long long     *func_incl_ns;                // время с учетом вызванных функций (рекурсивные вызовы не учитываются повторно)
+    long long     *func_excl_ns;                // время без учета вызванных функций
+    int           *func_active;                 // количество кадров функции в стеке вызовов
+
+    profile_node  *node;                        // дерево вызовов
+    int            node_size;
+    int            node_capacity;
+
+    profile_frame *frame;                       // стек активных вызовов, frame[0] - вся программа
+    int            frame_size;
+    int            frame_capacity;
+
+    long long      last_ns;                     // время последнего CALL или RET
+    long long      total_ns;                    // время исполнения программы
+};
+
+/*===========================================================================================================================*/
+// PROFILE
+/*===========================================================================================================================*/
+
+void profiler_call          (profiler *const prof, const int label);
+void profiler_ret           (profiler *const prof);
+void profiler_stop          (profiler *const prof);
+void profiler_account       (profiler *const prof);
+int  profiler_node_child    (profiler *const prof, const int parent, const int func);
+long long get_time_ns       ();
+
+/*===========================================================================================================================*/
+// REPORT
+/*===========================================================================================================================*/
+
+bool profiler_write         (const profiler *const prof, const program *const prog, const char *const report_file);
+void profiler_write_report  (const profiler *const prof, const program *const prog, FILE *const stream);
+void profiler_write_folded  (const profiler *const prof, const program *const prog, FILE *const stream);
+void profiler_write_path    (const profiler *const prof, const program *const prog, FILE *const stream, const int node);
+void profiler_write_func    (const program *const prog, FILE *const stream, const int func);
+
+/*===========================================================================================================================*/
+// PROFILER_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool profiler_ctor          (profiler *const prof, const program *const prog, const int call_stack_capacity);
+void profiler_dtor          (profiler *const prof);
+
+#endif //PROFILER
@@ -0,0 +1,847 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "../../lib/logs/log.h"
+
+#include "regcode.h"
+#include "verifier.h"
+#include "terminal_colors.h"
+
+/*===========================================================================================================================*/
+// LOWER
+/*===========================================================================================================================*/
+
+/**
+*   @brief Переводит стековый код в трехадресный регистровый.
+*
+*   @param out  [out] - регистровый код
+*   @param prog [in]  - стековый код
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Значение на глубине k стека функции хранится в регистре кадра slot[k]. Кадр функции начинается там,
+*         где была вершина стека при CALL, поэтому аргументы, положенные вызывающей функцией, лежат в slot[-1], slot[-2], ...
+*   @note PUSH не порождает инструкций: число, регистр машины или ячейка RAM становятся операндом инструкции,
+*         которая снимает значение со стека. В регистры кадра значения записываются только перед переходами,
+*         метками, вызовами и записью в RAM или регистры машины.
+*   @note Стековый код должен проходить program_verify(): глубина стека перед каждой инструкцией должна быть известна.
+*/
+
+bool reg_lower(reg_program *const out, const program *const prog)
+{
+    assert(out  != nullptr);
+    assert(prog != nullptr);
+
+    reg_lowering low = {};
+    if (!reg_lowering_ctor(&low, out, prog)) return false;
+
+    if (!program_verify(prog, low.depth))
+    {
+        fprintf(stderr, TERMINAL_RED "LOWER ERROR: " TERMINAL_CANCEL "stack code can't be verified\n");
+        reg_lowering_dtor(&low);
+        return false;
+    }
+
+    out->frame = 1;
+    for (int i = 0; i < prog->size; ++i)
+    {
+        const instruction *cur_cmd = prog->cmd + i;
+
+        switch (cur_cmd->cmd)
+        {
+            case CALL: low.is_func[cur_cmd->arg.label] = true;
+                       [[fallthrough]];
+            case JMP :
+            case JA  :
+            case JAE :
+            case JB  :
+            case JBE :
+            case JE  :
+            case JNE :
+            case JZ  : low.is_target[cur_cmd->arg.label] = true;
+                       break;
+            default  : break;
+        }
+        if (low.depth[i] != UNKNOWN_DEPTH && low.depth[i] + 1 > out->frame) out->frame = low.depth[i] + 1;
+    }
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        if (low.is_target[i]) reg_flush(&low, false);
+
+        low.label_map[i] = out->size;
+        if (low.depth[i] == UNKNOWN_DEPTH) continue;    // недостижимая инструкция
+
+        if (!reg_lower_cmd(&low, i))
+        {
+            reg_lowering_dtor(&low);
+            return false;
+        }
+    }
+    low.label_map[prog->size] = out->size;
+
+    for (int i = 0; i < out->size; ++i)
+    {
+        const unsigned char cmd = out->cmd[i].cmd;
+        if (cmd == R_JMP || cmd == R_CALL || (R_JA <= cmd && cmd <= R_JNE)) out->cmd[i].label = low.label_map[out->cmd[i].label];
+    }
+    out->cmd[out->size].cmd = R_HLT;
+
+    reg_lowering_dtor(&low);
+    return true;
+}
+
+/**
+*   @brief Переводит инструкцию стекового кода low->prog->cmd[index].
+*/
+
+bool reg_lower_cmd(reg_lowering *const low, const int index)
+{
+    assert(low != nullptr);
+
+    const program     *prog    = low->prog;
+    const instruction *cur_cmd = prog->cmd + index;
+    const int          d       = low->depth[index];
+
+    int next_depth = d;         // глубина стека при переходе к следующей инструкции
+
+    switch (cur_cmd->cmd)
+    {
+        case HLT : reg_flush(low, true);     // отложенные чтения RAM выполняются, чтобы проверить индексы
+                   reg_emit (low, R_HLT);
+                   low->vsize = 0;
+                   return true;
+
+        case IN  : reg_emit(low, R_IN)->dst = reg_slot(d);
+                   reg_put (low, d, reg_slot(d));
+                   next_depth = d + 1;
+                   break;
+
+        case OUT : {
+                        const reg_operand top = reg_take(low, d - 1);
+
+                        reg_emit(low, R_OUT)->src1 = top;
+                        reg_put (low, d - 1, top);
+                        break;
+                   }
+
+        case PUSH: reg_lower_push(low, cur_cmd, d);
+                   next_depth = d + 1;
+                   break;
+
+        case POP : reg_lower_pop(low, cur_cmd, d);
+                   next_depth = d - 1;
+                   break;
+
+        case JMP : reg_flush       (low, false);
+                   reg_lower_branch(low, R_JMP, cur_cmd->arg.label, d);
+                   return true;
+
+        case JA  :
+        case JAE :
+        case JB  :
+        case JBE :
+        case JE  :
+        case JNE : {
+                        const reg_operand num2 = reg_take(low, d - 1);
+                        const reg_operand num1 = reg_take(low, d - 2);
+
+                        reg_flush       (low, false);
+                        reg_lower_branch(low, (unsigned char) (R_JA + (cur_cmd->cmd - JA)), cur_cmd->arg.label, d - 2);
+
+                        reg_last(low)->src1 = num1;
+                        reg_last(low)->src2 = num2;
+                        next_depth = d - 2;
+                        break;
+                   }
+
+        case JZ  : {
+                        const reg_operand num1 = reg_take(low, d - 1);
+
+                        reg_flush       (low, false);
+                        reg_lower_branch(low, R_JE, cur_cmd->arg.label, d - 1);
+
+                        reg_last(low)->src1 = num1;
+                        reg_last(low)->src2 = reg_num(0);
+                        next_depth = d - 1;
+                        break;
+                   }
+
+        case CALL: if (index + 1 < prog->size && low->is_func[index + 1])
+                   {
+                       fprintf(stderr, TERMINAL_RED "LOWER ERROR: " TERMINAL_CANCEL "instruction %d (CALL): falls through into function %d\n",
+                                       index, index + 1);
+                       return false;
+                   }
+                   reg_flush       (low, false);
+                   reg_lower_branch(low, R_CALL, cur_cmd->arg.label, d);
+                   reg_last(low)->shift = d;
+                   return true;
+
+        case RET : reg_flush(low, false);
+                   reg_emit (low, R_RET);
+                   return true;
+
+        case ADD :
+        case SUB :
+        case MUL :
+        case DIV :
+        case POW : {
+                        const reg_operand num2 = reg_take(low, d - 1);
+                        const reg_operand num1 = reg_take(low, d - 2);
+
+                        reg_instruction *cmd = reg_emit(low, (unsigned char) (R_ADD + (cur_cmd->cmd - ADD)));
+                        cmd->dst  = reg_slot(d - 2);
+                        cmd->src1 = num1;
+                        cmd->src2 = num2;
+
+                        reg_put(low, d - 2, reg_slot(d - 2));
+                        next_depth = d - 1;
+                        break;
+                   }
+
+        case SQRT:
+        case SIN :
+        case COS :
+        case LOG : {
+                        const reg_operand num1 = reg_take(low, d - 1);
+
+                        reg_instruction *cmd = reg_emit(low, (unsigned char) (R_SQRT + (cur_cmd->cmd - SQRT)));
+                        cmd->dst  = reg_slot(d - 1);
+                        cmd->src1 = num1;
+
+                        reg_put(low, d - 1, reg_slot(d - 1));
+                        break;
+                   }
+
+        case ADD_REG: {
+                        reg_flush(low, true);
+
+                        reg_instruction *cmd = reg_emit(low, R_ADD);
+                        cmd->dst  = reg_machine(cur_cmd->reg);
+                        cmd->src1 = reg_machine(cur_cmd->reg);
+                        cmd->src2 = reg_num    (cur_cmd->arg.dbl_num);
+                        break;
+                      }
+
+        case ADDI   :
+        case SUBI   : {
+                        reg_flush(low, true);
+
+                        reg_instruction *cmd = reg_emit(low, (cur_cmd->cmd == ADDI) ? R_ADD : R_SUB);
+                        cmd->dst  = reg_machine(cur_cmd->reg);
+                        cmd->src1 = reg_machine(cur_cmd->reg);
+                        cmd->src2 = reg_num    (cur_cmd->arg.int_num);
+                        break;
+                      }
+
+        case ADD_MEM: {
+                        reg_instruction *cmd = reg_emit(low, R_ADD);
+                        cmd->dst  = reg_slot(d);
+                        cmd->src1 = reg_ram (cur_cmd->reg, cur_cmd->arg.ram_index[0]);
+                        cmd->src2 = reg_ram (cur_cmd->reg, cur_cmd->arg.ram_index[1]);
+
+                        reg_put(low, d, reg_slot(d));
+                        next_depth = d + 1;
+                        break;
+                      }
+
+        case MEM_OP : {
+                        reg_instruction *cmd = reg_emit(low, (unsigned char) (R_ADD + (cur_cmd->param - ADD)));
+                        cmd->dst  = reg_slot(d);
+                        cmd->src1 = reg_ram (cur_cmd->reg, cur_cmd->offset);
+                        cmd->src2 = reg_num (cur_cmd->arg.dbl_num);
+
+                        reg_put(low, d, reg_slot(d));
+                        next_depth = d + 1;
+                        break;
+                      }
+
+        default     : fprintf(stderr, TERMINAL_RED "LOWER ERROR: " TERMINAL_CANCEL "instruction %d: undefined command\n", index);
+                      return false;
+    }
+
+    if (index + 1 < prog->size && low->is_func[index + 1])
+    {
+        // проваливание в начало функции - хвостовой переход: кадр функции начинается на текущей глубине
+        reg_flush(low, false);
+        if (next_depth != 0) reg_lower_branch(low, R_JMP, index + 1, next_depth);
+    }
+    return true;
+}
+
+void reg_lower_push(reg_lowering *const low, const instruction *const cur_cmd, const int d)
+{
+    assert(low     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const unsigned char param = cur_cmd->param;
+
+    if (param & (1 << PARAM_MEM))
+    {
+        reg_put(low, d, reg_ram((param & (1 << PARAM_REG)) ? cur_cmd->reg         : ERR_REG,
+                                (param & (1 << PARAM_NUM)) ? cur_cmd->arg.int_num : 0));
+        return;
+    }
+    if ((param & (1 << PARAM_REG)) && (param & (1 << PARAM_NUM)))
+    {
+        reg_instruction *cmd = reg_emit(low, R_ADD);
+        cmd->dst  = reg_slot   (d);
+        cmd->src1 = reg_num    (cur_cmd->arg.dbl_num);
+        cmd->src2 = reg_machine(cur_cmd->reg);
+
+        reg_put(low, d, reg_slot(d));
+        return;
+    }
+    if (param & (1 << PARAM_REG)) reg_put(low, d, reg_machine(cur_cmd->reg));
+    else                          reg_put(low, d, reg_num((param & (1 << PARAM_NUM)) ? cur_cmd->arg.dbl_num : 0));
+}
+
+/**
+*   @note Если снимаемое значение только что вычислено предыдущей инструкцией, результат этой инструкции
+*         сразу записывается по адресу POP (при условии, что на текущую инструкцию нет переходов
+*         и отложенные чтения RAM и регистров машины не увидят записи раньше времени).
+*/
+
+void reg_lower_pop(reg_lowering *const low, const instruction *const cur_cmd, const int d)
+{
+    assert(low     != nullptr);
+    assert(cur_cmd != nullptr);
+
+    const unsigned char param = cur_cmd->param;
+    const reg_operand   top   = reg_take(low, d - 1);
+
+    if (!(param & (1 << PARAM_MEM)) && !(param & (1 << PARAM_REG)))   // pop void
+    {
+        if (top.type == OPERAND_RAM)    // чтение RAM все равно выполняется, чтобы проверить индекс
+        {
+            reg_instruction *cmd = reg_emit(low, R_MOV);
+            cmd->dst  = reg_slot(d - 1);
+            cmd->src1 = top;
+        }
+        return;
+    }
+
+    const reg_operand dest = (param & (1 << PARAM_MEM)) ?
+                             reg_ram    ((param & (1 << PARAM_REG)) ? cur_cmd->reg         : ERR_REG,
+                                         (param & (1 << PARAM_NUM)) ? cur_cmd->arg.int_num : 0) :
+                             reg_machine(cur_cmd->reg);
+
+    const int index = (int) (cur_cmd - low->prog->cmd);
+
+    bool pending_memory = false;
+    for (int k = 0; k < low->vsize; ++k)
+    {
+        if (low->vstack[k].type == OPERAND_RAM || low->vstack[k].type == OPERAND_REG) pending_memory = true;
+    }
+
+    if (top.type == OPERAND_SLOT && low->out->size > 0 && low->label_map[index] < low->out->size && !pending_memory)
+    {
+        reg_instruction *last = reg_last(low);
+
+        if (last->dst.type == OPERAND_SLOT && last->dst.arg.slot == d - 1 && last->cmd != R_IN)
+        {
+            last->dst = dest;
+            return;
+        }
+    }
+
+    reg_flush(low, true);
+
+    reg_instruction *cmd = reg_emit(low, R_MOV);
+    cmd->dst  = dest;
+    cmd->src1 = top;
+}
+
+/**
+*   @brief Добавляет переход cmd на инструкцию стекового кода label с глубиной стека d.
+*
+*   @note Метка переводится в индекс регистровой инструкции после перевода всей программы.
+*         Переход в начало функции сдвигает кадр на d, как CALL.
+*/
+
+void reg_lower_branch(reg_lowering *const low, const unsigned char cmd, const int label, const int d)
+{
+    assert(low != nullptr);
+
+    reg_instruction *branch = reg_emit(low, cmd);
+
+    branch->label = label;
+    branch->shift = low->is_func[label] ? d : 0;
+}
+
+/**
+*   @brief Снимает с виртуального стека значение, лежащее на глубине slot.
+*
+*   @return операнд, из которого можно прочитать это значение
+*/
+
+reg_operand reg_take(reg_lowering *const low, const int slot)
+{
+    assert(low != nullptr);
+
+    if (low->vsize == 0) return reg_slot(slot);
+
+    assert(low->vslot[low->vsize - 1] == slot);
+    return low->vstack[--low->vsize];
+}
+
+void reg_put(reg_lowering *const low, const int slot, const reg_operand operand)
+{
+    assert(low != nullptr);
+
+    low->vstack[low->vsize] = operand;
+    low->vslot [low->vsize] = slot;
+    low->vsize++;
+}
+
+/**
+*   @brief Записывает отложенные значения виртуального стека в регистры кадра.
+*
+*   @param only_memory - записать только чтения RAM и регистров машины (перед записью в них), числа оставить операндами
+*/
+
+void reg_flush(reg_lowering *const low, const bool only_memory)
+{
+    assert(low != nullptr);
+
+    for (int k = 0; k < low->vsize; ++k)
+    {
+        const reg_operand operand = low->vstack[k];
+
+        if (operand.type == OPERAND_SLOT)                 continue;
+        if (operand.type == OPERAND_NUM  && only_memory) continue;
+
+        reg_instruction *cmd = reg_emit(low, R_MOV);
+        cmd->dst  = reg_slot(low->vslot[k]);
+        cmd->src1 = operand;
+
+        low->vstack[k] = reg_slot(low->vslot[k]);
+    }
+    if (!only_memory) low->vsize = 0;
+}
+
+reg_instruction *reg_emit(reg_lowering *const low, const unsigned char cmd)
+{
+    assert(low != nullptr);
+
+    reg_program *out = low->out;
+
+    if (out->size == out->capacity)
+    {
+        const int new_capacity = 2 * out->capacity + 1;
+
+        reg_instruction *new_cmd = (reg_instruction *) log_realloc(out->cmd, (size_t) (new_capacity + 1) * sizeof(reg_instruction)); // +1 for R_HLT sentinel
+        if (new_cmd == nullptr)
+        {
+            log_error("can't allocate memory for register code(%d)\n", __LINE__);
+            abort();
+        }
+        out->cmd      = new_cmd;
+        out->capacity = new_capacity;
+    }
+
+    reg_instruction *cur_cmd = out->cmd + out->size++;
+    *cur_cmd     = {};
+    cur_cmd->cmd = cmd;
+
+    return cur_cmd;
+}
+
+reg_instruction *reg_last(reg_lowering *const low)
+{
+    assert(low            != nullptr);
+    assert(low->out->size  >       0);
+
+    return low->out->cmd + low->out->size - 1;
+}
+
+reg_operand reg_slot(const int slot)
+{
+    reg_operand operand = {};
+
+    operand.type     = OPERAND_SLOT;
+    operand.reg      = ERR_REG;
+    operand.arg.slot = slot;
+
+    return operand;
+}
+
+reg_operand reg_num(const double num)
+{
+    reg_operand operand = {};
+
+    operand.type    = OPERAND_NUM;
+    operand.reg     = ERR_REG;
+    operand.arg.num = num;
+
+    return operand;
+}
+
+reg_operand reg_ram(const REGISTER reg, const int ram_index)
+{
+    reg_operand operand = {};
+
+    operand.type          = OPERAND_RAM;
+    operand.reg           = reg;
+    operand.arg.ram_index = ram_index;
+
+    return operand;
+}
+
+reg_operand reg_machine(const REGISTER reg)
+{
+    reg_operand operand = {};
+
+    operand.type = OPERAND_REG;
+    operand.reg  = reg;
+
+    return operand;
+}
+
+/*===========================================================================================================================*/
+// ENCODE_DECODE
+/*===========================================================================================================================*/
+
+bool is_reg_code(const executer *const cpu)
+{
+    assert(cpu != nullptr);
+
+    int signature = 0;
+    if (cpu->capacity < (int) sizeof(int)) return false;
+
+    memcpy(&signature, cpu->cmd, sizeof(int));
+    return signature == REG_SIGNATURE;
+}
+
+/**
+*   @brief Упаковывает регистровый код в бинарный вид.
+*
+*   @note Формат: REG_SIGNATURE, frame, size, затем инструкции: команда (1 байт), dst (если есть), аргументы,
+*         для переходов и CALL - индекс инструкции-метки и сдвиг кадра. Операнд: тип (1 байт) и его параметры.
+*/
+
+bool reg_encode(const reg_program *const prog, executer *const cpu)
+{
+    assert(prog != nullptr);
+    assert(cpu  != nullptr);
+
+    const size_t max_cmd_size = sizeof(unsigned char) + 3 * (sizeof(unsigned char) + sizeof(REGISTER) + sizeof(double)) +
+                                2 * sizeof(int);
+    const size_t max_size     = 3 * sizeof(int) + (size_t) prog->size * max_cmd_size;
+
+    executer_ctor(cpu, (int) (max_size / sizeof(cpu_type)) + 1);
+    if (cpu->cmd == nullptr)
+    {
+        log_error("can't allocate memory for register code(%d)\n", __LINE__);
+        return false;
+    }
+
+    executer_add_cmd(cpu, &REG_SIGNATURE, sizeof(int));
+    executer_add_cmd(cpu, &prog->frame  , sizeof(int));
+    executer_add_cmd(cpu, &prog->size   , sizeof(int));
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        const reg_instruction *cur_cmd = prog->cmd + i;
+
+        bool has_dst = false;
+        int  src_num = get_reg_operand_num(cur_cmd->cmd, &has_dst);
+
+        executer_add_cmd(cpu, &cur_cmd->cmd, sizeof(unsigned char));
+
+        if (has_dst)     reg_encode_operand(cpu, &cur_cmd->dst);
+        if (src_num > 0) reg_encode_operand(cpu, &cur_cmd->src1);
+        if (src_num > 1) reg_encode_operand(cpu, &cur_cmd->src2);
+
+        if (cur_cmd->cmd == R_JMP || cur_cmd->cmd == R_CALL || (R_JA <= cur_cmd->cmd && cur_cmd->cmd <= R_JNE))
+        {
+            executer_add_cmd(cpu, &cur_cmd->label, sizeof(int));
+            executer_add_cmd(cpu, &cur_cmd->shift, sizeof(int));
+        }
+    }
+    return true;
+}
+
+void reg_encode_operand(executer *const cpu, const reg_operand *const operand)
+{
+    assert(cpu     != nullptr);
+    assert(operand != nullptr);
+
+    executer_add_cmd(cpu, &operand->type, sizeof(unsigned char));
+
+    switch (operand->type)
+    {
+        case OPERAND_SLOT: executer_add_cmd(cpu, &operand->arg.slot     , sizeof(int));
+                           break;
+        case OPERAND_NUM : executer_add_cmd(cpu, &operand->arg.num      , sizeof(double));
+                           break;
+        case OPERAND_RAM : executer_add_cmd(cpu, &operand->reg          , sizeof(REGISTER));
+                           executer_add_cmd(cpu, &operand->arg.ram_index, sizeof(int));
+                           break;
+        case OPERAND_REG : executer_add_cmd(cpu, &operand->reg          , sizeof(REGISTER));
+                           break;
+        default          : log_error(         "default case in reg_encode_operand(): type=%d(%d)\n", operand->type, __LINE__);
+                           assert   (false && "default case in reg_encode_operand()");
+                           break;
+    }
+}
+
+/**
+*   @brief Распаковывает регистровый код, созданный reg_encode().
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Проверяются команды, типы операндов, регистры машины и кадра, метки и сдвиги кадра. После последней инструкции кладется R_HLT.
+*/
+
+bool reg_decode(reg_program *const prog, executer *const cpu)
+{
+    assert(prog != nullptr);
+    assert(cpu  != nullptr);
+
+    int signature = 0;
+    int frame     = 0;
+    int size      = 0;
+
+    cpu->pc = 0;
+    if (!reg_pull(cpu, &signature, sizeof(int)) || !reg_pull(cpu, &frame, sizeof(int)) || !reg_pull(cpu, &size, sizeof(int)) ||
+        signature != REG_SIGNATURE || frame <= 0 || size < 0 || size > cpu->capacity)
+    {
+        fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "invalid register code header\n");
+        return false;
+    }
+
+    if (!reg_program_ctor(prog, size)) return false;
+    prog->frame = frame;
+
+    for (int i = 0; i < size; ++i)
+    {
+        reg_instruction *cur_cmd = prog->cmd + i;
+        *cur_cmd = {};
+
+        if (!reg_pull(cpu, &cur_cmd->cmd, sizeof(unsigned char))) return false;
+
+        bool has_dst = false;
+        int  src_num = get_reg_operand_num(cur_cmd->cmd, &has_dst);
+
+        if (src_num == -1)
+        {
+            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "undefined command in register instruction %d\n", i);
+            return false;
+        }
+
+        if (has_dst     && !reg_decode_operand(cpu, &cur_cmd->dst , frame)) return false;
+        if (src_num > 0 && !reg_decode_operand(cpu, &cur_cmd->src1, frame)) return false;
+        if (src_num > 1 && !reg_decode_operand(cpu, &cur_cmd->src2, frame)) return false;
+
+        if (has_dst && cur_cmd->dst.type == OPERAND_NUM)
+        {
+            fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "rvalue as a result of register instruction %d\n", i);
+            return false;
+        }
+
+        if (cur_cmd->cmd == R_JMP || cur_cmd->cmd == R_CALL || (R_JA <= cur_cmd->cmd && cur_cmd->cmd <= R_JNE))
+        {
+            if (!reg_pull(cpu, &cur_cmd->label, sizeof(int)) || !reg_pull(cpu, &cur_cmd->shift, sizeof(int))) return false;
+
+            if (cur_cmd->label < 0 || cur_cmd->label > size)
+            {
+                fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "label of register instruction %d pointed out of program\n", i);
+                return false;
+            }
+            if (cur_cmd->shift < -frame || cur_cmd->shift > frame)
+            {
+                fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "frame shift of register instruction %d is out of frame\n", i);
+                return false;
+            }
+        }
+        prog->size++;
+    }
+    prog->cmd[prog->size].cmd = R_HLT;
+
+    return true;
+}
+
+/**
+*   @brief Читает операнд регистровой инструкции.
+*
+*   @note Регистр кадра должен лежать в [-frame, frame): отрицательные индексы - аргументы в кадре вызывающей функции.
+*/
+
+bool reg_decode_operand(executer *const cpu, reg_operand *const operand, const int frame)
+{
+    assert(cpu     != nullptr);
+    assert(operand != nullptr);
+
+    *operand = {};
+    if (!reg_pull(cpu, &operand->type, sizeof(unsigned char))) return false;
+
+    bool no_err = true;
+    int  reg    = ERR_REG;  // номер регистра проверяется до приведения к REGISTER: в файле может быть любое число
+
+    static_assert(sizeof(REGISTER) == sizeof(int), "register number is stored as int");
+
+    switch (operand->type)
+    {
+        case OPERAND_SLOT: no_err = reg_pull(cpu, &operand->arg.slot, sizeof(int)) && -frame <= operand->arg.slot && operand->arg.slot < frame;
+                           break;
+        case OPERAND_NUM : no_err = reg_pull(cpu, &operand->arg.num , sizeof(double));
+                           break;
+        case OPERAND_RAM : no_err = reg_pull(cpu, &reg, sizeof(int)) && reg_pull(cpu, &operand->arg.ram_index, sizeof(int)) &&
+                                    (reg == ERR_REG || (REX <= reg && reg <= REG_NUMBER));
+                           break;
+        case OPERAND_REG : no_err = reg_pull(cpu, &reg, sizeof(int)) && reg > 0 && reg <= REG_NUMBER;
+                           break;
+        default          : no_err = false;
+                           break;
+    }
+    operand->reg = no_err ? (REGISTER) reg : ERR_REG;
+
+    if (!no_err) fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "invalid operand at byte %d\n", cpu->pc);
+    return no_err;
+}
+
+bool reg_pull(executer *const cpu, void *const pull_in, const size_t pull_size)
+{
+    assert(cpu     != nullptr);
+    assert(pull_in != nullptr);
+
+    if ((size_t) cpu->pc + pull_size > (size_t) cpu->capacity)
+    {
+        fprintf(stderr, TERMINAL_RED "DECODE ERROR: " TERMINAL_CANCEL "no parameter at the end of file\n");
+        return false;
+    }
+    executer_pull_cmd(cpu, pull_in, pull_size);
+    return true;
+}
+
+/**
+*   @brief Определяет количество аргументов команды регистрового кода.
+*
+*   @param has_dst [out] - есть ли у команды результат
+*
+*   @return количество аргументов и -1, если команда не определена
+*/
+
+int get_reg_operand_num(const unsigned char cmd, bool *const has_dst)
+{
+    assert(has_dst != nullptr);
+
+    *has_dst = false;
+
+    switch (cmd)
+    {
+        case R_HLT :
+        case R_JMP :
+        case R_CALL:
+        case R_RET : return 0;
+
+        case R_IN  : *has_dst = true;
+                     return 0;
+
+        case R_OUT : return 1;
+
+        case R_JA  :
+        case R_JAE :
+        case R_JB  :
+        case R_JBE :
+        case R_JE  :
+        case R_JNE : return 2;
+
+        case R_MOV :
+        case R_SQRT:
+        case R_SIN :
+        case R_COS :
+        case R_LOG : *has_dst = true;
+                     return 1;
+
+        case R_ADD :
+        case R_SUB :
+        case R_MUL :
+        case R_DIV :
+        case R_POW : *has_dst = true;
+                     return 2;
+
+        default    : return -1;
+    }
+    return -1;
+}
+
+/*===========================================================================================================================*/
+// REG_PROGRAM_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool reg_program_ctor(reg_program *const prog, const int capacity)
+{
+    assert(prog     != nullptr);
+    assert(capacity >=       0);
+
+    prog->cmd      = (reg_instruction *) log_calloc((size_t) capacity + 1, sizeof(reg_instruction)); // +1 for R_HLT sentinel
+    prog->size     = 0;
+    prog->capacity = capacity;
+    prog->frame    = 1;
+
+    if (prog->cmd == nullptr)
+    {
+        log_error("can't allocate memory for register code(%d)\n", __LINE__);
+        return false;
+    }
+    return true;
+}
+
+void reg_program_dtor(reg_program *const prog)
+{
+    assert(prog != nullptr);
+
+    log_free(prog->cmd);
+
+    prog->cmd      = nullptr;
+    prog->size     = 0;
+    prog->capacity = 0;
+}
+
+bool reg_lowering_ctor(reg_lowering *const low, reg_program *const out, const program *const prog)
+{
+    assert(low  != nullptr);
+    assert(out  != nullptr);
+    assert(prog != nullptr);
+
+    const size_t size = (size_t) prog->size + 1;
+
+    low->prog      = prog;
+    low->out       = out;
+    low->depth     = (int         *) log_calloc(size, sizeof(int));
+    low->is_func   = (bool        *) log_calloc(size, sizeof(bool));
+    low->is_target = (bool        *) log_calloc(size, sizeof(bool));
+    low->label_map = (int         *) log_calloc(size, sizeof(int));
+    low->vstack    = (reg_operand *) log_calloc(size, sizeof(reg_operand));
+    low->vslot     = (int         *) log_calloc(size, sizeof(int));
+    low->vsize     = 0;
+
+    if (low->depth   == nullptr || low->is_func == nullptr || low->is_target == nullptr || low->label_map == nullptr ||
+        low->vstack  == nullptr || low->vslot   == nullptr || !reg_program_ctor(out, prog->size))
+    {
+        log_error(        "can't allocate memory for lowering(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for lowering\n");
+        reg_lowering_dtor(low);
+        return false;
+    }
+    return true;
+}
+
+void reg_lowering_dtor(reg_lowering *const low)
+{
+    assert(low != nullptr);
+
+    log_free(low->depth);
+    log_free(low->is_func);
+    log_free(low->is_target);
+    log_free(low->label_map);
+    log_free(low->vstack);
+    log_free(low->vslot);
+
+    *low = {};
+}
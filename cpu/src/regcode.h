@@ -0,0 +1,181 @@
+#ifndef REGCODE
+#define REGCODE
+
+#include "decoder.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+const int REG_SIGNATURE = 0x00474552;   // "REG\0": первый байт 'R' не является командой стекового кода
+
+enum REG_ASM_CMD            // команды регистрового кода
+{
+    R_HLT           , //  0
+
+    R_IN            , //  1     dst
+    R_OUT           , //  2     src1
+
+    R_MOV           , //  3     dst = src1
+
+    R_JMP           , //  4     label
+    R_JA            , //  5     src1, src2, label
+    R_JAE           , //  6
+    R_JB            , //  7
+    R_JBE           , //  8
+    R_JE            , //  9
+    R_JNE           , // 10
+
+    R_CALL          , // 11     label
+    R_RET           , // 12
+
+    R_ADD           , // 13     dst = src1 op src2
+    R_SUB           , // 14
+    R_MUL           , // 15
+    R_DIV           , // 16
+    R_POW           , // 17
+    R_SQRT          , // 18     dst = op src1
+    R_SIN           , // 19
+    R_COS           , // 20
+    R_LOG           , // 21
+
+    R_UNDEF_ASM_CMD , // 22
+};
+
+static const char *const REG_ASM_CMD_NAMES[] =
+{
+    "HLT"           ,
+
+    "IN"            ,
+    "OUT"           ,
+
+    "MOV"           ,
+
+    "JMP"           ,
+    "JA"            ,
+    "JAE"           ,
+    "JB"            ,
+    "JBE"           ,
+    "JE"            ,
+    "JNE"           ,
+
+    "CALL"          ,
+    "RET"           ,
+
+    "ADD"           ,
+    "SUB"           ,
+    "MUL"           ,
+    "DIV"           ,
+    "POW"           ,
+    "SQRT"          ,
+    "SIN"           ,
+    "COS"           ,
+    "LOG"           ,
+
+    "UNDEF_ASM_CMD" ,
+};
+
+enum OPERAND_TYPE
+{
+    OPERAND_NONE    ,   // операнда нет
+    OPERAND_SLOT    ,   // регистр кадра: slot[arg.slot], индекс относительно начала кадра
+    OPERAND_NUM     ,   // действительное число arg.num
+    OPERAND_RAM     ,   // ram[reg + arg.ram_index], reg - целочисленный регистр или ERR_REG
+    OPERAND_REG     ,   // регистр машины reg
+};
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct reg_operand
+{
+    unsigned char type;         // OPERAND_TYPE
+    REGISTER      reg;          // регистр машины (для OPERAND_RAM и OPERAND_REG)
+    union
+    {
+        int    slot;            // OPERAND_SLOT
+        int    ram_index;       // OPERAND_RAM
+        double num;             // OPERAND_NUM
+    }
+    arg;
+};
+
+struct reg_instruction          // инструкция регистрового кода
+{
+    unsigned char cmd;          // REG_ASM_CMD
+    int           label;        // индекс инструкции, на которую указывает метка (для R_JMP, R_Jxx, R_CALL)
+    int           shift;        // сдвиг начала кадра при переходе (вызов функции или хвостовой переход в неё)
+
+    reg_operand   dst;          // результат
+    reg_operand   src1;         // первый аргумент
+    reg_operand   src2;         // второй аргумент
+};
+
+struct reg_program              // программа в регистровом коде
+{
+    reg_instruction *cmd;       // массив инструкций, заканчивающийся R_HLT
+    int              size;      // количество инструкций в .cmd (без завершающего R_HLT)
+    int              capacity;  // емкость .cmd
+    int              frame;     // наибольший размер кадра функции (в регистрах)
+};
+
+struct reg_lowering             // состояние перевода стекового кода в регистровый
+{
+    const program *prog;        // стековый код (прошедший program_verify())
+    reg_program   *out;         // регистровый код
+
+    int           *depth;       // depth    [i] - глубина стека перед инструкцией i (см. program_verify())
+    bool          *is_func;     // is_func  [i] - инструкция i является целью CALL
+    bool          *is_target;   // is_target[i] - на инструкцию i есть переход, перед ней все значения должны лежать в регистрах
+    int           *label_map;   // label_map[i] - индекс первой регистровой инструкции, соответствующей инструкции i
+
+    reg_operand   *vstack;      // верхние значения стека, еще не записанные в регистры кадра
+    int           *vslot;       // vslot[k] - регистр кадра, которому соответствует vstack[k]
+    int            vsize;       // размер .vstack
+};
+
+/*===========================================================================================================================*/
+// LOWER
+/*===========================================================================================================================*/
+
+bool reg_lower          (reg_program *const out, const program *const prog);
+bool reg_lower_cmd      (reg_lowering *const low, const int index);
+void reg_lower_push     (reg_lowering *const low, const instruction *const cur_cmd, const int d);
+void reg_lower_pop      (reg_lowering *const low, const instruction *const cur_cmd, const int d);
+void reg_lower_branch   (reg_lowering *const low, const unsigned char cmd, const int label, const int d);
+
+reg_operand reg_take    (reg_lowering *const low, const int slot);
+void        reg_put     (reg_lowering *const low, const int slot, const reg_operand operand);
+void        reg_flush   (reg_lowering *const low, const bool only_memory);
+reg_instruction *reg_emit(reg_lowering *const low, const unsigned char cmd);
+reg_instruction *reg_last(reg_lowering *const low);
+
+reg_operand reg_slot    (const int slot);
+reg_operand reg_num     (const double num);
+reg_operand reg_ram     (const REGISTER reg, const int ram_index);
+reg_operand reg_machine (const REGISTER reg);
+
+/*===========================================================================================================================*/
+// ENCODE_DECODE
+/*===========================================================================================================================*/
+
+bool is_reg_code        (const executer *const cpu);
+bool reg_encode         (const reg_program *const prog, executer *const cpu);
+void reg_encode_operand (executer *const cpu, const reg_operand *const operand);
+bool reg_decode         (reg_program *const prog, executer *const cpu);
+bool reg_decode_operand (executer *const cpu, reg_operand *const operand, const int frame);
+bool reg_pull           (executer *const cpu, void *const pull_in, const size_t pull_size);
+int  get_reg_operand_num(const unsigned char cmd, bool *const has_dst);
+
+/*===========================================================================================================================*/
+// REG_PROGRAM_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool reg_program_ctor   (reg_program *const prog, const int capacity);
+void reg_program_dtor   (reg_program *const prog);
+
+bool reg_lowering_ctor  (reg_lowering *const low, reg_program *const out, const program *const prog);
+void reg_lowering_dtor  (reg_lowering *const low);
+
+#endif //REGCODE
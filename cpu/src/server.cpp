@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../../lib/logs/log.h"
+
+#include "terminal_colors.h"
+#include "server.h"
+
+/*===========================================================================================================================*/
+// SERVER
+/*===========================================================================================================================*/
+
+/**
+*   @brief Исполняет загруженную программу для каждой записи ввода, не перезагружая и не перепроверяя ее.
+*
+*   @param socket_path - Unix-сокет, с которого читаются записи, или nullptr для stdin
+*
+*   @note Запись - строка ввода, IN читает числа только из нее. Вывод OUT каждой записи заканчивается строкой
+*         SERVER_OK или SERVER_FAILED, сообщения об ошибках идут в stderr. Перед каждым исполнением
+*         сбрасываются только стеки, регистры и RAM (см. machine_reset()).
+*   @note Как и execute(), освобождает машину.
+*
+*   @return true, если все записи прочитаны и false, если сервер не удалось запустить
+*/
+
+bool execute_server(machine *const computer, const bool jit, const bool threaded, const char *const socket_path)
+{
+    assert(computer != nullptr);
+
+    vm_server server = {};
+
+    bool no_err = server_ctor(&server, computer, jit, threaded);
+    if  (no_err) no_err = (socket_path == nullptr) ? server_serve (&server, stdin, computer->io.out) :
+                                                     server_listen(&server, socket_path);
+
+    log_message("server: %lld runs, %lld failed\n", server.runs, server.failed);
+
+    server_dtor (&server);
+    machine_dtor(computer);
+    return no_err;
+}
+
+/**
+*   @brief Исполняет программу для каждой строки in, вывод пишет в out.
+*/
+
+bool server_serve(vm_server *const server, FILE *const in, FILE *const out)
+{
+    assert(server != nullptr);
+    assert(in     != nullptr);
+    assert(out    != nullptr);
+
+    char   *record   = nullptr;
+    size_t  capacity = 0;
+    ssize_t len      = 0;
+
+    while (!server->stop && (len = getline(&record, &capacity, in)) >= 0)
+    {
+        if (len > 0 && record[len - 1] == '\n') record[--len] = '\0';
+
+        if (!strcmp(record, SERVER_STOP)) { server->stop = true; break; }
+
+        server_run(server, record, (size_t) len, out);
+    }
+
+    free(record);   // выделена getline()
+    return true;
+}
+
+/**
+*   @brief Исполняет программу один раз с вводом record.
+*
+*   @return true, если исполнение прошло без ошибок
+*/
+
+bool server_run(vm_server *const server, const char *const record, const size_t len, FILE *const out)
+{
+    assert(server != nullptr);
+    assert(record != nullptr);
+    assert(out    != nullptr);
+
+    machine *const computer = server->computer;
+    FILE    *const prev_out = computer->io.out;
+
+    machine_reset(computer);
+    computer->io.out = out;
+
+    bool no_err = io_set_input(&computer->io, record, len);
+    if  (no_err) no_err = execute_loaded(computer, server->code, server->threaded);
+    else         fprintf(stderr, TERMINAL_RED "SERVER ERROR: " TERMINAL_CANCEL "record is longer than %d bytes\n", IO_BUFFER_SIZE);
+
+    io_flush(&computer->io);
+    computer->io.out = prev_out;
+
+    fputs (no_err ? SERVER_OK : SERVER_FAILED, out);
+    fflush(out);
+
+    server->runs++;
+    if (!no_err) server->failed++;
+
+    return no_err;
+}
+
+/**
+*   @brief Принимает подключения к Unix-сокету socket_path по одному и обслуживает каждое, как server_serve().
+*
+*   @note Сервер работает, пока клиент не пришлет SERVER_STOP.
+*/
+
+bool server_listen(vm_server *const server, const char *const socket_path)
+{
+    assert(server      != nullptr);
+    assert(socket_path != nullptr);
+
+    sockaddr_un addr = {};
+    addr.sun_family  = AF_UNIX;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, TERMINAL_RED "SERVER ERROR: " TERMINAL_CANCEL "socket path \"%s\" is too long\n", socket_path);
+        return false;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+
+    if (listen_fd < 0 || bind(listen_fd, (const sockaddr *) &addr, sizeof(addr)) != 0 || listen(listen_fd, SERVER_BACKLOG) != 0)
+    {
+        fprintf(stderr, TERMINAL_RED "SERVER ERROR: " TERMINAL_CANCEL "can't listen on \"%s\": %s\n", socket_path, strerror(errno));
+        if (listen_fd >= 0) close(listen_fd);
+        return false;
+    }
+    signal(SIGPIPE, SIG_IGN);   // клиент может отключиться, не дочитав вывод
+
+    while (!server->stop)
+    {
+        const int conn_fd = accept(listen_fd, nullptr, nullptr);
+        if (conn_fd < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        const int out_fd = dup(conn_fd);
+        FILE     *in     = fdopen(conn_fd, "r");
+        FILE     *out    = (out_fd >= 0) ? fdopen(out_fd, "w") : nullptr;
+
+        if (in != nullptr && out != nullptr) server_serve(server, in, out);
+
+        if (in  != nullptr) fclose(in);  else close(conn_fd);
+        if (out != nullptr) fclose(out); else if (out_fd >= 0) close(out_fd);
+    }
+
+    close (listen_fd);
+    unlink(socket_path);
+    return server->stop;
+}
+
+/*===========================================================================================================================*/
+// SERVER_CTOR_DTOR
+/*===========================================================================================================================*/
+
+/**
+*   @brief Готовит сервер к исполнению программы, загруженной в computer.
+*
+*   @param jit - скомпилировать программу один раз для всех исполнений (как execute_jit())
+*/
+
+bool server_ctor(vm_server *const server, machine *const computer, const bool jit, const bool threaded)
+{
+    assert(server   != nullptr);
+    assert(computer != nullptr);
+
+    server->computer   = computer;
+    server->jit        = {};
+    server->code       = nullptr;
+    server->threaded   = threaded;
+    server->stop       = false;
+    server->runs       = 0;
+    server->failed     = 0;
+
+    if (!jit || computer->reg_code) return true;
+
+#ifdef __x86_64__
+    if (!computer->verified)
+    {
+        log_message("JIT: program is not verified, threaded code is used instead\n");
+        server->threaded = true;
+        return true;
+    }
+
+    if (jit_ctor(&server->jit, &computer->cpu, computer->ram.limit > computer->ram.size) && jit_load(&server->jit))
+    {
+        server->code = &server->jit;
+    }
+    else
+    {
+        jit_dtor(&server->jit);
+        log_message("JIT: can't compile program, threaded code is used instead\n");
+        server->threaded = true;
+    }
+#else
+    server->threaded = true;
+#endif
+    return true;
+}
+
+void server_dtor(vm_server *const server)
+{
+    assert(server != nullptr);
+
+    jit_dtor(&server->jit);
+
+    *server = {};
+}
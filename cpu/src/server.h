@@ -0,0 +1,49 @@
+#ifndef SERVER
+#define SERVER
+
+#include "jit.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+static const char *const SERVER_OK     = "#ok\n";       // конец вывода успешного исполнения
+static const char *const SERVER_FAILED = "#failed\n";   // конец вывода исполнения с ошибкой
+static const char *const SERVER_STOP   = "#stop";       // запись, после которой сервер завершается
+
+const int SERVER_BACKLOG = 16;                          // длина очереди подключений к сокету
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct vm_server                        // многократное исполнение одной загруженной программы
+{
+    machine        *computer;           // машина с загруженной и проверенной программой
+    jit_code        jit;                // программа, скомпилированная server_ctor()
+    const jit_code *code;               // исполняемая скомпилированная программа (&.jit или общая) или nullptr
+    bool            threaded;           // исполнять шитым кодом (если программа не скомпилирована)
+    bool            stop;               // получена запись SERVER_STOP
+
+    long long       runs;               // количество исполнений
+    long long       failed;             // количество исполнений с ошибкой
+};
+
+/*===========================================================================================================================*/
+// SERVER
+/*===========================================================================================================================*/
+
+bool execute_server (machine *const computer, const bool jit, const bool threaded, const char *const socket_path);
+
+bool server_serve   (vm_server *const server, FILE *const in, FILE *const out);
+bool server_run     (vm_server *const server, const char *const record, const size_t len, FILE *const out);
+bool server_listen  (vm_server *const server, const char *const socket_path);
+
+/*===========================================================================================================================*/
+// SERVER_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool server_ctor    (vm_server *const server, machine *const computer, const bool jit, const bool threaded);
+void server_dtor    (vm_server *const server);
+
+#endif //SERVER
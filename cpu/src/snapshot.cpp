@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../../lib/logs/log.h"
+
+#include "terminal_colors.h"
+#include "snapshot.h"
+
+/*===========================================================================================================================*/
+// SNAPSHOT
+/*===========================================================================================================================*/
+
+/**
+*   @brief Исполняет программу до инструкции snapshot_pc, сохраняет состояние машины в snapshot_file и продолжает исполнение.
+*
+*   @param snapshot_pc - индекс инструкции, перед которой делается снимок, или -1 - перед первым исполненным IN
+*                        (обычно к этому моменту программа закончила подготовку и ждет входных данных)
+*
+*   @note Точка снимка - временная замена команды на HLT, поэтому исполнение до нее идет без лишних проверок.
+*         Снимок не содержит состояния ввода-вывода. Как и execute(), освобождает машину.
+*/
+
+bool execute_snapshot(machine *const computer, const char *const snapshot_file, const int snapshot_pc,
+                                                                                const bool threaded)
+{
+    assert(computer      != nullptr);
+    assert(snapshot_file != nullptr);
+
+    if (computer->reg_code || snapshot_pc >= computer->cpu.size)
+    {
+        fprintf(stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "%s\n", computer->reg_code ? "register code is not supported" :
+                                                                                                    "snapshot point is out of program");
+        machine_dtor(computer);
+        return false;
+    }
+
+    instruction *const cmd     = computer->cpu.cmd;
+    const int          size    = computer->cpu.size;
+    bool        *const patched = (bool *) log_calloc((size_t) size + 1, sizeof(bool));   // patched[i] - команда i заменена на HLT
+    if (patched == nullptr)
+    {
+        log_error   ("can't allocate memory for snapshot point(%d)\n", __LINE__);
+        machine_dtor(computer);
+        return false;
+    }
+    const unsigned char stop_cmd = (snapshot_pc >= 0) ? cmd[snapshot_pc].cmd : (unsigned char) IN;
+
+    for (int i = 0; i < size; ++i)
+    {
+        patched[i] = (snapshot_pc >= 0) ? (i == snapshot_pc) : (cmd[i].cmd == IN);
+        if (patched[i]) cmd[i].cmd = HLT;
+    }
+
+    bool no_err = execute_loaded(computer, nullptr, threaded);
+
+    for (int i = 0; i < size; ++i)
+    {
+        if (patched[i]) cmd[i].cmd = stop_cmd;
+    }
+
+    if (no_err && computer->pc > 0 && patched[computer->pc - 1])
+    {
+        computer->pc -= 1;
+
+        no_err = snapshot_save(computer, snapshot_file);
+        if (no_err) no_err = execute_loaded(computer, nullptr, threaded);
+    }
+    else if (no_err)
+    {
+        io_flush(&computer->io);
+        fprintf (stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "program halted before snapshot point\n");
+        no_err = false;
+    }
+
+    log_free    (patched);
+    machine_dtor(computer);
+    return no_err;
+}
+
+/**
+*   @brief Записывает состояние машины: pc, регистры, стеки и RAM до последней ненулевой ячейки.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool snapshot_save(const machine *const computer, const char *const snapshot_file)
+{
+    assert(computer      != nullptr);
+    assert(snapshot_file != nullptr);
+
+    int ram_used = computer->ram.size;
+    while (ram_used > 0 && !(computer->ram.data[ram_used - 1] < 0) && !(computer->ram.data[ram_used - 1] > 0)) ram_used--;
+
+    snapshot_header header = {};
+
+    memcpy(header.signature, SNAPSHOT_SIGNATURE, sizeof(SNAPSHOT_SIGNATURE));
+    header.version      = SNAPSHOT_VERSION;
+    header.pc           = computer->pc;
+    header.program_hash = snapshot_hash(&computer->cpu);
+    header.program_size = computer->cpu.size;
+    header.reg_number   = REG_NUMBER + 1;
+    header.data_size    = computer->data_stack.size;
+    header.call_size    = computer->call_stack.size;
+    header.ram_size     = computer->ram.size;
+    header.ram_used     = ram_used;
+
+    FILE *stream = fopen(snapshot_file, "wb");
+    if  (stream == nullptr)
+    {
+        fprintf(stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "can't open \"%s\"\n", snapshot_file);
+        return false;
+    }
+
+    bool no_err = fwrite(&header                   , sizeof(header)  , 1                          , stream) == 1 &&
+                  fwrite(computer->dbl_reg         , sizeof(double)  , (size_t) header.reg_number , stream) == (size_t) header.reg_number &&
+                  fwrite(computer->data_stack.data , sizeof(cpu_type), (size_t) header.data_size  , stream) == (size_t) header.data_size  &&
+                  fwrite(computer->ram.data        , sizeof(cpu_type), (size_t) header.ram_used   , stream) == (size_t) header.ram_used   &&
+                  fwrite(computer->int_reg         , sizeof(int)     , (size_t) header.reg_number , stream) == (size_t) header.reg_number &&
+                  fwrite(computer->call_stack.data , sizeof(int)     , (size_t) header.call_size  , stream) == (size_t) header.call_size;
+
+    if (fclose(stream) != 0) no_err = false;
+
+    if (!no_err) fprintf(stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "can't write \"%s\"\n", snapshot_file);
+    return no_err;
+}
+
+/**
+*   @brief Восстанавливает состояние машины из снимка, сделанного snapshot_save() для той же программы.
+*
+*   @note Файл отображается в память одним mmap(), части состояния копируются из отображения на свои места.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool snapshot_load(machine *const computer, const char *const snapshot_file)
+{
+    assert(computer      != nullptr);
+    assert(snapshot_file != nullptr);
+
+    const int fd   = open(snapshot_file, O_RDONLY);
+    struct stat st = {};
+
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(snapshot_header))
+    {
+        fprintf(stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "can't read \"%s\"\n", snapshot_file);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    const size_t file_size = (size_t) st.st_size;
+    void *const  file      = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (file == MAP_FAILED)
+    {
+        fprintf(stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "can't map \"%s\"\n", snapshot_file);
+        return false;
+    }
+
+    snapshot_header header = {};
+    memcpy(&header, file, sizeof(header));
+
+    const char *err = nullptr;
+
+    if      (memcmp(header.signature, SNAPSHOT_SIGNATURE, sizeof(SNAPSHOT_SIGNATURE)) != 0) err = "file is not a snapshot";
+    else if (header.version      != SNAPSHOT_VERSION)                                       err = "unsupported snapshot version";
+    else if (computer->reg_code)                                                            err = "register code is not supported";
+    else if (header.program_size != computer->cpu.size ||
+             header.program_hash != snapshot_hash(&computer->cpu))                          err = "snapshot is made for another program";
+    else if (header.reg_number   != REG_NUMBER + 1 || header.pc < 0 || header.pc > header.program_size ||
+             header.data_size < 0 || header.call_size < 0 || header.ram_used < 0 || header.ram_used > header.ram_size ||
+             file_size != sizeof(header) + (size_t) header.reg_number * (sizeof(double) + sizeof(int))
+                                         + (size_t) header.data_size  *  sizeof(cpu_type)
+                                         + (size_t) header.ram_used   *  sizeof(cpu_type)
+                                         + (size_t) header.call_size  *  sizeof(int))       err = "snapshot is damaged";
+    else if (header.data_size    > computer->data_stack.capacity)                           err = "data stack is too small for snapshot, use --data-stack";
+    else if (header.call_size    > computer->call_stack.capacity)                           err = "call stack is too small for snapshot, use --call-stack";
+    else if (header.ram_size     > computer->ram.size && !ram_grow(&computer->ram, header.ram_size - 1))
+                                                                                            err = "RAM is too small for snapshot, use --ram or --ram-max";
+    if (err != nullptr)
+    {
+        fprintf(stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "\"%s\": %s\n", snapshot_file, err);
+        munmap (file, file_size);
+        return false;
+    }
+
+    const char *cur = (const char *) file + sizeof(header);
+
+    memcpy(computer->dbl_reg        , cur, (size_t) header.reg_number * sizeof(double));   cur += (size_t) header.reg_number * sizeof(double);
+    memcpy(computer->data_stack.data, cur, (size_t) header.data_size  * sizeof(cpu_type)); cur += (size_t) header.data_size  * sizeof(cpu_type);
+    memcpy(computer->ram.data       , cur, (size_t) header.ram_used   * sizeof(cpu_type)); cur += (size_t) header.ram_used   * sizeof(cpu_type);
+    memcpy(computer->int_reg        , cur, (size_t) header.reg_number * sizeof(int));      cur += (size_t) header.reg_number * sizeof(int);
+    memcpy(computer->call_stack.data, cur, (size_t) header.call_size  * sizeof(int));
+    munmap(file, file_size);
+
+    if (!snapshot_check_frames(computer, &header))
+    {
+        fprintf(stderr, TERMINAL_RED "SNAPSHOT ERROR: " TERMINAL_CANCEL "\"%s\": snapshot is damaged\n", snapshot_file);
+        return false;
+    }
+
+    computer->data_stack.size = header.data_size;
+    computer->call_stack.size = header.call_size;
+    computer->pc              = header.pc;
+
+    return true;
+}
+
+/**
+*   @brief Проверяет восстановленный стек вызовов и глубину стека данных перед header->pc (см. verify_frames()).
+*
+*   @note Если для проверенной программы состояние проследить не удалось, дальше она исполняется с проверками
+*         (computer->verified = false), иначе испорченный снимок вывел бы шитый код за пределы стеков.
+*/
+
+bool snapshot_check_frames(machine *const computer, const snapshot_header *const header)
+{
+    assert(computer != nullptr);
+    assert(header   != nullptr);
+
+    const int *call = computer->call_stack.data;
+
+    for (int i = 0; i < header->call_size; ++i)
+    {
+        if (call[i] < 0 || call[i] > header->program_size) return false;
+    }
+    if (!computer->verified) return true;
+
+    bool traced = false;
+    if (!verify_frames(&computer->cpu, header->pc, call, header->call_size, header->data_size, &traced)) return false;
+
+    if (!traced)
+    {
+        log_message("snapshot: call chain is not traced because of tail calls, program is executed with checks\n");
+        computer->verified = false;
+    }
+    return true;
+}
+
+/**
+*   @brief Хеш FNV-1a декодированной программы: снимок можно восстановить только для той же программы.
+*/
+
+unsigned long long snapshot_hash(const program *const prog)
+{
+    assert(prog != nullptr);
+
+    const unsigned long long FNV_OFFSET = 14695981039346656037ull;
+    const unsigned long long FNV_PRIME  = 1099511628211ull;
+
+    unsigned long long hash = FNV_OFFSET;
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        const instruction *cur_cmd = prog->cmd + i;
+
+        unsigned char bytes[3 + sizeof(cur_cmd->offset) + sizeof(cur_cmd->arg)] = {cur_cmd->cmd, cur_cmd->param,
+                                                                                  (unsigned char) cur_cmd->reg};
+        memcpy(bytes + 3                          , &cur_cmd->offset, sizeof(cur_cmd->offset));
+        memcpy(bytes + 3 + sizeof(cur_cmd->offset), &cur_cmd->arg   , sizeof(cur_cmd->arg));
+
+        for (size_t j = 0; j < sizeof(bytes); ++j) hash = (hash ^ bytes[j]) * FNV_PRIME;
+    }
+    return hash;
+}
@@ -0,0 +1,42 @@
+#ifndef SNAPSHOT
+#define SNAPSHOT
+
+#include "machine.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+static const char SNAPSHOT_SIGNATURE[8] = "CPUSNAP";
+const int         SNAPSHOT_VERSION      = 1;
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct snapshot_header                  // файл снимка: [заголовок][dbl_reg][стек данных][RAM][int_reg][стек вызовов]
+{
+    char               signature[8];    // SNAPSHOT_SIGNATURE
+    int                version;         // SNAPSHOT_VERSION
+    int                pc;              // индекс следующей инструкции
+    unsigned long long program_hash;    // snapshot_hash() программы, для которой сделан снимок
+    int                program_size;    // количество инструкций программы
+    int                reg_number;      // количество элементов int_reg и dbl_reg
+    int                data_size;       // элементов в стеке данных
+    int                call_size;       // элементов в стеке вызовов
+    int                ram_size;        // размер RAM в момент снимка
+    int                ram_used;        // записано ячеек RAM: после них RAM нулевая
+};
+
+/*===========================================================================================================================*/
+// SNAPSHOT
+/*===========================================================================================================================*/
+
+bool execute_snapshot           (machine *const computer, const char *const snapshot_file, const int snapshot_pc,
+                                                                                           const bool threaded);
+bool snapshot_save              (const machine *const computer, const char *const snapshot_file);
+bool snapshot_load              (machine *const computer, const char *const snapshot_file);
+bool snapshot_check_frames      (machine *const computer, const snapshot_header *const header);
+unsigned long long snapshot_hash(const program *const prog);
+
+#endif //SNAPSHOT
@@ -0,0 +1,514 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "../../lib/logs/log.h"
+
+#include "verifier.h"
+#include "terminal_colors.h"
+
+#define verify_error(cmd_index, fmt, ...)                                                                                   \
+    fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): " fmt "\n",                          \
+                    cmd_index, ASM_CMD_NAMES[checker->prog->cmd[cmd_index].cmd], ##__VA_ARGS__)
+
+/*===========================================================================================================================*/
+// VERIFY
+/*===========================================================================================================================*/
+
+/**
+*   @brief Проверяет декодированную программу до исполнения.
+*
+*   @param prog  [in]  - декодированная программа
+*   @param depth [out] - (если не nullptr) глубина стека данных перед каждой из prog->size инструкций
+*                        относительно начала функции, которой она принадлежит (UNKNOWN_DEPTH для недостижимых)
+*
+*   @return true, если программа может исполняться без проверок check_reg_arg, check_empty и проверок меток
+*
+*   @note Проверяется, что метки указывают на начала инструкций, что регистры-параметры корректны
+*         и что глубина стека данных ни в одной инструкции не становится отрицательной.
+*/
+
+bool program_verify(const program *const prog, int *const depth)
+{
+    assert(prog != nullptr);
+
+    if (!verify_operands(prog)) return false;
+
+    verifier checker = {};
+    if (!verifier_ctor(&checker, prog)) return false;
+
+    bool no_err = verify_stack_depth(&checker);
+    if  (no_err && depth != nullptr) memcpy(depth, checker.depth, (size_t) prog->size * sizeof(int));
+
+    verifier_dtor(&checker);
+    return no_err;
+}
+
+/**
+*   @brief Проверяет, что стек вызовов call и глубина стека данных data_size могут быть состоянием программы перед инструкцией pc.
+*
+*   @param traced [out] - true, если цепочку кадров удалось проследить и глубина стека проверена
+*
+*   @return false, если адрес возврата лежит вне программы или состояние точно недостижимо
+*
+*   @note Адрес возврата должен следовать за CALL из функции предыдущего кадра, глубина стека - сумма глубин
+*         перед этими CALL и глубины перед pc. После хвостового перехода кадр не определяет функцию,
+*         поэтому в программе с хвостовыми переходами проверяются только адреса возврата (traced == false).
+*/
+
+bool verify_frames(const program *const prog, const int pc, const int *const call, const int call_size,
+                                                                                   const int data_size,
+                                                                                   bool *const traced)
+{
+    assert(prog   != nullptr);
+    assert(call   != nullptr || call_size == 0);
+    assert(traced != nullptr);
+
+    *traced = false;
+
+    if (pc < 0 || pc > prog->size) return false;
+    for (int i = 0; i < call_size; ++i)
+    {
+        if (call[i] < 0 || call[i] > prog->size) return false;
+    }
+
+    verifier checker = {};
+    if (!verifier_ctor(&checker, prog)) return false;
+
+    bool no_err = verify_stack_depth(&checker);
+    if  (no_err && !checker.tail_call)
+    {
+        int beg  = -1;  // функция текущего кадра (-1 - основная программа)
+        int base = 0;   // глубина стека данных при входе в функцию beg
+
+        for (int i = 0; i < call_size && no_err; ++i)
+        {
+            const int from = call[i] - 1;
+
+            if (from < 0 || prog->cmd[from].cmd != CALL || checker.context[from] != beg) no_err = false;
+            else
+            {
+                base += checker.depth[from];
+                beg   = prog->cmd[from].arg.label;
+            }
+        }
+        if (no_err && pc < prog->size) no_err = checker.context[pc] == beg && base + checker.depth[pc] == data_size;
+
+        *traced = no_err;
+    }
+
+    verifier_dtor(&checker);
+    return no_err;
+}
+
+bool verify_operands(const program *const prog)
+{
+    assert(prog != nullptr);
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        const instruction *cur_cmd = prog->cmd + i;
+
+        switch (cur_cmd->cmd)
+        {
+            case JMP :
+            case JA  :
+            case JAE :
+            case JB  :
+            case JBE :
+            case JE  :
+            case JNE :
+            case JZ  :
+            case CALL: if (cur_cmd->arg.label < 0 || cur_cmd->arg.label >= prog->size)
+                       {
+                           fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): label pointed out of program\n",
+                                           i, ASM_CMD_NAMES[cur_cmd->cmd]);
+                           return false;
+                       }
+                       break;
+            case PUSH:
+            case POP : if (cur_cmd->param & (1 << PARAM_REG))
+                       {
+                           if (cur_cmd->reg <= 0 || cur_cmd->reg > REG_NUMBER)
+                           {
+                               fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): invalid register\n",
+                                               i, ASM_CMD_NAMES[cur_cmd->cmd]);
+                               return false;
+                           }
+                           if ((cur_cmd->param & (1 << PARAM_MEM)) && !is_int_reg(cur_cmd->reg))
+                           {
+                               fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): expected int register, but it is double\n",
+                                               i, ASM_CMD_NAMES[cur_cmd->cmd]);
+                               return false;
+                           }
+                       }
+                       if (cur_cmd->cmd == POP && !(cur_cmd->param & (1 << PARAM_MEM)) && (cur_cmd->param & (1 << PARAM_NUM)))
+                       {
+                           fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): rvalue as a pop-argument\n",
+                                           i, ASM_CMD_NAMES[cur_cmd->cmd]);
+                           return false;
+                       }
+                       break;
+            case ADD_REG:
+            case ADD_MEM:
+            case MEM_OP :
+            case ADDI   :
+            case SUBI   : if (cur_cmd->reg <= 0 || cur_cmd->reg > REG_NUMBER)
+                          {
+                              fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): invalid register\n",
+                                              i, ASM_CMD_NAMES[cur_cmd->cmd]);
+                              return false;
+                          }
+                          if (cur_cmd->cmd != ADD_REG && !is_int_reg(cur_cmd->reg))
+                          {
+                              fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): expected int register, but it is double\n",
+                                              i, ASM_CMD_NAMES[cur_cmd->cmd]);
+                              return false;
+                          }
+                          if (cur_cmd->cmd == MEM_OP && cur_cmd->param != ADD && cur_cmd->param != SUB &&
+                                                        cur_cmd->param != MUL && cur_cmd->param != DIV)
+                          {
+                              fprintf(stderr, TERMINAL_RED "VERIFY ERROR: " TERMINAL_CANCEL "instruction %d (%s): undefined operation\n",
+                                              i, ASM_CMD_NAMES[cur_cmd->cmd]);
+                              return false;
+                          }
+                          break;
+            default  : break;
+        }
+    }
+    return true;
+}
+
+/**
+*   @brief Абстрактной интерпретацией вычисляет глубину стека данных перед каждой достижимой инструкцией.
+*
+*   @note Каждая функция (цель CALL) анализируется отдельно, глубина считается относительно входа в неё.
+*         Влияние функции на стек (func_summary) уточняется итеративно, пока не перестанет меняться:
+*         путь, проходящий через CALL функции с неизвестным влиянием, на текущей итерации обрывается.
+*   @note Переход или проваливание в начало другой функции рассматривается как хвостовой вызов.
+*/
+
+bool verify_stack_depth(verifier *const checker)
+{
+    assert(checker != nullptr);
+
+    const program *prog = checker->prog;
+
+    for (int i = 0; i < prog->size; ++i)
+    {
+        if (prog->cmd[i].cmd == CALL) checker->is_func[prog->cmd[i].arg.label] = true;
+    }
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+
+        for (int i = 0; i <= prog->size; ++i)
+        {
+            checker->depth  [i] = UNKNOWN_DEPTH;
+            checker->context[i] = UNKNOWN_DEPTH;
+        }
+
+        if (!verify_context(checker, -1, &changed)) return false;
+
+        for (int i = 0; i < prog->size; ++i)
+        {
+            if (checker->is_func[i] && !verify_context(checker, i, &changed)) return false;
+        }
+    }
+    return true;
+}
+
+/**
+*   @brief Анализирует код, достижимый из начала функции beg (beg = -1 - из начала программы).
+*
+*   @param changed [out] - становится true, если влияние функции beg на стек изменилось
+*/
+
+bool verify_context(verifier *const checker, const int beg, bool *const changed)
+{
+    assert(checker != nullptr);
+    assert(changed != nullptr);
+
+    const program *prog = checker->prog;
+    const int     start = (beg == -1) ? 0 : beg;
+
+    int low       = 0;              // минимальная относительная глубина стека
+    int ret_depth = UNKNOWN_DEPTH;  // относительная глубина стека на RET
+
+    if (checker->context[start] != UNKNOWN_DEPTH)
+    {
+        verify_error(start, "function entry is reachable from outside of function");
+        return false;
+    }
+
+    checker->worklist_size   = 0;
+    checker->depth  [start]  = 0;
+    checker->context[start]  = beg;
+    checker->worklist[checker->worklist_size++] = start;
+
+    while (checker->worklist_size > 0)
+    {
+        const int          cur     = checker->worklist[--checker->worklist_size];
+        const int          d       = checker->depth[cur];
+        const instruction *cur_cmd = prog->cmd + cur;
+
+        int next_depth = UNKNOWN_DEPTH;
+
+        switch (cur_cmd->cmd)
+        {
+            case HLT : break;
+
+            case IN     :
+            case PUSH   :
+            case ADD_MEM:
+            case MEM_OP : next_depth = d + 1;
+                          break;
+
+            case ADD_REG:
+            case ADDI   :
+            case SUBI   : next_depth = d;
+                          break;
+
+            case SQRT:
+            case SIN :
+            case COS :
+            case LOG :
+            case OUT : if (!verify_need(checker, beg, cur, d, 1, &low)) return false;
+                       next_depth = d;
+                       break;
+
+            case POP : if (!verify_need(checker, beg, cur, d, 1, &low)) return false;
+                       next_depth = d - 1;
+                       break;
+
+            case ADD :
+            case SUB :
+            case MUL :
+            case DIV :
+            case POW : if (!verify_need(checker, beg, cur, d, 2, &low)) return false;
+                       next_depth = d - 1;
+                       break;
+
+            case JMP : if (!verify_transfer(checker, beg, cur, cur_cmd->arg.label, d, &low, &ret_depth)) return false;
+                       break;
+
+            case JA  :
+            case JAE :
+            case JB  :
+            case JBE :
+            case JE  :
+            case JNE : if (!verify_need    (checker, beg, cur, d, 2, &low))                                 return false;
+                       if (!verify_transfer(checker, beg, cur, cur_cmd->arg.label, d - 2, &low, &ret_depth)) return false;
+                       next_depth = d - 2;
+                       break;
+
+            case JZ  : if (!verify_need    (checker, beg, cur, d, 1, &low))                                 return false;
+                       if (!verify_transfer(checker, beg, cur, cur_cmd->arg.label, d - 1, &low, &ret_depth)) return false;
+                       next_depth = d - 1;
+                       break;
+
+            case CALL: if (!verify_call(checker, beg, cur, cur_cmd->arg.label, d, &low, &next_depth)) return false;
+                       break;
+
+            case RET : if (beg == -1)
+                       {
+                           verify_error(cur, "RET outside of function");
+                           return false;
+                       }
+                       if (ret_depth != UNKNOWN_DEPTH && ret_depth != d)
+                       {
+                           verify_error(cur, "function returns with different data stack depth (%d and %d)", ret_depth, d);
+                           return false;
+                       }
+                       ret_depth = d;
+                       break;
+
+            default  : verify_error(cur, "undefined command");
+                       return false;
+        }
+        if (next_depth != UNKNOWN_DEPTH && !verify_transfer(checker, beg, cur, cur + 1, next_depth, &low, &ret_depth)) return false;
+    }
+
+    if (beg == -1 || ret_depth == UNKNOWN_DEPTH) return true;
+
+    func_summary *summary = checker->summary + beg;
+
+    if (low < -2 * prog->size - 2)
+    {
+        verify_error(beg, "data stack underflow in recursive function");
+        return false;
+    }
+    if (summary->known && summary->net != ret_depth)
+    {
+        verify_error(beg, "function returns with different data stack depth (%d and %d)", summary->net, ret_depth);
+        return false;
+    }
+    if (!summary->known || summary->low != low)
+    {
+        summary->known = true;
+        summary->net   = ret_depth;
+        summary->low   = low;
+       *changed        = true;
+    }
+    return true;
+}
+
+/**
+*   @brief Помечает инструкцию to как достижимую с глубиной стека cur_depth.
+*/
+
+bool verify_visit(verifier *const checker, const int beg, const int from, const int to, const int cur_depth)
+{
+    assert(checker != nullptr);
+
+    if (checker->context[to] == UNKNOWN_DEPTH)
+    {
+        checker->context[to] = beg;
+        checker->depth  [to] = cur_depth;
+        checker->worklist[checker->worklist_size++] = to;
+        return true;
+    }
+    if (checker->context[to] != beg)
+    {
+        verify_error(from, "instruction %d is reachable from two different functions", to);
+        return false;
+    }
+    if (checker->depth[to] != cur_depth)
+    {
+        verify_error(from, "inconsistent data stack depth at instruction %d (%d and %d)", to, checker->depth[to], cur_depth);
+        return false;
+    }
+    return true;
+}
+
+/**
+*   @brief Передает управление из инструкции from в инструкцию to.
+*
+*   @note Если to - начало функции, это хвостовой вызов: путь заканчивается так же, как после CALL и RET.
+*/
+
+bool verify_transfer(verifier *const checker, const int beg, const int from, const int to, const int cur_depth,
+                                                                                             int *const low,
+                                                                                             int *const ret_depth)
+{
+    assert(checker   != nullptr);
+    assert(low       != nullptr);
+    assert(ret_depth != nullptr);
+
+    if (!checker->is_func[to]) return verify_visit(checker, beg, from, to, cur_depth);
+    checker->tail_call = true;
+
+    if (beg == -1)
+    {
+        verify_error(from, "jump into function %d outside of CALL", to);
+        return false;
+    }
+
+    int after_call = UNKNOWN_DEPTH;
+    if (!verify_call(checker, beg, from, to, cur_depth, low, &after_call)) return false;
+    if (after_call == UNKNOWN_DEPTH) return true;
+
+    if (*ret_depth != UNKNOWN_DEPTH && *ret_depth != after_call)
+    {
+        verify_error(from, "function returns with different data stack depth (%d and %d)", *ret_depth, after_call);
+        return false;
+    }
+    *ret_depth = after_call;
+    return true;
+}
+
+/**
+*   @brief Применяет влияние функции to на стек при вызове из инструкции from.
+*
+*   @param next_depth [out] - глубина стека после возврата (UNKNOWN_DEPTH, если влияние функции еще неизвестно)
+*/
+
+bool verify_call(verifier *const checker, const int beg, const int from, const int to, const int cur_depth,
+                                                                                         int *const low,
+                                                                                         int *const next_depth)
+{
+    assert(checker    != nullptr);
+    assert(low        != nullptr);
+    assert(next_depth != nullptr);
+
+    const func_summary *summary = checker->summary + to;
+
+    *next_depth = UNKNOWN_DEPTH;
+    if (!summary->known) return true;
+
+    if (beg == -1 && cur_depth + summary->low < 0)
+    {
+        verify_error(from, "data stack underflow: function %d needs %d values, but there are only %d", to, -summary->low, cur_depth);
+        return false;
+    }
+    if (cur_depth + summary->low < *low) *low = cur_depth + summary->low;
+
+    *next_depth = cur_depth + summary->net;
+    return true;
+}
+
+/**
+*   @brief Проверяет, что инструкция from снимает со стека не больше значений, чем на нем лежит.
+*/
+
+bool verify_need(verifier *const checker, const int beg, const int from, const int cur_depth,
+                                                                           const int need,
+                                                                           int *const low)
+{
+    assert(checker != nullptr);
+    assert(low     != nullptr);
+
+    if (beg == -1 && cur_depth < need)
+    {
+        verify_error(from, "data stack underflow: needs %d values, but there are only %d", need, cur_depth);
+        return false;
+    }
+    if (cur_depth - need < *low) *low = cur_depth - need;
+    return true;
+}
+
+/*===========================================================================================================================*/
+// VERIFIER_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool verifier_ctor(verifier *const checker, const program *const prog)
+{
+    assert(checker != nullptr);
+    assert(prog    != nullptr);
+
+    const size_t size = (size_t) prog->size + 1; // включая завершающий HLT
+
+    checker->prog          = prog;
+    checker->depth         = (int          *) log_calloc(size, sizeof(int));
+    checker->context       = (int          *) log_calloc(size, sizeof(int));
+    checker->is_func       = (bool         *) log_calloc(size, sizeof(bool));
+    checker->summary       = (func_summary *) log_calloc(size, sizeof(func_summary));
+    checker->worklist      = (int          *) log_calloc(size, sizeof(int));
+    checker->worklist_size = 0;
+
+    if (checker->depth   == nullptr || checker->context  == nullptr || checker->is_func == nullptr ||
+        checker->summary == nullptr || checker->worklist == nullptr)
+    {
+        log_error(        "can't allocate memory for verifier(%d)\n", __LINE__);
+        fprintf  (stderr, "can't allocate memory for verifier\n");
+        verifier_dtor(checker);
+        return false;
+    }
+    return true;
+}
+
+void verifier_dtor(verifier *const checker)
+{
+    assert(checker != nullptr);
+
+    log_free(checker->depth);
+    log_free(checker->context);
+    log_free(checker->is_func);
+    log_free(checker->summary);
+    log_free(checker->worklist);
+
+    *checker = {};
+}
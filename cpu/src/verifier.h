@@ -0,0 +1,66 @@
+#ifndef VERIFIER
+#define VERIFIER
+
+#include "decoder.h"
+
+/*===========================================================================================================================*/
+// CONST
+/*===========================================================================================================================*/
+
+const int UNKNOWN_DEPTH = -1000000000;  // глубина стека в недостигнутой инструкции
+
+/*===========================================================================================================================*/
+// STRUCT
+/*===========================================================================================================================*/
+
+struct func_summary     // влияние функции на стек данных
+{
+    bool known;         // найден хотя бы один путь от начала функции до RET
+    int  net;           // глубина стека на RET относительно глубины при входе
+    int  low;           // минимальная относительная глубина стека внутри функции
+};
+
+struct verifier
+{
+    const program *prog;        // проверяемая программа
+
+    int          *depth;        // depth  [i] - глубина стека перед инструкцией i относительно начала контекста
+    int          *context;      // context[i] - начало контекста (функции), из которого достигнута инструкция i
+    bool         *is_func;      // is_func[i] - инструкция i является целью CALL
+    func_summary *summary;      // summary[i] - влияние на стек функции, начинающейся с инструкции i
+    int          *worklist;     // стек инструкций, ожидающих обработки
+    int           worklist_size;
+    bool          tail_call;    // в программе есть переход или проваливание в начало функции
+};
+
+/*===========================================================================================================================*/
+// VERIFY
+/*===========================================================================================================================*/
+
+bool program_verify             (const program *const prog, int *const depth = nullptr);
+bool verify_frames              (const program *const prog, const int pc, const int *const call, const int call_size,
+                                                                                                 const int data_size,
+                                                                                                 bool *const traced);
+
+bool verify_operands            (const program *const prog);
+bool verify_stack_depth         (verifier *const checker);
+bool verify_context             (verifier *const checker, const int beg, bool *const changed);
+bool verify_visit               (verifier *const checker, const int beg, const int from, const int to, const int cur_depth);
+bool verify_transfer            (verifier *const checker, const int beg, const int from, const int to, const int cur_depth,
+                                                                                                       int *const low,
+                                                                                                       int *const ret_depth);
+bool verify_call                (verifier *const checker, const int beg, const int from, const int to, const int cur_depth,
+                                                                                                       int *const low,
+                                                                                                       int *const next_depth);
+bool verify_need                (verifier *const checker, const int beg, const int from, const int cur_depth,
+                                                                                         const int need,
+                                                                                         int *const low);
+
+/*===========================================================================================================================*/
+// VERIFIER_CTOR_DTOR
+/*===========================================================================================================================*/
+
+bool verifier_ctor (verifier *const checker, const program *const prog);
+void verifier_dtor (verifier *const checker);
+
+#endif //VERIFIER
@@ -0,0 +1,107 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <stddef.h>
+
+/*_________________________________________CONST_________________________________________*/
+
+static const unsigned PERFECT_HASH_MAX_SEED = 1u << 12;     // сколько seed перебирается при построении таблицы
+static const unsigned PERFECT_HASH_NO_SEED  = ~0u;          // таблица не построена: увеличьте TABLE_SIZE
+
+/*_________________________________________STRUCT_________________________________________*/
+
+/**
+*   @brief Совершенная хеш-таблица для фиксированного набора имен, строится во время компиляции (см. perfect_hash_build()).
+*
+*   @note Имена таблицы не хранятся: поиск сравнивает строку с именем из того же массива, по которому строилась таблица.
+*/
+
+template <size_t TABLE_SIZE>
+struct perfect_hash
+{
+    static_assert(TABLE_SIZE > 0 && (TABLE_SIZE & (TABLE_SIZE - 1)) == 0, "TABLE_SIZE should be a power of two");
+
+    unsigned seed;                  // seed хеш-функции, при котором у имен нет коллизий
+    int      slot[TABLE_SIZE];      // индекс имени в массиве или -1
+};
+
+/*_________________________________________FUNCTION_DEFINITIONS_________________________________________*/
+
+constexpr char perfect_hash_fold(const char c, const bool ignore_case)
+{
+    return (ignore_case && 'a' <= c && c <= 'z') ? (char) (c - 'a' + 'A') : c;
+}
+
+/**
+*   @brief FNV-1a с seed, старшие биты подмешиваются в младшие, потому что индекс - младшие биты хеша.
+*/
+
+constexpr unsigned perfect_hash_value(const unsigned seed, const char *const str, const int len, const bool ignore_case)
+{
+    unsigned hash = 2166136261u ^ (seed * 0x9E3779B9u);
+
+    for (int i = 0; i < len; ++i)
+    {
+        hash ^= (unsigned char) perfect_hash_fold(str[i], ignore_case);
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+/**
+*   @brief Подбирает seed, при котором имена names[0..name_num) без [skip_beg, skip_end) попадают в разные ячейки.
+*
+*   @return таблица, seed == PERFECT_HASH_NO_SEED, если подобрать не удалось (проверяется static_assert у таблицы)
+*/
+
+template <size_t TABLE_SIZE, size_t NAME_NUM>
+constexpr perfect_hash<TABLE_SIZE> perfect_hash_build(const char *const (&names)[NAME_NUM], const int name_num,
+                                                      const int skip_beg, const int skip_end, const bool ignore_case)
+{
+    for (unsigned seed = 0; seed < PERFECT_HASH_MAX_SEED; ++seed)
+    {
+        perfect_hash<TABLE_SIZE> table = {seed, {}};
+        bool                     no_collision = true;
+
+        for (size_t i = 0; i < TABLE_SIZE; ++i) table.slot[i] = -1;
+
+        for (int i = 0; i < name_num && no_collision; ++i)
+        {
+            if (skip_beg <= i && i < skip_end) continue;
+
+            int len = 0;
+            while (names[i][len] != '\0') ++len;
+
+            const int pos = (int) (perfect_hash_value(seed, names[i], len, ignore_case) & (TABLE_SIZE - 1));
+
+            if (table.slot[pos] == -1) table.slot[pos] = i;
+            else                       no_collision    = false;
+        }
+        if (no_collision) return table;
+    }
+    return {PERFECT_HASH_NO_SEED, {}};
+}
+
+/**
+*   @brief Ищет строку str длины len (не обязательно заканчивается '\0'): один хеш и одно сравнение.
+*
+*   @return индекс имени в names и -1, если строки там нет
+*/
+
+template <size_t TABLE_SIZE, size_t NAME_NUM>
+constexpr int perfect_hash_find(const perfect_hash<TABLE_SIZE> &table, const char *const (&names)[NAME_NUM],
+                                const char *const str, const int len, const bool ignore_case)
+{
+    const int index = table.slot[perfect_hash_value(table.seed, str, len, ignore_case) & (TABLE_SIZE - 1)];
+    if (index == -1) return -1;
+
+    const char *name = names[index];
+
+    for (int i = 0; i < len; ++i)
+    {
+        if (name[i] == '\0' || perfect_hash_fold(name[i], ignore_case) != perfect_hash_fold(str[i], ignore_case)) return -1;
+    }
+    return (name[len] == '\0') ? index : -1;
+}
+
+#endif //PERFECT_HASH_H
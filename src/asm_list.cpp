@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+#include "../lib/logs/log.h"
+
+#include "asm_list.h"
+
+//===========================================================================================================================
+// ASM_LIST
+//===========================================================================================================================
+
+/**
+*   @brief Разбирает текст функции, созданный транслятором, на строки.
+*
+*   @param text - текст, выделенный open_memstream(), список становится его владельцем
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*/
+
+bool asm_list_parse(asm_list *const code, char *const text)
+{
+    assert(code != nullptr);
+    assert(text != nullptr);
+
+    code->text = text;
+
+    for (char *line = text; *line != '\0';)
+    {
+        char *line_end = strchr(line, '\n');
+        if   (line_end != nullptr) *line_end = '\0';
+
+        if (!asm_list_parse_line(code, line)) return false;
+
+        if (line_end == nullptr) break;
+        line = line_end + 1;
+    }
+
+    asm_list_mark_arguments(code);
+    return true;
+}
+
+/**
+*   @brief Разбирает одну строку: "метка: #комментарий", "инструкция параметр #комментарий" или "#комментарий".
+*
+*   @note Строка изменяется: после мнемоники, параметра и имени метки записывается '\0'.
+*/
+
+bool asm_list_parse_line(asm_list *const code, char *line)
+{
+    assert(code != nullptr);
+    assert(line != nullptr);
+
+    asm_line cur = {};
+
+    while (isspace((unsigned char) *line)) ++line;
+
+    char *comment = strchr(line, '#');
+    if   (comment != nullptr)
+    {
+        *comment    = '\0';
+        cur.comment = comment + 1;
+    }
+
+    char *line_end = line + strlen(line);
+    while (line_end != line && isspace((unsigned char) line_end[-1])) *--line_end = '\0';
+
+    if (*line == '\0')
+    {
+        cur.type = (comment == nullptr) ? LINE_EMPTY : LINE_COMMENT;
+        return asm_list_push(code, &cur) != nullptr;
+    }
+
+    char *cmd_end = line;
+    while (*cmd_end != '\0' && !isspace((unsigned char) *cmd_end)) ++cmd_end;
+
+    cur.cmd = line;
+
+    if (cmd_end[-1] == ':')
+    {
+        cmd_end[-1] = '\0';
+        cur.type    = LINE_LABEL;
+        return asm_list_push(code, &cur) != nullptr;
+    }
+
+    cur.type = LINE_CMD;
+
+    if (*cmd_end != '\0')
+    {
+        *cmd_end++ = '\0';
+        while (isspace((unsigned char) *cmd_end)) ++cmd_end;
+
+        int slot     = 0;
+        int arg_len  = 0;
+
+        cur.arg      = cmd_end;
+        cur.arg_type = ARG_OTHER;
+
+        if (sscanf(cur.arg, "[rex+%d]%n", &slot, &arg_len) == 1 && cur.arg[arg_len] == '\0')
+        {
+            cur.arg_type = ARG_LOCAL;
+            cur.slot     = slot;
+        }
+    }
+    return asm_list_push(code, &cur) != nullptr;
+}
+
+/**
+*   @brief Отмечает "pop [rex+N]", кладущие параметры в кадр вызываемой функции.
+*
+*   @note translate_func_call() кладет параметры в ячейки [rex+N], N >= shift, непосредственно перед "addi rex, shift".
+*         Эти ячейки принадлежат кадру вызываемой функции, а не локальным переменным.
+*   @note translate_tail_call() кладет параметры в ячейки [rex+N], N >= 0, непосредственно перед "jmp def_N".
+*/
+
+void asm_list_mark_arguments(asm_list *const code)
+{
+    assert(code != nullptr);
+
+    for (int i = 0; i < code->size; ++i)
+    {
+        int shift = 0;
+        if (!asm_line_rex_shift(code->line + i, "addi", &shift) && !asm_line_is_tail_call(code->line + i)) continue;
+
+        for (int j = i - 1; j >= 0; --j)
+        {
+            asm_line *cur = code->line + j;
+
+            if (cur->type == LINE_EMPTY || cur->type == LINE_COMMENT) continue;
+            if (!asm_line_is(cur, "pop") || cur->arg_type != ARG_LOCAL || cur->slot < shift) break;
+
+            cur->argument = true;
+        }
+    }
+}
+
+void asm_list_write(const asm_list *const code, FILE *const stream)
+{
+    assert(code   != nullptr);
+    assert(stream != nullptr);
+
+    for (int i = 0; i < code->size; ++i)
+    {
+        const asm_line *cur = code->line + i;
+        const char     *arg = asm_line_arg(cur);
+
+        switch (cur->type)
+        {
+            case LINE_DELETED: continue;
+            case LINE_EMPTY  : break;
+            case LINE_COMMENT: break;
+            case LINE_LABEL  : fprintf(stream, "%s:", cur->cmd);
+                               break;
+            case LINE_CMD    : if (arg == nullptr) fprintf(stream, "%s", cur->cmd);
+                               else                fprintf(stream, "%s %s", cur->cmd, arg);
+                               break;
+            default          : assert(false && "default case in asm_list_write()");
+                               break;
+        }
+
+        if (cur->comment != nullptr) fprintf(stream, "%s#%s", (cur->type == LINE_COMMENT) ? "" : " ", cur->comment);
+        fprintf(stream, "\n");
+    }
+}
+//---------------------------------------------------------------------------------------------------------------------------
+
+/**
+*   @brief Добавляет копию строки line в конец списка.
+*
+*   @return указатель на добавленную строку и nullptr, если не удалось выделить память
+*/
+
+asm_line *asm_list_push(asm_list *const code, const asm_line *const line)
+{
+    assert(code != nullptr);
+    assert(line != nullptr);
+
+    if (code->size == code->capacity)
+    {
+        const int new_capacity = (code->capacity == 0) ? 64 : 2 * code->capacity;
+        asm_line *new_line     = (asm_line *) log_realloc(code->line, (size_t) new_capacity * sizeof(asm_line));
+
+        if (new_line == nullptr)
+        {
+            log_error("can't allocate memory for asm list(%d)\n", __LINE__);
+            return nullptr;
+        }
+        code->line     = new_line;
+        code->capacity = new_capacity;
+    }
+    code->line[code->size] = *line;
+    return code->line + code->size++;
+}
+
+/**
+*   @brief Добавляет инструкцию cmd с параметром arg (статической строкой или nullptr).
+*/
+
+asm_line *asm_list_push_cmd(asm_list *const code, const char *const cmd, const char *const arg)
+{
+    assert(code != nullptr);
+    assert(cmd  != nullptr);
+
+    asm_line cur = {};
+
+    cur.type     = LINE_CMD;
+    cur.cmd      = cmd;
+    cur.arg      = arg;
+    cur.arg_type = (arg == nullptr) ? ARG_NONE : ARG_OTHER;
+
+    return asm_list_push(code, &cur);
+}
+
+/**
+*   @brief Добавляет инструкцию "cmd [rex+slot]".
+*/
+
+asm_line *asm_list_push_local(asm_list *const code, const char *const cmd, const int slot)
+{
+    assert(code != nullptr);
+    assert(cmd  != nullptr);
+
+    asm_line cur = {};
+
+    cur.type     = LINE_CMD;
+    cur.cmd      = cmd;
+    cur.arg_type = ARG_LOCAL;
+    cur.slot     = slot;
+    snprintf(cur.buff, sizeof(cur.buff), "[rex+%d]", slot);
+
+    return asm_list_push(code, &cur);
+}
+//---------------------------------------------------------------------------------------------------------------------------
+
+/**
+*   @brief Собирает метки списка в массив, отсортированный по имени.
+*
+*   @return массив меток (освобождается log_free()) и nullptr, если не удалось выделить память
+*/
+
+asm_label *asm_list_labels(const asm_list *const code, int *const label_num)
+{
+    assert(code      != nullptr);
+    assert(label_num != nullptr);
+
+    asm_label *label = (asm_label *) log_calloc((size_t) code->size + 1, sizeof(asm_label));
+    if (label == nullptr)
+    {
+        log_error("can't allocate memory for asm labels(%d)\n", __LINE__);
+        return nullptr;
+    }
+
+    *label_num = 0;
+    for (int i = 0; i < code->size; ++i)
+    {
+        if (code->line[i].type == LINE_LABEL) label[(*label_num)++] = {code->line[i].cmd, i};
+    }
+    qsort(label, (size_t) *label_num, sizeof(asm_label), asm_label_cmp);
+
+    return label;
+}
+
+/**
+*   @return индекс строки метки name и -1, если такой метки нет
+*/
+
+int asm_list_find_label(const asm_label *const label, const int label_num, const char *const name)
+{
+    assert(label != nullptr);
+    assert(name  != nullptr);
+
+    const asm_label  key   = {name, 0};
+    const asm_label *found = (const asm_label *) bsearch(&key, label, (size_t) label_num, sizeof(asm_label), asm_label_cmp);
+
+    return (found == nullptr) ? -1 : found->index;
+}
+
+int asm_label_cmp(const void *const a, const void *const b)
+{
+    assert(a != nullptr);
+    assert(b != nullptr);
+
+    return strcmp(((const asm_label *) a)->name, ((const asm_label *) b)->name);
+}
+//---------------------------------------------------------------------------------------------------------------------------
+
+const char *asm_line_arg(const asm_line *const line)
+{
+    assert(line != nullptr);
+
+    if (line->arg     != nullptr) return line->arg;
+    if (line->buff[0] != '\0')    return line->buff;
+    return nullptr;
+}
+
+bool asm_line_is(const asm_line *const line, const char *const cmd)
+{
+    assert(line != nullptr);
+    assert(cmd  != nullptr);
+
+    return line->type == LINE_CMD && !strcmp(line->cmd, cmd);
+}
+
+bool asm_line_is_jump(const asm_line *const line)
+{
+    assert(line != nullptr);
+
+    return asm_line_is(line, "jmp") || asm_line_is_cond_jump(line);
+}
+
+bool asm_line_is_cond_jump(const asm_line *const line)
+{
+    assert(line != nullptr);
+
+    return asm_line_is(line, "ja") || asm_line_is(line, "jae") || asm_line_is(line, "jb") ||
+           asm_line_is(line, "jbe") || asm_line_is(line, "je") || asm_line_is(line, "jne");
+}
+
+/**
+*   @brief Проверяет, является ли строка хвостовым вызовом "jmp def_N" (см. translate_tail_call()).
+*/
+
+bool asm_line_is_tail_call(const asm_line *const line)
+{
+    assert(line != nullptr);
+
+    const char *arg = asm_line_arg(line);
+
+    return asm_line_is(line, "jmp") && arg != nullptr && !strncmp(arg, "def_", sizeof("def_") - 1);
+}
+
+/**
+*   @brief Проверяет, является ли строка инструкцией "cmd rex, shift" (addi или subi, см. add_rex() и sub_rex()).
+*/
+
+bool asm_line_rex_shift(const asm_line *const line, const char *const cmd, int *const shift)
+{
+    assert(line  != nullptr);
+    assert(cmd   != nullptr);
+    assert(shift != nullptr);
+
+    const char *arg = asm_line_arg(line);
+    int     arg_len = 0;
+
+    return asm_line_is(line, cmd) && arg != nullptr && sscanf(arg, "rex, %d%n", shift, &arg_len) == 1 && arg[arg_len] == '\0';
+}
+
+//===========================================================================================================================
+// CTOR_DTOR
+//===========================================================================================================================
+
+void asm_list_ctor(asm_list *const code)
+{
+    assert(code != nullptr);
+
+    *code = {};
+}
+
+/**
+*   @note Текст функции выделен open_memstream(), поэтому освобождается free().
+*/
+
+void asm_list_dtor(asm_list *const code)
+{
+    assert(code != nullptr);
+
+    free    (code->text);
+    log_free(code->line);
+
+    *code = {};
+}
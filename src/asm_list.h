@@ -0,0 +1,91 @@
+#ifndef ASM_LIST
+#define ASM_LIST
+
+#include <stdio.h>
+
+//===========================================================================================================================
+// CONST
+//===========================================================================================================================
+
+enum ASM_LINE_TYPE
+{
+    LINE_EMPTY      ,   // пустая строка
+    LINE_COMMENT    ,   // строка, состоящая из комментария
+    LINE_LABEL      ,   // метка
+    LINE_CMD        ,   // инструкция
+    LINE_DELETED    ,   // строка, удаленная оптимизатором (не выводится)
+};
+
+enum ASM_ARG_TYPE
+{
+    ARG_NONE        ,   // параметра нет
+    ARG_LOCAL       ,   // [rex+N]: ячейка кадра функции
+    ARG_OTHER       ,   // число, регистр, [N], метка, void
+};
+
+const int ASM_ARG_LEN = 32; // размер буфера для параметров, созданных оптимизатором
+
+//===========================================================================================================================
+// STRUCT
+//===========================================================================================================================
+
+struct asm_line                 // строка ассемблерного кода
+{
+    ASM_LINE_TYPE type;
+    const char   *cmd;          // мнемоника инструкции или имя метки
+    const char   *arg;          // параметр инструкции из текста или статическая строка (см. asm_line_arg())
+    const char   *comment;      // комментарий без '#' (nullptr, если его нет)
+
+    ASM_ARG_TYPE  arg_type;
+    int           slot;         // N для ARG_LOCAL
+    bool          argument;     // pop [rex+N] кладет параметр в кадр вызываемой функции (см. asm_list_mark_arguments())
+
+    char          buff[ASM_ARG_LEN];    // параметр, созданный оптимизатором, если .arg == nullptr
+};
+
+struct asm_list                 // ассемблерный код функции в виде массива строк
+{
+    char     *text;             // текст функции, на который указывают строки (выделен open_memstream())
+    asm_line *line;
+    int       size;
+    int       capacity;
+};
+
+struct asm_label                // метка и индекс ее строки, массив меток отсортирован по имени
+{
+    const char *name;
+    int         index;
+};
+
+//===========================================================================================================================
+// ASM_LIST
+//===========================================================================================================================
+
+bool        asm_list_parse          (asm_list *const code, char *const text);
+bool        asm_list_parse_line     (asm_list *const code, char *line);
+void        asm_list_mark_arguments (asm_list *const code);
+void        asm_list_write          (const asm_list *const code, FILE *const stream);
+
+asm_line   *asm_list_push           (asm_list *const code, const asm_line *const line);
+asm_line   *asm_list_push_cmd       (asm_list *const code, const char *const cmd, const char *const arg);
+asm_line   *asm_list_push_local     (asm_list *const code, const char *const cmd, const int slot);
+
+asm_label  *asm_list_labels         (const asm_list *const code, int *const label_num);
+int         asm_list_find_label     (const asm_label *const label, const int label_num, const char *const name);
+int         asm_label_cmp           (const void *const a, const void *const b);
+
+const char *asm_line_arg            (const asm_line *const line);
+bool        asm_line_is             (const asm_line *const line, const char *const cmd);
+bool        asm_line_is_jump        (const asm_line *const line);
+bool        asm_line_is_cond_jump   (const asm_line *const line);
+bool        asm_line_is_tail_call   (const asm_line *const line);
+bool        asm_line_rex_shift      (const asm_line *const line, const char *const cmd, int *const shift);
+
+//===========================================================================================================================
+// CTOR_DTOR
+//===========================================================================================================================
+
+void asm_list_ctor (asm_list *const code);
+void asm_list_dtor (asm_list *const code);
+
+#endif //ASM_LIST
@@ -10,6 +10,9 @@
 #include "../lib/algorithm/algorithm.h"
 
 #include "backend.h"
+#include "asm_list.h"
+#include "regalloc.h"
+#include "peephole.h"
 #include "terminal_colors.h"
 
 #define fprintf_err(message) fprintf(stderr, TERMINAL_RED "ERROR: " TERMINAL_CANCEL "%s", message)
@@ -58,20 +61,8 @@ int main(const int argc, const char *argv[])
     if (!fill_global_scope(&ast_asm.mem_glob, tree, &rex_begin)) { main_err_exit }
 
     backend_header(stream, main_num, rex_begin);
-    if (!translate_backend(&ast_asm, tree, stream))
-    {
-        fprintf_err("assembling failed\n");
-    }
-    else
-    {
-        int         pattern_size  = 0;
-        const char *pattern_buff  = (const char *) read_file(NAME_PATTERN, &pattern_size);
-        assert     (pattern_buff != nullptr);
-
-        fwrite  (pattern_buff, sizeof(char), pattern_size, stream);
-        fprintf (stderr, TERMINAL_GREEN "assembling success\n" TERMINAL_CANCEL);
-        log_free((char *) pattern_buff);
-    }
+    if (!translate_backend(&ast_asm, tree, stream)) fprintf_err("assembling failed\n");
+    else                                            fprintf(stderr, TERMINAL_GREEN "assembling success\n" TERMINAL_CANCEL);
     fclose(stream);
     main_err_exit
 }
@@ -110,10 +101,32 @@ bool translate_backend(translator *const ast_asm, const AST_node *const node, FI
         $relative = 0;
         translator_new_scope(ast_asm);
 
-        fprintf(stream, "def_%d:\n", $func_index);
+        char  *func_text   = nullptr;
+        size_t func_size   = 0;
+        FILE  *func_stream = open_memstream(&func_text, &func_size);
+        if    (func_stream == nullptr)
+        {
+            log_error("can't open memory stream for function(%d)\n", __LINE__);
+            return false;
+        }
+
+        fprintf(func_stream, "def_%d:\n", $func_index);
+
+        bool no_err = translate_func_args  (ast_asm, L, func_stream) &&
+                      translate_distributor(ast_asm, R, func_stream, true);
+        fclose(func_stream);
+
+        asm_list code = {};
+        asm_list_ctor(&code);
 
-        if (!translate_func_args  (ast_asm, L, stream))       return false;
-        if (!translate_distributor(ast_asm, R, stream, true)) return false;
+        if (no_err) no_err = asm_list_parse   (&code, func_text);
+        else        free(func_text);
+        if (no_err) no_err = regalloc_function(&code);
+        if (no_err) no_err = peephole_function(&code);
+        if (no_err) asm_list_write(&code, stream);
+
+        asm_list_dtor(&code);
+        if (!no_err) return false;
 
         translator_del_scope(ast_asm);
         return true;
@@ -292,26 +305,28 @@ bool translate_if(translator *const ast_asm, const AST_node *const node, FILE *c
     fprintf(stream, "\n"
                     "#OPERATOR IF condition\n");
 
-    
-    translate_distributor(ast_asm, L, stream, false);       //IF condition
+    // условие, которое дешевле проверить на истинность, переходит к case IF, и первым идет case ELSE
+    const bool      jump_if = condition_jump_if(L);
+    const AST_node *first   = jump_if ? R->right : R->left;
+    const AST_node *second  = jump_if ? R->left  : R->right;
 
-    const int tag_else   = TAG_CNT++;
+    const int tag_second = TAG_CNT++;
     const int tag_if_end = TAG_CNT++;
 
-    fprintf(stream, "\n"
-                    "push 0    #OPERATOR IF begin\n"
-                    "je tag_%d #jump to case ELSE if zero condition\n", tag_else);
- 
+    if (!translate_condition(ast_asm, L, stream, tag_second, jump_if)) return false;   //IF condition
+
+    fprintf(stream, "#OPERATOR IF begin\n");
+
     translator_new_scope (ast_asm);
-    translate_distributor(ast_asm, R->left, stream, true);  //case IF operators
+    translate_distributor(ast_asm, first, stream, true);    //first case
     translator_del_scope (ast_asm);
 
-    fprintf(stream, "\n"
-                    "jmp tag_%d #case IF end\n"
-                    "tag_%d:    #case ELSE tag\n", tag_if_end, tag_else);
+    if (second != nullptr) fprintf(stream, "\n"
+                                           "jmp tag_%d #first case end\n", tag_if_end);
+    fprintf(stream, "tag_%d:    #second case tag\n", tag_second);
 
     translator_new_scope (ast_asm);
-    translate_distributor(ast_asm, R->right, stream, true); //case ELSE operators
+    translate_distributor(ast_asm, second, stream, true);   //second case
     translator_del_scope (ast_asm);
 
     fprintf(stream, "\n"
@@ -320,6 +335,10 @@ bool translate_if(translator *const ast_asm, const AST_node *const node, FILE *c
     return true;
 }
 
+/**
+*   @note Условие проверяется в конце цикла, поэтому на каждой итерации выполняется один условный переход.
+*/
+
 bool translate_while(translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op)
 {
     assert(ast_asm != nullptr);
@@ -338,29 +357,152 @@ bool translate_while(translator *const ast_asm, const AST_node *const node, FILE
         return false;
     }
 
+    const int tag_while_body      = TAG_CNT++;
     const int tag_while_condition = TAG_CNT++;
-    const int tag_while_end       = TAG_CNT++;
-
-    fprintf(stream, "tag_%d:    #OPERATOR WHILE condition\n", tag_while_condition);
-
-    translate_distributor(ast_asm, L, stream, false);   //WHILE condition
 
     fprintf(stream, "\n"
-                    "push 0\n"
-                    "je tag_%d  #jump to the end of cycle if zero condition\n", tag_while_end);
-    
+                    "jmp tag_%d #OPERATOR WHILE begin\n"
+                    "tag_%d:    #WHILE operators\n", tag_while_condition, tag_while_body);
+
     translator_new_scope (ast_asm);
     translate_distributor(ast_asm, R, stream, true);    //WHILE operators
     translator_del_scope (ast_asm);
 
     fprintf(stream, "\n"
-                    "jmp tag_%d #jump to WHILE condition\n"
-                    "tag_%d:    #OPERATOR WHILE end\n", tag_while_condition, tag_while_end);
+                    "tag_%d:    #WHILE condition\n", tag_while_condition);
+
+    if (!translate_condition(ast_asm, L, stream, tag_while_body, true)) return false; //WHILE condition
 
+    fprintf(stream, "#OPERATOR WHILE end\n");
     return true;
 }
 //---------------------------------------------------------------------------------------------------------------------------
 
+/**
+*   @brief Переводит условие: переходит на tag_<tag>, если истинность условия равна jump_if, иначе исполнение продолжается.
+*
+*   @note Сравнение переводится в один условный переход без вызова и без значения 0/1 в стеке.
+*         AND и OR вычисляются по короткой схеме: их операнды переводятся как условия с переходами на те же метки.
+*         Переходы ja, jae, jb, jbe сравнивают с точностью до approx_equal(), обратных им переходов нет,
+*         поэтому переход по ложности такого сравнения - это его переход через безусловный.
+*         Остальные условия вычисляются и сравниваются с нулем.
+*/
+
+bool translate_condition(translator *const ast_asm, const AST_node *const node, FILE *const stream, const int tag, const bool jump_if)
+{
+    assert(ast_asm != nullptr);
+    assert(node    != nullptr);
+    assert(stream  != nullptr);
+
+    if ($type == OPERATOR && $op_type == OP_NOT && L != nullptr && R == nullptr)
+    {
+        return translate_condition(ast_asm, L, stream, tag, !jump_if);
+    }
+
+    if ($type == OPERATOR && ($op_type == OP_AND || $op_type == OP_OR) && L != nullptr && R != nullptr)
+    {
+        // правый операнд пропускается, если левый уже определил значение: ложный для AND, истинный для OR
+        const bool short_value = ($op_type == OP_OR);
+
+        if (jump_if == short_value)
+        {
+            if (!translate_condition(ast_asm, L, stream, tag, jump_if)) return false;
+            return translate_condition(ast_asm, R, stream, tag, jump_if);
+        }
+
+        const int tag_skip = TAG_CNT++;
+
+        if (!translate_condition(ast_asm, L, stream, tag_skip, short_value)) return false;
+        if (!translate_condition(ast_asm, R, stream, tag     , jump_if    )) return false;
+
+        fprintf(stream, "tag_%d:\n", tag_skip);
+        return true;
+    }
+
+    const char *jump = condition_jump(node);
+    if (jump != nullptr && L != nullptr && R != nullptr)
+    {
+        if (!translate_distributor(ast_asm, L, stream, false)) return false;
+        if (!translate_distributor(ast_asm, R, stream, false)) return false;
+
+        if      (jump_if)                  fprintf(stream, "%s tag_%d\n" , jump, tag);
+        else if ($op_type == OP_EQUAL    ) fprintf(stream, "jne tag_%d\n", tag);
+        else if ($op_type == OP_NOT_EQUAL) fprintf(stream, "je tag_%d\n" , tag);
+        else
+        {
+            const int tag_skip = TAG_CNT++;
+            fprintf(stream, "%s tag_%d\n"
+                            "jmp tag_%d\n"
+                            "tag_%d:\n", jump, tag_skip, tag, tag_skip);
+        }
+        return true;
+    }
+
+    if (!translate_distributor(ast_asm, node, stream, false)) return false;
+
+    fprintf(stream, "push 0\n"
+                    "%s tag_%d #jump if %s condition\n", jump_if ? "jne" : "je", tag, jump_if ? "nonzero" : "zero");
+    return true;
+}
+
+/**
+*   @brief Переводит условие, значение которого используется как число: кладет в стек 1, если условие истинно, и 0 иначе.
+*/
+
+bool translate_condition_value(translator *const ast_asm, const AST_node *const node, FILE *const stream)
+{
+    assert(ast_asm != nullptr);
+    assert(node    != nullptr);
+    assert(stream  != nullptr);
+
+    const int tag_true = TAG_CNT++;
+    const int tag_end  = TAG_CNT++;
+
+    if (!translate_condition(ast_asm, node, stream, tag_true, true)) return false;
+
+    fprintf(stream, "push 0\n"
+                    "jmp tag_%d\n"
+                    "tag_%d:\n"
+                    "push 1\n"
+                    "tag_%d:\n", tag_end, tag_true, tag_end);
+    return true;
+}
+
+/**
+*   @return мнемоника перехода, выполняемого при истинности сравнения node, и nullptr, если node - не сравнение
+*/
+
+const char *condition_jump(const AST_node *const node)
+{
+    assert(node != nullptr);
+
+    if ($type != OPERATOR) return nullptr;
+
+    if ($op_type == OP_EQUAL      ) return "je" ;
+    if ($op_type == OP_NOT_EQUAL  ) return "jne";
+    if ($op_type == OP_ABOVE      ) return "ja" ;
+    if ($op_type == OP_BELOW      ) return "jb" ;
+    if ($op_type == OP_ABOVE_EQUAL) return "jae";
+    if ($op_type == OP_BELOW_EQUAL) return "jbe";
+
+    return nullptr;
+}
+
+/**
+*   @return true, если условие node переводится одним переходом по истинности, но не по ложности (см. translate_condition())
+*/
+
+bool condition_jump_if(const AST_node *const node)
+{
+    assert(node != nullptr);
+
+    if ($type == OPERATOR && $op_type == OP_NOT && L != nullptr) return !condition_jump_if(L);
+    if ($type == OPERATOR && ($op_type == OP_AND || $op_type == OP_OR) && R != nullptr) return condition_jump_if(R);
+
+    return condition_jump(node) != nullptr && $op_type != OP_EQUAL && $op_type != OP_NOT_EQUAL;
+}
+//---------------------------------------------------------------------------------------------------------------------------
+
 bool translate_operator(translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op)
 {
     assert(ast_asm != nullptr);
@@ -421,6 +563,11 @@ bool translate_closed_binary_operator(translator *const ast_asm, const AST_node
         fprintf(stderr, "\"%s\" has must have two operands\n", OPERATOR_NAMES[$op_type]);
         return false;
     }
+    if (condition_jump(node) != nullptr || $op_type == OP_AND || $op_type == OP_OR)
+    {
+        return translate_condition_value(ast_asm, node, stream);
+    }
+
     if (!translate_distributor(ast_asm, L, stream, false)) return false;
     if (!translate_distributor(ast_asm, R, stream, false)) return false;
 
@@ -432,16 +579,6 @@ bool translate_closed_binary_operator(translator *const ast_asm, const AST_node
         case OP_DIV         : fprintf(stream, "div\n"); break;
         case OP_POW         : fprintf(stream, "pow\n"); break;
 
-        case OP_EQUAL       : fprintf(stream, "call def_operator_eq\n" ); break;
-        case OP_ABOVE       : fprintf(stream, "call def_operator_a\n"  ); break;
-        case OP_BELOW       : fprintf(stream, "call def_operator_b\n"  ); break;
-        case OP_ABOVE_EQUAL : fprintf(stream, "call def_operator_ae\n" ); break;
-        case OP_BELOW_EQUAL : fprintf(stream, "call def_operator_be\n" ); break;
-        case OP_NOT_EQUAL   : fprintf(stream, "call def_operator_neq\n"); break;
-
-        case OP_OR          : fprintf(stream, "call def_operator_or\n" ); break;
-        case OP_AND         : fprintf(stream, "call def_operator_and\n"); break;
-
         default             : assert(false && "default case in translate_closed_binary_operator()\n"); return false;
     }
     return true;
@@ -570,11 +707,12 @@ bool translate_closed_unary_operator(translator *const ast_asm, const AST_node *
         fprintf(stderr, "\"%s\" must have one operand\n", OPERATOR_NAMES[$op_type]);
         return false;
     }
+    if ($op_type == OP_NOT) return translate_condition_value(ast_asm, node, stream);
+
     if (!translate_distributor(ast_asm, L, stream, false)) return false;
 
     switch ($op_type)
     {
-        case OP_NOT : fprintf(stream, "call def_operator_not\n"); break;
         case OP_SQRT: fprintf(stream, "sqrt\n");                  break;
         case OP_SIN : fprintf(stream, "sin\n");                   break;
         case OP_COS : fprintf(stream, "cos\n");                   break;
@@ -646,6 +784,11 @@ bool translate_return(translator *const ast_asm, const AST_node *const node, FIL
         fprintf_err("\"return\" must be independent operator\n");
         return false;
     }
+    const AST_node *value = (L != nullptr) ? L : R;
+
+    if (value != nullptr && (L == nullptr || R == nullptr) && value->type == FUNC_CALL)
+        return translate_tail_call(ast_asm, value, stream);
+
     if (!translate_distributor(ast_asm, L, stream, false)) return false;
     if (!translate_distributor(ast_asm, R, stream, false)) return false;
 
@@ -653,6 +796,35 @@ bool translate_return(translator *const ast_asm, const AST_node *const node, FIL
 
     return true;
 }
+
+/**
+*   @brief Транслирует "return f(...)": вызываемая функция получает кадр текущей и возвращается сразу в вызвавшую ее.
+*
+*   @note Параметры сначала вычисляются в стек, а потом кладутся в ячейки [rex+0] .. [rex+cnt-1], поэтому их вычисление
+*         может читать локальные переменные текущей функции. После этого кадр текущей функции не нужен,
+*         и вместо "addi rex; call; subi rex; ret" достаточно "jmp def_N": хвостовая рекурсия не расходует стек вызовов и RAM.
+*/
+
+bool translate_tail_call(translator *const ast_asm, const AST_node *const node, FILE *const stream)
+{
+    assert(ast_asm != nullptr);
+    assert(node    != nullptr);
+    assert(stream  != nullptr);
+    assert($type   == FUNC_CALL);
+
+    fprintf(stream, "\n"
+                    "#OPERATOR tail_call begin\n");
+
+    int param_cnt = 0;
+    if (!translate_func_param(ast_asm, L, stream, &param_cnt)) return false;
+    fprintf(stream, "\n");
+
+    for (int i = param_cnt - 1; i >= 0; --i) fprintf(stream, "pop [rex+%d]\n", i);
+
+    fprintf(stream, "jmp def_%d\n"
+                    "#OPERATOR tail_call end\n", $func_index);
+    return true;
+}
 //---------------------------------------------------------------------------------------------------------------------------
 
 bool fill_global_scope(global *const mem_glob, const AST_node *const node, int *const rex)
@@ -703,10 +875,7 @@ void add_rex(const int rex_add, FILE *const stream)
 
     fprintf(stream, "\n"
                     "#REX ADD BEGIN\n"
-                    "push rex\n"
-                    "push %d\n"
-                    "add\n"
-                    "pop rex\n"
+                    "addi rex, %d\n"
                     "#REX ADD END\n", rex_add);
 }
 
@@ -716,10 +885,7 @@ void sub_rex(const int rex_sub, FILE *const stream)
 
     fprintf(stream, "\n"
                     "#REX SUB BEGIN\n"
-                    "push rex\n"
-                    "push %d\n"
-                    "sub\n"
-                    "pop rex\n"
+                    "subi rex, %d\n"
                     "#REX SUB END\n", rex_sub);
 }
 //---------------------------------------------------------------------------------------------------------------------------
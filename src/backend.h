@@ -4,12 +4,6 @@
 #include "ast.h"
 #include "../lib/stack/stack.h"
 
-//===========================================================================================================================
-// CONST
-//===========================================================================================================================
-
-const char *NAME_PATTERN = "src/backend_pattern.txt";
-
 //===========================================================================================================================
 // DSL
 //===========================================================================================================================
@@ -64,6 +58,11 @@ bool translate_variable                 (translator *const ast_asm, const AST_no
 bool translate_if                       (translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op);
 bool translate_while                    (translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op);
 //---------------------------------------------------------------------------------------------------------------------------
+bool translate_condition                (translator *const ast_asm, const AST_node *const node, FILE *const stream, const int tag, const bool jump_if);
+bool translate_condition_value          (translator *const ast_asm, const AST_node *const node, FILE *const stream);
+const char *condition_jump              (const AST_node *const node);
+bool condition_jump_if                  (const AST_node *const node);
+//---------------------------------------------------------------------------------------------------------------------------
 bool translate_operator                 (translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op);
 //---------------------------------------------------------------------------------------------------------------------------
 bool translate_closed_binary_operator   (translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op);
@@ -79,6 +78,7 @@ bool translate_closed_unary_operator    (translator *const ast_asm, const AST_no
 //---------------------------------------------------------------------------------------------------------------------------
 bool translate_func_call                (translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op);
 bool translate_func_param               (translator *const ast_asm, const AST_node *const node, FILE *const stream, int *const param_cnt);
+bool translate_tail_call                (translator *const ast_asm, const AST_node *const node, FILE *const stream);
 //---------------------------------------------------------------------------------------------------------------------------
 bool translate_return                   (translator *const ast_asm, const AST_node *const node, FILE *const stream, const bool independent_op);
 //---------------------------------------------------------------------------------------------------------------------------
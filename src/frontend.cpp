@@ -2187,30 +2187,22 @@ bool get_key_word_type(source *const code, const int token_beg, const int token_
 {
     assert(code != nullptr);
 
-    for (size_t i = 0; i * sizeof(char *) < sizeof(KEY_WORD_NAMES); ++i)
-    {
-        if (!strncmp(KEY_WORD_NAMES[i], buff_data + token_beg, (size_t)token_len))
-        {
-            if (type != nullptr) *type = (KEY_WORD_TYPE) i;
-            return true;
-        }
-    }
-    return false;
+    const int index = perfect_hash_find(KEY_WORD_HASH, KEY_WORD_NAMES, buff_data + token_beg, token_len, false);
+    if (index == -1) return false;
+
+    if (type != nullptr) *type = (KEY_WORD_TYPE) index;
+    return true;
 }
                                                                                                         // default type = nullptr
 bool get_key_double_char(source *const code, const int token_beg, const int token_len, KEY_CHAR_DOUBLE_TYPE *const type)
 {
     assert(code != nullptr);
 
-    for (size_t i = 0; i * sizeof(char *) < sizeof(KEY_CHAR_DOUBLE_NAMES); ++i)
-    {
-        if (!strncmp(KEY_CHAR_DOUBLE_NAMES[i], buff_data + token_beg, (size_t)token_len))
-        {
-            if (type != nullptr) *type = (KEY_CHAR_DOUBLE_TYPE) i;
-            return true;
-        }
-    }
-    return false;
+    const int index = perfect_hash_find(KEY_CHAR_DOUBLE_HASH, KEY_CHAR_DOUBLE_NAMES, buff_data + token_beg, token_len, false);
+    if (index == -1) return false;
+
+    if (type != nullptr) *type = (KEY_CHAR_DOUBLE_TYPE) index;
+    return true;
 }
                                                                                    //default num = nullptr
 bool get_dbl_num(source *const code, const int token_beg, const int token_len, double *const num)
@@ -3,6 +3,7 @@
 
 #include "ast.h"
 #include "../lib/stack/stack.h"
+#include "../lib/perfect_hash/perfect_hash.h"
 
 //===========================================================================================================================
 // DSL
@@ -56,7 +57,7 @@ static const char *TOKEN_TYPE_NAMES[] =
 };
 
 static const char *KEY_CHAR_NAMES     = ";," "(){}" "+-*/^" "!=><" "|&" "#";
-static const char *KEY_WORD_NAMES[]   =
+static constexpr const char *KEY_WORD_NAMES[] =
 {
     "BARCELONA"         ,   // int
     "MESSI"             ,   // if
@@ -87,7 +88,7 @@ enum KEY_WORD_TYPE
     LN      ,
 };
 
-static const char *KEY_CHAR_DOUBLE_NAMES[] = 
+static constexpr const char *KEY_CHAR_DOUBLE_NAMES[] =
 {
     "GOAL"              ,   // ==
     "NO_GOAL"           ,   // !=
@@ -106,6 +107,16 @@ enum KEY_CHAR_DOUBLE_TYPE
     OR          ,
 };
 
+// таблицы для get_key_word_type() и get_key_double_char(), ключевые слова чувствительны к регистру
+static constexpr int KEY_WORD_NUM        = (int) (sizeof(KEY_WORD_NAMES)        / sizeof(char *));
+static constexpr int KEY_CHAR_DOUBLE_NUM = (int) (sizeof(KEY_CHAR_DOUBLE_NAMES) / sizeof(char *));
+
+static constexpr perfect_hash<32> KEY_WORD_HASH        = perfect_hash_build<32>(KEY_WORD_NAMES       , KEY_WORD_NUM       , 0, 0, false);
+static constexpr perfect_hash<16> KEY_CHAR_DOUBLE_HASH = perfect_hash_build<16>(KEY_CHAR_DOUBLE_NAMES, KEY_CHAR_DOUBLE_NUM, 0, 0, false);
+
+static_assert(KEY_WORD_HASH       .seed != PERFECT_HASH_NO_SEED, "can't build perfect hash for KEY_WORD_NAMES");
+static_assert(KEY_CHAR_DOUBLE_HASH.seed != PERFECT_HASH_NO_SEED, "can't build perfect hash for KEY_CHAR_DOUBLE_NAMES");
+
 static const char *LEXIS_GRAPHVIZ_HEADER = "digraph {\n"
                                          //"rankdir=LR\n"
                                            "splines=ortho\n"
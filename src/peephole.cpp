@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../lib/logs/log.h"
+
+#include "peephole.h"
+
+//===========================================================================================================================
+// PEEPHOLE
+//===========================================================================================================================
+
+/**
+*   @brief Удаляет избыточные последовательности инструкций в коде функции.
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Окно - две соседние инструкции, между которыми нет меток. Проходы повторяются, пока код изменяется.
+*         Строки не добавляются и не переставляются, поэтому индексы меток остаются верными.
+*/
+
+bool peephole_function(asm_list *const code)
+{
+    assert(code != nullptr);
+
+    int        label_num = 0;
+    asm_label *label     = asm_list_labels(code, &label_num);
+    if (label == nullptr) return false;
+
+    for (int pass = 0; pass < PEEPHOLE_MAX_PASS && peephole_pass(code, label, label_num); ++pass);
+
+    log_free(label);
+    return true;
+}
+
+/**
+*   @return true, если код изменился
+*/
+
+bool peephole_pass(asm_list *const code, const asm_label *const label, const int label_num)
+{
+    assert(code  != nullptr);
+    assert(label != nullptr);
+
+    bool changed = false;
+
+    for (int cur = 0; cur < code->size; ++cur)
+    {
+        if (code->line[cur].type != LINE_CMD) continue;
+
+        const int next = peephole_next(code, cur);
+
+        if (peephole_push_pop    (code, cur, next))                   { changed = true; continue; }
+        if (peephole_rex_shift   (code, cur, next))                   { changed = true; continue; }
+        if (peephole_jump        (code, cur, next, label, label_num)) { changed = true; continue; }
+        if (peephole_unreachable (code, cur))                         { changed = true; continue; }
+    }
+    return changed;
+}
+//---------------------------------------------------------------------------------------------------------------------------
+
+/**
+*   @brief "push X; pop X" и "push X; pop void" ничего не делают.
+*/
+
+bool peephole_push_pop(asm_list *const code, const int cur, const int next)
+{
+    assert(code != nullptr);
+
+    if (next == code->size) return false;
+
+    const asm_line *push = code->line + cur;
+    const asm_line *pop  = code->line + next;
+
+    if (!asm_line_is(push, "push") || !asm_line_is(pop, "pop")) return false;
+
+    const char *push_arg = asm_line_arg(push);
+    const char * pop_arg = asm_line_arg(pop);
+
+    if (push_arg == nullptr || pop_arg == nullptr) return false;
+    if (strcmp(pop_arg, "void") && strcmp(pop_arg, push_arg)) return false;
+
+    peephole_delete(code, cur);
+    peephole_delete(code, next);
+    return true;
+}
+
+/**
+*   @brief Объединяет соседние "addi rex, a" и "subi rex, b" в одну инструкцию или удаляет их, если сдвиг нулевой.
+*/
+
+bool peephole_rex_shift(asm_list *const code, const int cur, const int next)
+{
+    assert(code != nullptr);
+
+    if (next == code->size) return false;
+
+    int cur_shift  = 0;
+    int next_shift = 0;
+
+    if      (asm_line_rex_shift(code->line + cur, "addi", &cur_shift)) ;
+    else if (asm_line_rex_shift(code->line + cur, "subi", &cur_shift)) cur_shift = -cur_shift;
+    else return false;
+
+    if      (asm_line_rex_shift(code->line + next, "addi", &next_shift)) ;
+    else if (asm_line_rex_shift(code->line + next, "subi", &next_shift)) next_shift = -next_shift;
+    else return false;
+
+    const int shift = cur_shift + next_shift;
+
+    peephole_delete(code, next);
+    if (shift == 0) { peephole_delete(code, cur); return true; }
+
+    asm_line *line = code->line + cur;
+
+    line->cmd      = (shift > 0) ? "addi" : "subi";
+    line->arg      = nullptr;
+    line->arg_type = ARG_OTHER;
+    snprintf(line->buff, sizeof(line->buff), "rex, %d", abs(shift));
+
+    return true;
+}
+
+/**
+*   @brief Упрощает переходы.
+*
+*   @note "jmp L; L:"              - переход на следующую инструкцию удаляется.
+*   @note "je L1; jmp L2; L1:"     - заменяется на "jne L2; L1:" (и наоборот). Остальные условия не обращаются точно
+*                                    из-за approx_equal().
+*   @note "jcc L1; ... L1: jmp L2" - переход сразу направляется на L2.
+*   @note "jmp L;  ... L: ret"     - заменяется на ret.
+*/
+
+bool peephole_jump(asm_list *const code, const int cur, const int next, const asm_label *const label, const int label_num)
+{
+    assert(code  != nullptr);
+    assert(label != nullptr);
+
+    asm_line *jump = code->line + cur;
+    if (!asm_line_is_jump(jump)) return false;
+
+    const char *target = asm_line_arg(jump);
+    if (target == nullptr) return false;
+
+    const int target_line = asm_list_find_label(label, label_num, target);
+    if (target_line == -1) return false;
+
+    for (int line = next; line < code->size && code->line[line].type == LINE_LABEL; line = peephole_next(code, line))
+    {
+        if (line == target_line && asm_line_is(jump, "jmp")) { peephole_delete(code, cur); return true; }
+    }
+
+    if ((asm_line_is(jump, "je") || asm_line_is(jump, "jne")) && next < code->size && asm_line_is(code->line + next, "jmp"))
+    {
+        const int after_jmp = peephole_next(code, next);
+
+        for (int line = after_jmp; line < code->size && code->line[line].type == LINE_LABEL; line = peephole_next(code, line))
+        {
+            if (line != target_line) continue;
+
+            jump->cmd = asm_line_is(jump, "je") ? "jne" : "je";
+            jump->arg = asm_line_arg(code->line + next);
+
+            peephole_delete(code, next);
+            return true;
+        }
+    }
+
+    const int target_cmd = peephole_next_cmd(code, target_line);
+    if (target_cmd == code->size) return false;
+
+    const asm_line *target_jump = code->line + target_cmd;
+
+    if (asm_line_is(target_jump, "jmp") && asm_line_arg(target_jump) != nullptr && strcmp(asm_line_arg(target_jump), target))
+    {
+        jump->arg = asm_line_arg(target_jump);
+        return true;
+    }
+
+    if (asm_line_is(jump, "jmp") && (asm_line_is(target_jump, "ret") || asm_line_is(target_jump, "hlt")))
+    {
+        jump->cmd      = target_jump->cmd;
+        jump->arg      = nullptr;
+        jump->arg_type = ARG_NONE;
+        jump->buff[0]  = '\0';
+        return true;
+    }
+    return false;
+}
+
+/**
+*   @brief Удаляет инструкции после jmp, ret и hlt до ближайшей метки.
+*/
+
+bool peephole_unreachable(asm_list *const code, const int cur)
+{
+    assert(code != nullptr);
+
+    const asm_line *line = code->line + cur;
+    if (!asm_line_is(line, "jmp") && !asm_line_is(line, "ret") && !asm_line_is(line, "hlt")) return false;
+
+    bool changed = false;
+    for (int next = peephole_next(code, cur); next < code->size && code->line[next].type == LINE_CMD; next = peephole_next(code, next))
+    {
+        peephole_delete(code, next);
+        changed = true;
+    }
+    return changed;
+}
+//---------------------------------------------------------------------------------------------------------------------------
+
+/**
+*   @return индекс первой инструкции или метки после строки cur и code->size, если их нет
+*/
+
+int peephole_next(const asm_list *const code, const int cur)
+{
+    assert(code != nullptr);
+
+    int next = cur + 1;
+    while (next < code->size && code->line[next].type != LINE_CMD && code->line[next].type != LINE_LABEL) ++next;
+
+    return next;
+}
+
+/**
+*   @return индекс первой инструкции после строки cur (метки пропускаются) и code->size, если ее нет
+*/
+
+int peephole_next_cmd(const asm_list *const code, const int cur)
+{
+    assert(code != nullptr);
+
+    int next = cur + 1;
+    while (next < code->size && code->line[next].type != LINE_CMD) ++next;
+
+    return next;
+}
+
+void peephole_delete(asm_list *const code, const int cur)
+{
+    assert(code != nullptr);
+    assert(0 <= cur && cur < code->size);
+
+    code->line[cur].type = LINE_DELETED;
+}
@@ -0,0 +1,28 @@
+#ifndef PEEPHOLE
+#define PEEPHOLE
+
+#include "asm_list.h"
+
+//===========================================================================================================================
+// CONST
+//===========================================================================================================================
+
+const int PEEPHOLE_MAX_PASS = 16;   // ограничение числа проходов (цепочки переходов могут быть циклическими)
+
+//===========================================================================================================================
+// PEEPHOLE
+//===========================================================================================================================
+
+bool peephole_function      (asm_list *const code);
+bool peephole_pass          (asm_list *const code, const asm_label *const label, const int label_num);
+
+bool peephole_push_pop      (asm_list *const code, const int cur, const int next);
+bool peephole_rex_shift     (asm_list *const code, const int cur, const int next);
+bool peephole_jump          (asm_list *const code, const int cur, const int next, const asm_label *const label, const int label_num);
+bool peephole_unreachable   (asm_list *const code, const int cur);
+
+int  peephole_next          (const asm_list *const code, const int cur);
+int  peephole_next_cmd      (const asm_list *const code, const int cur);
+void peephole_delete        (asm_list *const code, const int cur);
+
+#endif //PEEPHOLE
@@ -0,0 +1,416 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../lib/logs/log.h"
+
+#include "regalloc.h"
+
+//===========================================================================================================================
+// REGALLOC
+//===========================================================================================================================
+
+/**
+*   @brief Размещает самые часто используемые локальные переменные функции в регистрах rax..rdx.
+*
+*   @param code [in][out] - код функции, начинающийся с метки def_N
+*
+*   @return true, если ошибки не произошло и false в противном случае
+*
+*   @note Переменная - ячейка кадра [rex+N]. Для ячеек вычисляется живость по графу потока управления функции,
+*         ячейки, живые одновременно, получают разные регистры. Регистры сохраняются вызывающей функцией:
+*         перед call живые после него ячейки записываются в свои ячейки кадра, после call читаются обратно.
+*         Параметры, живые на входе в функцию, загружаются в регистры после метки def_N.
+*   @note Хвостовой вызов "jmp def_N" завершает функцию так же, как ret.
+*   @note Если исполнение может дойти до конца функции и провалиться в следующую, код не изменяется.
+*/
+
+bool regalloc_function(asm_list *const code)
+{
+    assert(code != nullptr);
+
+    regalloc alloc = {};
+    if (!regalloc_ctor(&alloc, code)) return false;
+
+    bool no_err = true;
+    if (regalloc_cfg(&alloc))
+    {
+        regalloc_liveness(&alloc);
+        regalloc_calls   (&alloc);
+        regalloc_choose  (&alloc);
+        no_err = regalloc_rewrite(&alloc);
+    }
+
+    regalloc_dtor(&alloc);
+    return no_err;
+}
+
+/**
+*   @brief Строит граф потока управления, оценивает частоту исполнения строк и находит чтения и записи ячеек.
+*
+*   @return true, если функция подходит для распределения регистров
+*
+*   @note Строка исполняется в REGALLOC_LOOP_WEIGHT раз чаще за каждый обратный переход, охватывающий ее.
+*/
+
+bool regalloc_cfg(regalloc *const alloc)
+{
+    assert(alloc != nullptr);
+
+    const asm_list *code = alloc->code;
+
+    int        label_num = 0;
+    asm_label *label     = asm_list_labels(code, &label_num);
+    if (label == nullptr) return false;
+
+    bool suitable = true;
+    int *depth    = (int *) log_calloc((size_t) code->size + 1, sizeof(int));
+
+    if (depth == nullptr) suitable = false;
+
+    for (int i = 0; suitable && i < code->size; ++i)
+    {
+        const asm_line *cur = code->line + i;
+
+        alloc->succ[2 * i    ] = i + 1;
+        alloc->succ[2 * i + 1] = -1;
+
+        if (cur->type != LINE_CMD) continue;
+
+        if (asm_line_is(cur, "ret") || asm_line_is(cur, "hlt") || asm_line_is_tail_call(cur)) alloc->succ[2 * i] = -1;
+
+        else if (asm_line_is_jump(cur))
+        {
+            const int target = asm_list_find_label(label, label_num, asm_line_arg(cur));
+            if (target == -1) { suitable = false; break; }
+
+            if (asm_line_is(cur, "jmp")) alloc->succ[2 * i    ] = target;
+            else                         alloc->succ[2 * i + 1] = target;
+
+            if (target <= i) { depth[target]++; depth[i + 1]--; }
+        }
+
+        if (cur->arg_type == ARG_LOCAL && !cur->argument && 0 <= cur->slot && cur->slot < REGALLOC_SLOTS)
+        {
+            if (asm_line_is(cur, "push")) alloc->use[i] = slot_bit(cur->slot);
+            if (asm_line_is(cur, "pop" )) alloc->def[i] = slot_bit(cur->slot);
+        }
+    }
+
+    // провалиться за конец функции можно только из достижимой строки
+    bool *reachable = (bool *) log_calloc((size_t) code->size + 1, sizeof(bool));
+    int  *worklist  = (int  *) log_calloc((size_t) code->size + 1, sizeof(int));
+
+    if (suitable && reachable != nullptr && worklist != nullptr && code->size > 0)
+    {
+        int worklist_size = 0;
+
+        reachable[0]               = true;
+        worklist[worklist_size++]  = 0;
+
+        while (worklist_size > 0)
+        {
+            const int cur = worklist[--worklist_size];
+
+            for (int k = 0; k < 2; ++k)
+            {
+                const int next = alloc->succ[2 * cur + k];
+                if (next == -1 || reachable[next]) continue;
+
+                reachable[next] = true;
+                if (next < code->size) worklist[worklist_size++] = next;
+            }
+        }
+        if (reachable[code->size]) suitable = false;
+    }
+    else suitable = false;
+
+    int cur_depth = 0;
+    for (int i = 0; suitable && i < code->size; ++i)
+    {
+        cur_depth += depth[i];
+
+        alloc->weight[i] = 0;
+        if (!reachable[i]) continue;
+
+        alloc->weight[i] = 1;
+        for (int k = 0; k < cur_depth && k < 6; ++k) alloc->weight[i] *= REGALLOC_LOOP_WEIGHT;
+    }
+
+    for (int i = 0; suitable && i < code->size; ++i)
+    {
+        if (alloc->succ[2 * i] == code->size) alloc->succ[2 * i] = -1;
+    }
+
+    log_free(label);
+    log_free(depth);
+    log_free(reachable);
+    log_free(worklist);
+
+    return suitable;
+}
+
+/**
+*   @brief Вычисляет живость ячеек итеративно до неподвижной точки: live_in = use | (live_out & ~def).
+*/
+
+void regalloc_liveness(regalloc *const alloc)
+{
+    assert(alloc != nullptr);
+
+    const int size = alloc->code->size;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+
+        for (int i = size - 1; i >= 0; --i)
+        {
+            slot_set out = 0;
+
+            for (int k = 0; k < 2; ++k)
+            {
+                const int next = alloc->succ[2 * i + k];
+                if (next != -1) out |= alloc->live_in[next];
+            }
+
+            const slot_set in = alloc->use[i] | (out & ~alloc->def[i]);
+
+            if (out != alloc->live_out[i] || in != alloc->live_in[i]) changed = true;
+
+            alloc->live_out[i] = out;
+            alloc->live_in [i] = in;
+        }
+    }
+}
+
+/**
+*   @brief Находит ячейки, сохраняемые вокруг вызовов, и оценивает выигрыш от размещения каждой ячейки в регистре.
+*
+*   @note Вызов - последовательность "addi rex, shift; call def_N; subi rex, shift" (см. translate_func_call()).
+*         Ячейки с номером не меньше shift принадлежат кадру вызываемой функции и не сохраняются.
+*   @note Ячейки, живые одновременно (или записываемые, пока живы другие), мешают друг другу.
+*/
+
+void regalloc_calls(regalloc *const alloc)
+{
+    assert(alloc != nullptr);
+
+    const asm_list *code = alloc->code;
+
+    for (int i = 0; i < code->size; ++i)
+    {
+        int shift = 0;
+        if (!asm_line_rex_shift(code->line + i, "addi", &shift)) continue;
+
+        int call = i + 1;
+        while (call < code->size && code->line[call].type != LINE_CMD) ++call;
+
+        int ret = call + 1;
+        while (ret  < code->size && code->line[ret ].type != LINE_CMD) ++ret;
+
+        int ret_shift = 0;
+        if (call >= code->size || !asm_line_is(code->line + call, "call") ||
+            ret  >= code->size || !asm_line_rex_shift(code->line + ret, "subi", &ret_shift) || ret_shift != shift) continue;
+
+        const slot_set frame = (shift >= REGALLOC_SLOTS) ? ~0ull : slot_bit(shift) - 1;
+
+        alloc->saved[i  ] = alloc->live_out[ret] & frame;
+        alloc->saved[ret] = alloc->saved[i];
+
+        for (int slot = 0; slot < REGALLOC_SLOTS; ++slot)
+        {
+            if (alloc->saved[ret] & slot_bit(slot)) alloc->benefit[slot] -= REGALLOC_SAVE_COST * alloc->weight[call];
+        }
+    }
+
+    for (int i = 0; i < code->size; ++i)
+    {
+        const slot_set access = alloc->use[i] | alloc->def[i];
+        const slot_set live   = alloc->live_out[i] | alloc->def[i];
+
+        for (int slot = 0; slot < REGALLOC_SLOTS; ++slot)
+        {
+            if (access & slot_bit(slot)) alloc->benefit  [slot] += REGALLOC_ACCESS_GAIN * alloc->weight[i];
+            if (live   & slot_bit(slot)) alloc->interfere[slot] |= live & ~slot_bit(slot);
+        }
+    }
+
+    const slot_set entry = (code->size > 0) ? alloc->live_in[0] : 0;
+
+    for (int slot = 0; slot < REGALLOC_SLOTS; ++slot)
+    {
+        if (!(entry & slot_bit(slot))) continue;
+
+        alloc->benefit  [slot] -= REGALLOC_LOAD_COST;
+        alloc->interfere[slot] |= entry & ~slot_bit(slot);
+    }
+}
+
+/**
+*   @brief Раздает регистры ячейкам в порядке убывания выигрыша: ячейка получает первый регистр,
+*          не занятый мешающими ей ячейками.
+*/
+
+void regalloc_choose(regalloc *const alloc)
+{
+    assert(alloc != nullptr);
+
+    bool done[REGALLOC_SLOTS] = {};
+
+    while (true)
+    {
+        int best = -1;
+        for (int slot = 0; slot < REGALLOC_SLOTS; ++slot)
+        {
+            if (done[slot] || !(alloc->benefit[slot] > 0)) continue;
+            if (best == -1 || alloc->benefit[slot] > alloc->benefit[best]) best = slot;
+        }
+        if (best == -1) break;
+
+        done[best] = true;
+
+        bool busy[REGALLOC_REG_NUMBER] = {};
+        for (int slot = 0; slot < REGALLOC_SLOTS; ++slot)
+        {
+            if ((alloc->interfere[best] & slot_bit(slot)) && alloc->reg[slot] != -1) busy[alloc->reg[slot]] = true;
+        }
+        for (int reg = 0; reg < REGALLOC_REG_NUMBER; ++reg)
+        {
+            if (!busy[reg]) { alloc->reg[best] = reg; break; }
+        }
+    }
+}
+
+/**
+*   @brief Заменяет обращения к ячейкам, получившим регистры, и добавляет загрузку параметров и сохранение регистров вокруг вызовов.
+*/
+
+bool regalloc_rewrite(regalloc *const alloc)
+{
+    assert(alloc != nullptr);
+
+    asm_list *code      = alloc->code;
+    slot_set  allocated = 0;
+
+    for (int slot = 0; slot < REGALLOC_SLOTS; ++slot)
+    {
+        if (alloc->reg[slot] != -1) allocated |= slot_bit(slot);
+    }
+    if (allocated == 0) return true;
+
+    asm_list out = {};
+    asm_list_ctor(&out);
+
+    bool no_err = true;
+    for (int i = 0; no_err && i < code->size; ++i)
+    {
+        asm_line cur = code->line[i];
+
+        if (cur.type == LINE_CMD && cur.arg_type == ARG_LOCAL && !cur.argument &&
+            0 <= cur.slot && cur.slot < REGALLOC_SLOTS && alloc->reg[cur.slot] != -1)
+        {
+            cur.arg      = REGALLOC_REGS[alloc->reg[cur.slot]];
+            cur.arg_type = ARG_OTHER;
+        }
+
+        const slot_set save    = alloc->saved[i] & allocated;
+        int            shift   = 0;
+        const bool     restore = asm_line_rex_shift(&cur, "subi", &shift);
+
+        for (int slot = 0; no_err && !restore && slot < REGALLOC_SLOTS; ++slot)
+        {
+            if (!(save & slot_bit(slot))) continue;
+
+            no_err = asm_list_push_cmd  (&out, "push", REGALLOC_REGS[alloc->reg[slot]]) != nullptr &&
+                     asm_list_push_local(&out, "pop" , slot)                             != nullptr;
+        }
+
+        if (no_err) no_err = asm_list_push(&out, &cur) != nullptr;
+
+        const slot_set load = restore ? save : (i == 0) ? alloc->live_in[0] & allocated : 0;
+
+        for (int slot = 0; no_err && slot < REGALLOC_SLOTS; ++slot)
+        {
+            if (!(load & slot_bit(slot))) continue;
+
+            no_err = asm_list_push_local(&out, "push", slot)                             != nullptr &&
+                     asm_list_push_cmd  (&out, "pop" , REGALLOC_REGS[alloc->reg[slot]]) != nullptr;
+        }
+    }
+
+    if (!no_err)
+    {
+        log_free(out.line);
+        return false;
+    }
+
+    out.text   = code->text;
+    code->text = nullptr;
+
+    asm_list_dtor(code);
+    *code = out;
+
+    return true;
+}
+
+slot_set slot_bit(const int slot)
+{
+    assert(0 <= slot && slot < REGALLOC_SLOTS);
+
+    return 1ull << slot;
+}
+
+//===========================================================================================================================
+// CTOR_DTOR
+//===========================================================================================================================
+
+bool regalloc_ctor(regalloc *const alloc, asm_list *const code)
+{
+    assert(alloc != nullptr);
+    assert(code  != nullptr);
+
+    const size_t size = (size_t) code->size + 1;
+
+    alloc->code     = code;
+    alloc->succ     = (int      *) log_calloc(2 * size, sizeof(int));
+    alloc->weight   = (double   *) log_calloc(size, sizeof(double));
+    alloc->use      = (slot_set *) log_calloc(size, sizeof(slot_set));
+    alloc->def      = (slot_set *) log_calloc(size, sizeof(slot_set));
+    alloc->live_in  = (slot_set *) log_calloc(size, sizeof(slot_set));
+    alloc->live_out = (slot_set *) log_calloc(size, sizeof(slot_set));
+    alloc->saved    = (slot_set *) log_calloc(size, sizeof(slot_set));
+
+    for (int slot = 0; slot < REGALLOC_SLOTS; ++slot)
+    {
+        alloc->benefit  [slot] =  0;
+        alloc->interfere[slot] =  0;
+        alloc->reg      [slot] = -1;
+    }
+
+    if (alloc->succ    == nullptr || alloc->weight   == nullptr || alloc->use   == nullptr || alloc->def == nullptr ||
+        alloc->live_in == nullptr || alloc->live_out == nullptr || alloc->saved == nullptr)
+    {
+        log_error("can't allocate memory for register allocation(%d)\n", __LINE__);
+        regalloc_dtor(alloc);
+        return false;
+    }
+    return true;
+}
+
+void regalloc_dtor(regalloc *const alloc)
+{
+    assert(alloc != nullptr);
+
+    log_free(alloc->succ);
+    log_free(alloc->weight);
+    log_free(alloc->use);
+    log_free(alloc->def);
+    log_free(alloc->live_in);
+    log_free(alloc->live_out);
+    log_free(alloc->saved);
+
+    *alloc = {};
+}
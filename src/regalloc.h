@@ -0,0 +1,62 @@
+#ifndef REGALLOC
+#define REGALLOC
+
+#include "asm_list.h"
+
+//===========================================================================================================================
+// CONST
+//===========================================================================================================================
+
+typedef unsigned long long slot_set;                // множество ячеек кадра [rex+0] .. [rex+63]
+
+const int    REGALLOC_SLOTS         = 64;           // ячейки с большим номером остаются в RAM
+const int    REGALLOC_REG_NUMBER    = 4;
+const double REGALLOC_LOOP_WEIGHT   = 10;           // во сколько раз инструкция цикла исполняется чаще охватывающего кода
+const double REGALLOC_ACCESS_GAIN   = 0.5;          // выигрыш от обращения к регистру вместо RAM (в инструкциях)
+const double REGALLOC_SAVE_COST     = 4;            // сохранение и восстановление регистра вокруг call
+const double REGALLOC_LOAD_COST     = 2;            // загрузка параметра в регистр в начале функции
+
+static const char *const REGALLOC_REGS[] = {"rax", "rbx", "rcx", "rdx"};    // регистры для локальных переменных
+
+//===========================================================================================================================
+// STRUCT
+//===========================================================================================================================
+
+struct regalloc                 // распределение регистров в функции
+{
+    asm_list  *code;
+
+    int       *succ;            // succ[2*i], succ[2*i + 1] - строки, на которые передается управление после строки i (-1, если нет)
+    double    *weight;          // оценка количества исполнений строки
+    slot_set  *use;             // ячейки, читаемые строкой
+    slot_set  *def;             // ячейки, записываемые строкой
+    slot_set  *live_in;         // ячейки, значения которых понадобятся до и после строки
+    slot_set  *live_out;
+    slot_set  *saved;           // saved[i] для "subi rex, shift" - ячейки, сохраняемые вокруг этого вызова
+
+    double     benefit  [REGALLOC_SLOTS];   // выигрыш от размещения ячейки в регистре
+    slot_set   interfere[REGALLOC_SLOTS];   // ячейки, одновременно живые с данной
+    int        reg      [REGALLOC_SLOTS];   // индекс в REGALLOC_REGS или -1
+};
+
+//===========================================================================================================================
+// REGALLOC
+//===========================================================================================================================
+
+bool regalloc_function      (asm_list *const code);
+bool regalloc_cfg           (regalloc *const alloc);
+void regalloc_liveness      (regalloc *const alloc);
+void regalloc_calls         (regalloc *const alloc);
+void regalloc_choose        (regalloc *const alloc);
+bool regalloc_rewrite       (regalloc *const alloc);
+
+slot_set slot_bit           (const int slot);
+
+//===========================================================================================================================
+// CTOR_DTOR
+//===========================================================================================================================
+
+bool regalloc_ctor (regalloc *const alloc, asm_list *const code);
+void regalloc_dtor (regalloc *const alloc);
+
+#endif //REGALLOC